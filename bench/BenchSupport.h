@@ -0,0 +1,118 @@
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include "Date.h"
+
+/*
+ * BenchSupport.h
+ * Shared by the bench/bench_*.cpp programs: a best-of-N timer and a
+ * generator for synthetic books.csv, users.csv and records.csv files.
+ *
+ * The data is deterministic (fixed seed), so runs on the same sizes read the
+ * same files. Generated files are kept in build/bench-data/<sizes>/ and
+ * reused by later runs.
+ */
+
+// Best wall time of runs calls to f, in milliseconds
+template <typename F>
+double bestOfMs(int runs, F f) {
+    double best = 1e300;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+// Size argument i of argv, or fallback
+inline std::size_t sizeArg(int argc, char* argv[], int i, std::size_t fallback) {
+    return argc > i ? static_cast<std::size_t>(std::strtoull(argv[i], nullptr, 10)) : fallback;
+}
+
+struct BenchData {
+    std::size_t books, users, records;
+    std::string dir;
+
+    std::string booksFile() const { return dir + "/books.csv"; }
+    std::string usersFile() const { return dir + "/users.csv"; }
+    std::string recordsFile() const { return dir + "/records.csv"; }
+};
+
+inline const char* benchWord(std::mt19937& rng) {
+    static const char* words[] = { "the", "river", "night", "glass", "garden", "winter", "house", "stone",
+                                   "song", "of", "a", "dark", "light", "city", "war", "peace", "love",
+                                   "time", "sea", "king", "letters", "blue", "empire", "silent", "road" };
+    return words[rng() % (sizeof(words) / sizeof(words[0]))];
+}
+
+inline std::string benchDate(DayNumber day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    char text[40];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", y, m, d);
+    return text;
+}
+
+// Writes the three CSV files, unless a previous run already did. Records
+// borrow random books for random users over 2023-2024; loans due before
+// 2024-10-01 are returned, so about a tenth of the records are still open.
+inline BenchData benchData(std::size_t books, std::size_t users, std::size_t records) {
+    BenchData data{ books, users, records,
+                    "build/bench-data/" + std::to_string(books) + "-" + std::to_string(users) + "-" +
+                        std::to_string(records) };
+    if (std::filesystem::exists(data.recordsFile()))
+        return data;
+    std::filesystem::create_directories(data.dir);
+
+    std::mt19937 rng(42);
+    {
+        std::ofstream out(data.booksFile());
+        for (std::size_t i = 0; i < books; i++) {
+            out << "978" << i << ',';
+            for (int w = 2 + static_cast<int>(rng() % 5); w > 0; w--)
+                out << benchWord(rng) << (w > 1 ? " " : "");
+            int copies = 1 + static_cast<int>(rng() % 5);
+            out << ",Author " << rng() % 50000 << ',' << 1900 + rng() % 125 << ',' << copies << ',' << copies
+                << '\n';
+        }
+    }
+    {
+        std::ofstream out(data.usersFile());
+        for (std::size_t i = 0; i < users; i++) {
+            if (i % 4 == 3)
+                out << "TEACHER,T" << i << ",Teacher " << i << ",Dept " << rng() % 40 << ",0\n";
+            else
+                out << "STUDENT,S" << i << ",Student " << i << ",Major " << rng() % 60 << ",0\n";
+        }
+    }
+    {
+        std::ofstream out(data.recordsFile());
+        const DayNumber first = daysFromCivil(2023, 1, 1);
+        const DayNumber cutoff = daysFromCivil(2024, 10, 1);
+        for (std::size_t i = 0; i < records; i++) {
+            std::size_t u = rng() % users;
+            DayNumber borrowed = first + static_cast<DayNumber>(rng() % 700);
+            DayNumber due = borrowed + 14;
+            out << "REC" << i + 1 << ',' << (u % 4 == 3 ? "T" : "S") << u << ",978" << rng() % books << ','
+                << benchDate(borrowed) << ',' << benchDate(due);
+            if (due < cutoff)
+                out << ",RETURNED," << benchDate(due - 3 + static_cast<DayNumber>(rng() % 7)) << '\n';
+            else
+                out << ",NOT_RETURNED\n";
+        }
+    }
+    return data;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#include "BenchSupport.h"
+#include "Book.h"
+#include "Library.h"
+#include "MappedFile.h"
+#include "User.h"
+#include <iostream>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * bench_arena.cpp
+ * Load time and peak RSS of books.csv and users.csv parsed into Book and
+ * UserVariant tables with their text in a StringArena (as loadBooks and
+ * loadUsers do), against the same tables with every title, author, name,
+ * major and department in its own heap block (ArenaString's owned mode,
+ * one allocation per string, like the std::string fields it replaced).
+ * The full Library load is shown for reference.
+ *
+ * Peak RSS only ever grows within a process, so each load runs in a forked
+ * child; the figure is the child's growth over its RSS at the fork. Best of
+ * 3 children for each.
+ *
+ *   build/bench/bench_arena [books users records]   (default 1000000 1000000 1000)
+ */
+
+struct LoadResult {
+    double ms;
+    long peakKB;
+    std::uint64_t check;
+};
+
+static long maxRssKB() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Runs load() in a child process, returns its time, peak RSS growth and result
+template <typename F>
+static LoadResult inChild(F load) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return LoadResult{ 0, 0, 0 };
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        long before = maxRssKB();
+        LoadResult r{ 0, 0, 0 };
+        r.ms = bestOfMs(1, [&] { r.check = load(); });
+        r.peakKB = maxRssKB() - before;
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == sizeof(r) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    LoadResult r{ 0, 0, 0 };
+    if (read(fds[0], &r, sizeof(r)) != sizeof(r))
+        std::cerr << "child failed\n";
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return r;
+}
+
+template <typename F>
+static LoadResult bestChild(F load) {
+    LoadResult best = inChild(load);
+    for (int i = 1; i < 3; i++) {
+        LoadResult r = inChild(load);
+        best.ms = std::min(best.ms, r.ms);
+        best.peakKB = std::min(best.peakKB, r.peakKB);
+    }
+    return best;
+}
+
+// Parses both files, arena is nullptr for owned text. The result sums the text
+// lengths so both modes can be checked against each other.
+static std::uint64_t loadTables(const BenchData& data, bool useArena) {
+    StringArena bookText, userText;
+    std::vector<Book> books;
+    std::vector<UserVariant> users;
+    std::uint64_t check = 0;
+
+    MappedFile file;
+    std::string_view line;
+    if (file.open(data.booksFile())) {
+        while (file.nextLine(line)) {
+            Book b;
+            if (Book::parseCSV(line, b, useArena ? &bookText : nullptr).ok()) {
+                check += b.getTitle().size() + b.getAuthor().size();
+                books.push_back(std::move(b));
+            }
+        }
+    }
+    MappedFile userFile;
+    if (userFile.open(data.usersFile())) {
+        while (userFile.nextLine(line)) {
+            UserVariant u;
+            if (User::parseCSV(line, u, useArena ? &userText : nullptr).ok()) {
+                check += userOf(u).getName().size();
+                users.push_back(std::move(u));
+            }
+        }
+    }
+    return check;
+}
+
+static void report(const char* what, const LoadResult& r) {
+    std::printf("%-22s %8.1f ms  peak RSS +%7.1f MB\n", what, r.ms, r.peakKB / 1024.0);
+}
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(sizeArg(argc, argv, 1, 1000000), sizeArg(argc, argv, 2, 1000000),
+                               sizeArg(argc, argv, 3, 1000));
+    std::cout << data.books << " books, " << data.users << " users; best of 3 child processes\n";
+
+    LoadResult owned = bestChild([&] { return loadTables(data, false); });
+    LoadResult arena = bestChild([&] { return loadTables(data, true); });
+    LoadResult library = bestChild([&] {
+        Library lib;
+        lib.loadBooks(data.booksFile());
+        lib.loadUsers(data.usersFile());
+        lib.loadRecords(data.recordsFile(), 1);
+        return std::uint64_t(lib.getTotalBooks() + lib.getTotalUsers());
+    });
+
+    report("owned strings", owned);
+    report("arena", arena);
+    report("Library load (arena)", library);
+    if (owned.check != arena.check) {
+        std::cerr << "text lengths differ between the two loads\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "BenchSupport.h"
+#include "Book.h"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * bench_book_counters.cpp
+ * Book's lock-free copy counts (one compare-and-swap per borrow or return)
+ * against the check-then-change they replaced, guarded by a std::mutex per
+ * book. Every thread runs borrowOne + returnOne pairs, first all on one hot
+ * title, then each on a title of its own. Best of 5 runs.
+ *
+ *   build/bench/bench_book_counters [maxThreads pairs]   (default 16 1000000)
+ */
+
+// The baseline: both counts behind one mutex, checked and changed under it
+struct LockedCounts {
+    std::mutex lock;
+    unsigned total, available;
+
+    explicit LockedCounts(unsigned copies) : lock(), total(copies), available(copies) {}
+
+    bool borrowOne() {
+        std::lock_guard guard(lock);
+        if (available == 0)
+            return false;
+        --available;
+        return true;
+    }
+
+    bool returnOne() {
+        std::lock_guard guard(lock);
+        if (available >= total)
+            return false;
+        ++available;
+        return true;
+    }
+};
+
+// Thread t runs pairs borrow + return pairs on *titles[t % titles.size()]
+template <typename Title>
+static double runPairs(const std::vector<std::unique_ptr<Title>>& titles, std::size_t threads, std::size_t pairs) {
+    return bestOfMs(5, [&] {
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; t++) {
+            Title& title = *titles[t % titles.size()];
+            workers.emplace_back([&title, pairs] {
+                for (std::size_t i = 0; i < pairs; i++) {
+                    if (title.borrowOne())
+                        title.returnOne();
+                }
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+    });
+}
+
+// One title per thread when own is set, else one title for all of them. Each
+// title has a copy per thread using it, so no borrow ever finds the shelf empty.
+static void compare(std::size_t threads, std::size_t pairs, bool own) {
+    const std::size_t count = own ? threads : 1;
+    const unsigned copies = static_cast<unsigned>(own ? 1 : threads);
+
+    std::vector<std::unique_ptr<Book>> books;
+    std::vector<std::unique_ptr<LockedCounts>> locked;
+    for (std::size_t i = 0; i < count; i++) {
+        books.push_back(std::make_unique<Book>("978" + std::to_string(i), "Title", "Author", 2000, copies));
+        locked.push_back(std::make_unique<LockedCounts>(copies));
+    }
+
+    double cas = runPairs(books, threads, pairs);
+    double mutex = runPairs(locked, threads, pairs);
+    std::printf("  %2zu threads: CAS %8.1f ms  mutex %8.1f ms\n", threads, cas, mutex);
+
+    for (const auto& b : books) {
+        if (b->getCopiesAvailable() != b->getCopiesTotal())
+            std::cerr << "copies still out on " << b->getISBN() << '\n';
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t maxThreads = sizeArg(argc, argv, 1, 16);
+    const std::size_t pairs = sizeArg(argc, argv, 2, 1000000);
+
+    std::cout << pairs << " borrow+return pairs per thread, " << std::thread::hardware_concurrency() << " core(s)\n";
+    for (bool own : { false, true }) {
+        std::cout << (own ? "one title per thread\n" : "one hot title\n");
+        for (std::size_t threads = 1; threads <= maxThreads; threads *= 2)
+            compare(threads, pairs, own);
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include "BenchSupport.h"
+#include "Book.h"
+#include "BorrowRecord.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+/*
+ * bench_csv_codec.cpp
+ * Row throughput of the CSV codec (from_chars parsing, to_chars into a stack
+ * buffer) against the getline + stringstream code it replaced, for books.csv
+ * and records.csv rows already in memory. Both sides build the same values;
+ * the parsed totals and the formatted bytes are compared. Best of 3 runs.
+ *
+ *   build/bench/bench_csv_codec [books records]   (default 200000 2000000)
+ */
+
+static std::vector<std::string> readRows(const std::string& filename) {
+    std::ifstream in(filename);
+    std::vector<std::string> rows;
+    std::string line;
+    while (std::getline(in, line))
+        rows.push_back(line);
+    return rows;
+}
+
+static std::size_t totalBytes(const std::vector<std::string>& rows) {
+    std::size_t n = 0;
+    for (const auto& r : rows)
+        n += r.size() + 1;
+    return n;
+}
+
+// The baselines: split on commas with getline, convert with stream extraction
+static std::uint64_t parseBooksWithStreams(const std::vector<std::string>& rows) {
+    std::uint64_t sum = 0;
+    for (const auto& line : rows) {
+        std::stringstream ss(line);
+        std::string isbn, title, author, field;
+        unsigned int year = 0, total = 0, available = 0;
+        std::getline(ss, isbn, ',');
+        std::getline(ss, title, ',');
+        std::getline(ss, author, ',');
+        std::getline(ss, field, ',');
+        std::stringstream(field) >> year;
+        std::getline(ss, field, ',');
+        std::stringstream(field) >> total;
+        std::getline(ss, field, ',');
+        std::stringstream(field) >> available;
+        Book b(isbn, title, author, year, total, available);
+        sum += b.getYear() + b.getCopiesTotal() + b.getCopiesAvailable();
+    }
+    return sum;
+}
+
+static DayNumber streamDate(const std::string& text) {
+    std::stringstream ss(text);
+    int y = 0, m = 0, d = 0;
+    char dash;
+    ss >> y >> dash >> m >> dash >> d;
+    return daysFromCivil(y, m, d);
+}
+
+static std::uint64_t parseRecordsWithStreams(const std::vector<std::string>& rows) {
+    std::uint64_t sum = 0;
+    for (const auto& line : rows) {
+        std::stringstream ss(line);
+        std::string id, user, isbn, borrowed, due, status, returned;
+        std::getline(ss, id, ',');
+        std::getline(ss, user, ',');
+        std::getline(ss, isbn, ',');
+        std::getline(ss, borrowed, ',');
+        std::getline(ss, due, ',');
+        std::getline(ss, status, ',');
+        std::uint64_t recordID = std::stoull(id.substr(3));
+        DayNumber dueDay = streamDate(due);
+        DayNumber returnDay = 0;
+        if (status == "RETURNED") {
+            std::getline(ss, returned, ',');
+            returnDay = streamDate(returned);
+        }
+        sum += recordID + static_cast<std::uint64_t>(streamDate(borrowed) + dueDay + returnDay) + user.size() + isbn.size();
+    }
+    return sum;
+}
+
+static std::uint64_t parseBooksWithCodec(const std::vector<std::string>& rows) {
+    std::uint64_t sum = 0;
+    Book b;
+    for (const auto& line : rows) {
+        if (Book::parseCSV(line, b).ok())
+            sum += b.getYear() + b.getCopiesTotal() + b.getCopiesAvailable();
+    }
+    return sum;
+}
+
+static std::uint64_t parseRecordsWithCodec(const std::vector<std::string>& rows) {
+    std::uint64_t sum = 0;
+    StagedBorrowRecord r;
+    for (const auto& line : rows) {
+        if (!BorrowRecord::parseCSV(line, r).ok())
+            continue;
+        DayNumber returnDay = r.isReturned() ? r.getReturnDay() : 0;
+        sum += r.getRecordID() + static_cast<std::uint64_t>(r.getBorrowedDay() + r.getDueDay() + returnDay) +
+               r.userText.size() + r.isbnText.size();
+    }
+    return sum;
+}
+
+// Formatting: the old stream output (no zero padding) against writeCSV
+static void streamDay(std::ostream& out, DayNumber day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    out << y << '-' << m << '-' << d;
+}
+
+static std::string formatRecordsWithStreams(const std::vector<BorrowRecord>& records, const RecordSymbols& symbols) {
+    std::ostringstream out;
+    for (const auto& r : records) {
+        out << "REC" << r.getRecordID() << ',' << r.getUserID(symbols) << ',' << r.getISBN(symbols) << ',';
+        streamDay(out, r.getBorrowedDay());
+        out << ',';
+        streamDay(out, r.getDueDay());
+        if (r.isReturned()) {
+            out << ",RETURNED,";
+            streamDay(out, r.getReturnDay());
+        }
+        else {
+            out << ",NOT_RETURNED";
+        }
+        out << '\n';
+    }
+    return out.str();
+}
+
+static std::string formatRecordsWithCodec(const std::vector<BorrowRecord>& records, const RecordSymbols& symbols) {
+    std::string text;
+    char buf[256];
+    for (const auto& r : records) {
+        std::size_t n = r.writeCSV(symbols, buf, buf + sizeof(buf) - 1);
+        buf[n] = '\n';
+        text.append(buf, n + 1);
+    }
+    return text;
+}
+
+static void report(const char* what, std::size_t bytes, double streams, double codec, bool same) {
+    std::printf("%-16s streams %8.1f ms  codec %8.1f ms  (%.0f vs %.0f MB/s, %.1fx)%s\n", what, streams, codec,
+                bytes / streams / 1e3, bytes / codec / 1e3, streams / codec, same ? "" : "  (results differ!)");
+}
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(sizeArg(argc, argv, 1, 200000), 1000, sizeArg(argc, argv, 2, 2000000));
+    std::vector<std::string> bookRows = readRows(data.booksFile());
+    std::vector<std::string> recordRows = readRows(data.recordsFile());
+    std::cout << bookRows.size() << " book rows, " << recordRows.size() << " record rows; best of 3\n";
+
+    bool allSame = true;
+    std::uint64_t a = 0, b = 0;
+    double streams = bestOfMs(3, [&] { a = parseBooksWithStreams(bookRows); });
+    double codec = bestOfMs(3, [&] { b = parseBooksWithCodec(bookRows); });
+    report("parse books", totalBytes(bookRows), streams, codec, a == b);
+    allSame &= a == b;
+
+    streams = bestOfMs(3, [&] { a = parseRecordsWithStreams(recordRows); });
+    codec = bestOfMs(3, [&] { b = parseRecordsWithCodec(recordRows); });
+    report("parse records", totalBytes(recordRows), streams, codec, a == b);
+    allSame &= a == b;
+
+    RecordSymbols symbols;
+    std::vector<BorrowRecord> records;
+    records.reserve(recordRows.size());
+    for (const auto& line : recordRows) {
+        BorrowRecord r;
+        if (BorrowRecord::parseCSV(line, symbols, r).ok())
+            records.push_back(r);
+    }
+    std::string x, y;
+    streams = bestOfMs(3, [&] { x = formatRecordsWithStreams(records, symbols); });
+    codec = bestOfMs(3, [&] { y = formatRecordsWithCodec(records, symbols); });
+    report("format records", x.size(), streams, codec, x == y);
+    allSame &= x == y;
+
+    return allSame ? 0 : 1;
+}
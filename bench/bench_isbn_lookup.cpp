@@ -0,0 +1,77 @@
+#include "BenchSupport.h"
+#include "Library.h"
+#include <iostream>
+#include <vector>
+
+/*
+ * bench_isbn_lookup.cpp
+ * Cost of one ISBN lookup (Library::getAvailableCopies, through the ISBN ->
+ * slot hash index) as the catalog grows tenfold at a time, against the
+ * linear walk over a vector<Book> it replaced. Half the lookups are for
+ * ISBNs in the catalog, half for ones that aren't. The walk only runs up to
+ * maxScan books, past that a single pass takes too long. Best of 3 runs.
+ * The index stays within a small factor across the sizes (what it gains is
+ * cache misses once the table outgrows the cache); the walk grows with the
+ * catalog.
+ *
+ *   build/bench/bench_isbn_lookup [maxBooks lookups maxScan]   (default 1000000 200000 100000)
+ */
+
+static std::string isbnOf(std::size_t i) { return "978" + std::to_string(i); }
+
+// The baseline: the first book with a matching ISBN
+static int scanCopies(const std::vector<Book>& books, const std::string& isbn) {
+    for (const auto& b : books) {
+        if (b.getISBN() == isbn)
+            return static_cast<int>(b.getCopiesAvailable());
+    }
+    return -1;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t maxBooks = sizeArg(argc, argv, 1, 1000000);
+    const std::size_t lookups = sizeArg(argc, argv, 2, 200000);
+    const std::size_t maxScan = sizeArg(argc, argv, 3, 100000);
+
+    std::cout << lookups << " lookups per size, ns per lookup, best of 3\n";
+    for (std::size_t size = 1000; size <= maxBooks; size *= 10) {
+        std::vector<Book> books;
+        books.reserve(size);
+        for (std::size_t i = 0; i < size; i++)
+            books.emplace_back(isbnOf(i), "Title", "Author", 2000, 1 + i % 3);
+
+        Library lib;
+        lib.addBooks(books);
+
+        // Every other key is a miss (an index past the catalog)
+        std::mt19937 rng(1);
+        std::vector<std::string> keys;
+        keys.reserve(lookups);
+        for (std::size_t i = 0; i < lookups; i++)
+            keys.push_back(isbnOf(rng() % size + (i % 2 ? size : 0)));
+
+        long hashed = 0;
+        double hashMs = bestOfMs(3, [&] {
+            for (const auto& k : keys)
+                hashed += lib.getAvailableCopies(k);
+        });
+        std::printf("  %8zu books: index %7.1f ns", size, hashMs * 1e6 / lookups);
+
+        if (size <= maxScan) {
+            // Fewer lookups for the walk, scaled so each size takes about as long
+            const std::size_t scanned = std::max<std::size_t>(100, lookups * 1000 / size / 10);
+            long expected = 0, scannedSum = 0;
+            for (std::size_t i = 0; i < scanned; i++)
+                expected += lib.getAvailableCopies(keys[i]);
+            double scanMs = bestOfMs(3, [&] {
+                scannedSum = 0;
+                for (std::size_t i = 0; i < scanned; i++)
+                    scannedSum += scanCopies(books, keys[i]);
+            });
+            std::printf("  linear scan %11.1f ns%s", scanMs * 1e6 / scanned,
+                        scannedSum == expected ? "" : "  (results differ!)");
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "BenchSupport.h"
+#include "Library.h"
+#include <iostream>
+
+/*
+ * bench_late_fees.cpp
+ * Projected late fees: the pass over the open loan columns against the
+ * per-record reference scan, on the same loaded library. Exits with 1 if
+ * any user's fee differs between the two.
+ *
+ *   build/bench/bench_late_fees [books users records]   (default 200000 200000 2000000)
+ */
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(sizeArg(argc, argv, 1, 200000), sizeArg(argc, argv, 2, 200000),
+                               sizeArg(argc, argv, 3, 2000000));
+    Library lib;
+    lib.loadBooks(data.booksFile());
+    lib.loadUsers(data.usersFile());
+    lib.loadRecords(data.recordsFile());
+
+    const DayNumber asOf = daysFromCivil(2025, 1, 1);
+    std::vector<std::pair<std::string, double>> columns, reference;
+    double fast = bestOfMs(5, [&] { columns = lib.projectLateFees(asOf, 0.25); });
+    double slow = bestOfMs(5, [&] { reference = lib.projectLateFeesReference(asOf, 0.25); });
+
+    // Fees are whole multiples of 0.25, so both passes must give exactly the same values
+    std::cout << data.records << " records, " << lib.getBorrowedCount() << " open loans, " << columns.size()
+              << " users owing; best of 5, ms\n";
+    std::cout << "columns " << fast << "  reference " << slow
+              << (columns == reference ? "" : "  (results differ!)") << '\n';
+    return columns == reference ? 0 : 1;
+}
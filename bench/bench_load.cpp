@@ -0,0 +1,66 @@
+#include "BenchSupport.h"
+#include "CsvCodec.h"
+#include "Library.h"
+#include "MappedFile.h"
+#include <iostream>
+#include <sstream>
+
+/*
+ * bench_load.cpp
+ * CSV load times: how the loaders read records.csv (mmap + string_view
+ * fields) against the getline + stringstream splitting they replaced, and
+ * the full Library loads.
+ *
+ *   build/bench/bench_load [books users records]   (default 200000 200000 2000000)
+ */
+
+// Field splitting the way the loaders did it before MappedFile/CsvCursor
+static std::size_t splitWithStreams(const std::string& filename) {
+    std::ifstream in(filename);
+    std::string line, field;
+    std::size_t fields = 0;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        while (std::getline(ss, field, ','))
+            fields += !field.empty();
+    }
+    return fields;
+}
+
+static std::size_t splitMapped(const std::string& filename) {
+    MappedFile file;
+    file.open(filename);
+    std::string_view line;
+    std::size_t fields = 0;
+    while (file.nextLine(line)) {
+        CsvCursor cursor(line);
+        std::string_view field;
+        while (cursor.next(field))
+            fields += !field.empty();
+    }
+    return fields;
+}
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(sizeArg(argc, argv, 1, 200000), sizeArg(argc, argv, 2, 200000),
+                               sizeArg(argc, argv, 3, 2000000));
+    std::cout << data.books << " books, " << data.users << " users, " << data.records
+              << " records; best of 3, ms\n";
+
+    std::size_t a = 0, b = 0;
+    double streams = bestOfMs(3, [&] { a = splitWithStreams(data.recordsFile()); });
+    double mapped = bestOfMs(3, [&] { b = splitMapped(data.recordsFile()); });
+    std::cout << "split records.csv  getline+stringstream " << streams << "  mmap+CsvCursor " << mapped
+              << (a == b ? "" : "  (field counts differ!)") << '\n';
+
+    double books = bestOfMs(3, [&] { Library lib; lib.loadBooks(data.booksFile()); });
+    double users = bestOfMs(3, [&] { Library lib; lib.loadUsers(data.usersFile()); });
+    double records = bestOfMs(3, [&] {
+        Library lib;
+        lib.loadUsers(data.usersFile());
+        lib.loadRecords(data.recordsFile(), 1);
+    }) - users;
+    std::cout << "loadBooks " << books << "  loadUsers " << users << "  loadRecords (1 thread) " << records
+              << "  total " << books + users + records << '\n';
+    return 0;
+}
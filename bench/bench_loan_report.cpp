@@ -0,0 +1,124 @@
+#include "BenchSupport.h"
+#include "Library.h"
+#include "LoanReport.h"
+#include "MappedFile.h"
+#include <iostream>
+#include <vector>
+
+/*
+ * bench_loan_report.cpp
+ * Group-by passes over the borrow history: aggregateLoans() on the RecordLog's
+ * integer columns against the same pass over 32-byte rows holding the same
+ * fields (the layout of a BorrowRecord, which reports scanned before the
+ * columns came back). Every key and measure is run on both and the totals
+ * are compared. Then the full Library::loanReport calls, labels included.
+ * Best of 3 runs.
+ *
+ *   build/bench/bench_loan_report [books users records]   (default 200000 200000 2000000)
+ */
+
+// One record as a report saw it in the record array
+struct Row {
+    std::uint64_t id;
+    std::uint32_t user, book;
+    DayNumber borrowed, due, returned;
+    std::uint32_t pad;
+};
+static_assert(sizeof(Row) == sizeof(BorrowRecord), "rows are the size of a record");
+
+static std::uint32_t monthOf(DayNumber day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    return static_cast<std::uint32_t>(y * 12 + m - 1);
+}
+
+// The baseline pass, same rules as aggregateLoans
+static void aggregateRows(const std::vector<Row>& rows, LoanKey key, LoanMeasure measure, GroupTotals& totals) {
+    for (const Row& r : rows) {
+        std::uint32_t g = key == LoanKey::USER ? r.user : key == LoanKey::BOOK ? r.book : monthOf(r.borrowed);
+        if (measure == LoanMeasure::LOANS) {
+            totals.count[g]++;
+            continue;
+        }
+        if (r.returned == BorrowRecord::NOT_RETURNED)
+            continue;
+        totals.count[g]++;
+        if (measure == LoanMeasure::DAYS_OUT)
+            totals.sum[g] += r.returned - r.borrowed;
+        else
+            totals.sum[g] += r.returned > r.due ? r.returned - r.due : 0;
+    }
+}
+
+static GroupTotals emptyTotals(std::size_t groups) {
+    GroupTotals t;
+    t.count.assign(groups, 0);
+    t.sum.assign(groups, 0);
+    return t;
+}
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(sizeArg(argc, argv, 1, 200000), sizeArg(argc, argv, 2, 200000),
+                               sizeArg(argc, argv, 3, 2000000));
+
+    RecordSymbols symbols;
+    RecordLog log;
+    std::vector<Row> rows;
+    {
+        MappedFile file;
+        file.open(data.recordsFile());
+        std::string_view line;
+        BorrowRecord rec;
+        while (file.nextLine(line)) {
+            if (!BorrowRecord::parseCSV(line, symbols, rec).ok())
+                continue;
+            log.append(rec);
+            rows.push_back(Row{ rec.getRecordID(), rec.getUserKey(), rec.getBookKey(), rec.getBorrowedDay(),
+                                rec.getDueDay(), rec.getReturnDay(), 0 });
+        }
+    }
+    std::cout << rows.size() << " records; best of 3, ms\n";
+
+    struct Key { LoanKey key; const char* name; std::size_t groups; };
+    const Key keys[] = { { LoanKey::USER, "user", symbols.userIDs.size() },
+                         { LoanKey::BOOK, "book", symbols.isbns.size() },
+                         { LoanKey::BORROW_MONTH, "month", MONTH_GROUPS } };
+    const std::pair<LoanMeasure, const char*> measures[] = {
+        { LoanMeasure::LOANS, "loans" }, { LoanMeasure::DAYS_OUT, "days out" }, { LoanMeasure::DAYS_LATE, "days late" } };
+
+    bool allSame = true;
+    for (const Key& k : keys) {
+        for (const auto& m : measures) {
+            GroupTotals columns = emptyTotals(k.groups), scanned = emptyTotals(k.groups);
+            double c = bestOfMs(3, [&] {
+                columns = emptyTotals(k.groups);
+                log.forEachColumnRun([&](const RecordLog::ColumnRun& run) {
+                    aggregateLoans(run, k.key, nullptr, m.first, columns);
+                });
+            });
+            double r = bestOfMs(3, [&] {
+                scanned = emptyTotals(k.groups);
+                aggregateRows(rows, k.key, m.first, scanned);
+            });
+            bool same = columns.count == scanned.count && columns.sum == scanned.sum;
+            allSame &= same;
+            std::printf("  by %-5s %-9s  columns %7.1f  rows %7.1f%s\n", k.name, m.second, c, r,
+                        same ? "" : "  (results differ!)");
+        }
+    }
+
+    Library lib;
+    lib.loadBooks(data.booksFile());
+    lib.loadUsers(data.usersFile());
+    lib.loadRecords(data.recordsFile(), 1);
+    const std::pair<LoanGroupBy, const char*> groupings[] = {
+        { LoanGroupBy::BORROW_MONTH, "month" }, { LoanGroupBy::USER_TYPE, "user type" },
+        { LoanGroupBy::USER, "user" }, { LoanGroupBy::ISBN, "ISBN" } };
+    std::cout << "Library::loanReport, days late\n";
+    for (const auto& g : groupings) {
+        std::size_t groups = 0;
+        double ms = bestOfMs(3, [&] { groups = lib.loanReport(g.first, LoanMeasure::DAYS_LATE).size(); });
+        std::printf("  by %-9s %7.1f  (%zu groups)\n", g.second, ms, groups);
+    }
+    return allSame ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+#include "BenchSupport.h"
+#include "Journal.h"
+#include "Library.h"
+#include <iostream>
+
+/*
+ * bench_remove.cpp
+ * removeBook end to end: ISBN index, key table, keyword and prefix indexes,
+ * slot map erase and the journal entry. Removes a random sample of the loaded
+ * books, first without a journal and then with one attached (group commit,
+ * one commit at the end), and reports the mean, the 99th percentile and the
+ * worst single remove. The worst case is the occasional prefix index merge or
+ * slot map compaction, which the mean already pays for.
+ *
+ *   build/bench/bench_remove [books removes]   (default 200000 20000)
+ */
+
+struct RemoveTimes {
+    double meanUs = 0, p99Us = 0, worstUs = 0;
+};
+
+static RemoveTimes removeSample(Library& lib, const std::vector<std::string>& isbns, Journal* journal) {
+    RemoveTimes t;
+    std::vector<double> times;
+    double total = 0;
+    for (const auto& isbn : isbns) {
+        auto start = std::chrono::steady_clock::now();
+        bool removed = lib.removeBook(isbn);
+        auto stop = std::chrono::steady_clock::now();
+        if (!removed)
+            std::cerr << "not removed: " << isbn << '\n';
+        double us = std::chrono::duration<double, std::micro>(stop - start).count();
+        total += us;
+        times.push_back(us);
+    }
+    if (journal)
+        journal->commit();
+    std::sort(times.begin(), times.end());
+    t.meanUs = total / static_cast<double>(times.size());
+    t.p99Us = times[times.size() * 99 / 100];
+    t.worstUs = times.back();
+    return t;
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t books = sizeArg(argc, argv, 1, 200000);
+    const std::size_t removes = std::min(sizeArg(argc, argv, 2, 20000), books);
+    BenchData data = benchData(books, 1000, 1000);
+
+    std::vector<std::string> isbns;
+    for (std::size_t i = 0; i < books; i++)
+        isbns.push_back("978" + std::to_string(i));
+    std::mt19937 rng(7);
+    std::shuffle(isbns.begin(), isbns.end(), rng);
+    isbns.resize(removes);
+
+    std::cout << books << " books, " << removes << " random removes\n";
+    {
+        Library lib;
+        lib.loadBooks(data.booksFile());
+        RemoveTimes t = removeSample(lib, isbns, nullptr);
+        std::cout << "no journal    mean " << t.meanUs << " us  p99 " << t.p99Us << " us  worst " << t.worstUs << " us\n";
+    }
+    {
+        std::string log = data.dir + "/bench_remove.log";
+        std::remove(log.c_str());
+        Journal journal;
+        journal.open(log);
+        Library lib;
+        lib.loadBooks(data.booksFile());
+        lib.attachJournal(&journal);
+        RemoveTimes t = removeSample(lib, isbns, &journal);
+        std::cout << "with journal  mean " << t.meanUs << " us  p99 " << t.p99Us << " us  worst " << t.worstUs << " us\n";
+        journal.close();
+        std::remove(log.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "BenchSupport.h"
+#include "Library.h"
+#include <iostream>
+#include <memory>
+
+/*
+ * bench_snapshot.cpp
+ * Startup time: loading books.csv, users.csv and records.csv (parsing every
+ * row, then building the ISBN, user, keyword and prefix indexes) against
+ * loading library.snap written from the same data (bulk copies of the
+ * columns and of the built indexes). Also the time to write the snapshot
+ * and its size. Both loads are checked against each other. Best of 3, each
+ * into a new Library.
+ *
+ *   build/bench/bench_snapshot [books users records]   (default 200000 200000 2000000)
+ */
+
+// What the two loads must agree on
+static std::vector<long> summaryOf(const Library& lib) {
+    LibraryStats s = lib.getStats();
+    return { lib.getTotalBooks(), lib.getTotalUsers(), s.openLoans, s.copiesOut, s.usersWithFees,
+             static_cast<long>(lib.searchBooksByKeywords("silent sea").size()),
+             static_cast<long>(lib.autocompleteBooks("the s", 50).size()),
+             static_cast<long>(lib.loanReport(LoanGroupBy::USER, LoanMeasure::LOANS).size()) };
+}
+
+// Best of 3 loads, each into a new Library; the last one is kept in lib
+template <typename F>
+static double bestLoadMs(std::unique_ptr<Library>& lib, F load) {
+    double best = 1e300;
+    for (int i = 0; i < 3; i++) {
+        lib.reset();
+        lib = std::make_unique<Library>();
+        best = std::min(best, bestOfMs(1, [&] { load(*lib); }));
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(sizeArg(argc, argv, 1, 200000), sizeArg(argc, argv, 2, 200000),
+                               sizeArg(argc, argv, 3, 2000000));
+    const std::string snapFile = data.dir + "/library.snap";
+    std::cout << data.books << " books, " << data.users << " users, " << data.records << " records; best of 3\n";
+
+    std::unique_ptr<Library> fromCSV;
+    double csvMs = bestLoadMs(fromCSV, [&](Library& lib) {
+        lib.loadBooks(data.booksFile());
+        lib.loadUsers(data.usersFile());
+        lib.loadRecords(data.recordsFile());
+    });
+
+    bool saved = false;
+    double saveMs = bestOfMs(3, [&] { saved = fromCSV->saveSnapshot(snapFile); });
+    if (!saved) {
+        std::cerr << "could not write " << snapFile << "\n";
+        return 1;
+    }
+
+    bool loaded = true;
+    std::unique_ptr<Library> fromSnapshot;
+    double snapMs = bestLoadMs(fromSnapshot, [&](Library& lib) { loaded &= lib.loadSnapshot(snapFile); });
+
+    std::printf("CSV load       %8.1f ms\n", csvMs);
+    std::printf("snapshot load  %8.1f ms  (%.1fx)\n", snapMs, csvMs / snapMs);
+    std::printf("snapshot save  %8.1f ms  (%.1f MB)\n", saveMs,
+                std::filesystem::file_size(snapFile) / (1024.0 * 1024.0));
+
+    if (!loaded || summaryOf(*fromCSV) != summaryOf(*fromSnapshot)) {
+        std::cerr << "the snapshot load differs from the CSV load\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "BenchSupport.h"
+#include "User.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/*
+ * bench_user_scan.cpp
+ * Whole-table user passes over the Library's layout, UserVariant values in
+ * one array with std::visit dispatch, against the vector<unique_ptr<User>>
+ * with virtual calls it replaced: summing fees, counting users per type and
+ * writing every CSV row. Both tables hold the same users.csv rows; the
+ * variant table keeps its text in an arena, as loadUsers does.
+ *
+ *   build/bench/bench_user_scan [users]   (default 1000000)
+ */
+
+int main(int argc, char* argv[]) {
+    BenchData data = benchData(1000, sizeArg(argc, argv, 1, 1000000), 1000);
+
+    StringArena arena;
+    std::vector<UserVariant> variants;
+    std::vector<std::unique_ptr<User>> pointers;
+    {
+        std::ifstream in(data.usersFile());
+        std::string line;
+        while (std::getline(in, line)) {
+            UserVariant v;
+            std::unique_ptr<User> p;
+            if (!User::parseCSV(line, v, &arena).ok() || !User::parseCSV(line, p).ok())
+                continue;
+            // Some fees, so the sum isn't all zeros
+            double fee = static_cast<double>(variants.size() % 7);
+            userOf(v).addFees(fee);
+            p->addFees(fee);
+            variants.push_back(std::move(v));
+            pointers.push_back(std::move(p));
+        }
+    }
+
+    double feesV = 0, feesP = 0;
+    std::size_t typesV[3] = {}, typesP[3] = {};
+    std::size_t bytesV = 0, bytesP = 0;
+    char buf[512];
+
+    double feeV = bestOfMs(7, [&] {
+        feesV = 0;
+        for (const auto& u : variants)
+            feesV += userOf(u).getFeesDue();
+    });
+    double feeP = bestOfMs(7, [&] {
+        feesP = 0;
+        for (const auto& u : pointers)
+            feesP += u->getFeesDue();
+    });
+    double typeV = bestOfMs(7, [&] {
+        std::fill(typesV, typesV + 3, 0);
+        for (const auto& u : variants)
+            typesV[static_cast<int>(userOf(u).getUserType())]++;
+    });
+    double typeP = bestOfMs(7, [&] {
+        std::fill(typesP, typesP + 3, 0);
+        for (const auto& u : pointers)
+            typesP[static_cast<int>(u->getUserType())]++;
+    });
+    double csvV = bestOfMs(7, [&] {
+        bytesV = 0;
+        for (const auto& u : variants)
+            bytesV += writeUserCSV(u, buf, buf + sizeof(buf));
+    });
+    double csvP = bestOfMs(7, [&] {
+        bytesP = 0;
+        for (const auto& u : pointers)
+            bytesP += u->writeCSV(buf, buf + sizeof(buf));
+    });
+
+    bool same = feesV == feesP && std::equal(typesV, typesV + 3, typesP) && bytesV == bytesP;
+    std::cout << variants.size() << " users, sizeof(UserVariant) " << sizeof(UserVariant)
+              << "; best of 7, ms, variant array / unique_ptr vector\n";
+    std::cout << "fee sum     " << feeV << " / " << feeP << '\n';
+    std::cout << "type count  " << typeV << " / " << typeP << '\n';
+    std::cout << "writeCSV    " << csvV << " / " << csvP << (same ? "" : "  (results differ!)") << '\n';
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include "BatchProcessor.h"
+#include "MappedFile.h"
+
+/*
+ * BatchProcessor.cpp
+ * Implements the BatchProcessor class declared in BatchProcessor.h.
+ *
+ * Fields are split in place with CsvCursor and numbers, dates and rows are
+ * parsed with the same codec as the data files, so a transaction line costs
+ * no more than loading a row.
+ */
+
+// Helper: parse the next field with parse(text), or record which field was bad.
+// Field numbers in the status count the transaction name as field 1.
+template <typename Parse>
+static bool takeField(CsvCursor& cursor, const char* name, CsvStatus& status, Parse parse) {
+    std::size_t index = cursor.fieldIndex();
+    std::string_view text;
+    CsvError err = cursor.next(text) ? parse(text) : CsvError::MISSING_FIELD;
+    if (err != CsvError::NONE)
+        status = CsvStatus{ err, index, name };
+    return err == CsvError::NONE;
+}
+
+// Helper: the line must end after the last field
+static bool noExtraFields(const CsvCursor& cursor, CsvStatus& status) {
+    if (cursor.atEnd())
+        return true;
+    status = CsvStatus{ CsvError::EXTRA_FIELDS, cursor.fieldIndex(), "" };
+    return false;
+}
+
+// Constructor
+BatchProcessor::BatchProcessor(Library& lib, std::ostream& out)
+    : lib(lib), out(out), succeeded(0), failed(0), current(Run::NONE) {}
+
+bool BatchProcessor::run(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename))
+        return false;
+
+    std::string_view line;
+    std::uint64_t lineNo = 0;
+    while (file.nextLine(line)) {
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+        runLine(lineNo, line);
+    }
+    flush();
+    return true;
+}
+
+std::size_t BatchProcessor::getSucceeded() const {
+    return succeeded;
+}
+
+std::size_t BatchProcessor::getFailed() const {
+    return failed;
+}
+
+// Dispatch on the transaction name
+void BatchProcessor::runLine(std::uint64_t lineNo, std::string_view line) {
+    CsvCursor cursor(line);
+    std::string_view op;
+    cursor.next(op);
+
+    std::size_t comma = line.find(',');
+    std::string_view rest = (comma == std::string_view::npos) ? std::string_view() : line.substr(comma + 1);
+
+    if (op == "BORROW")
+        borrow(lineNo, cursor);
+    else if (op == "RETURN")
+        giveBack(lineNo, cursor);
+    else if (op == "ADD_BOOK")
+        addBook(lineNo, rest);
+    else if (op == "ADD_USER")
+        addUser(lineNo, rest);
+    else if (op == "REMOVE_BOOK")
+        removeBook(lineNo, cursor);
+    else if (op == "REMOVE_USER")
+        removeUser(lineNo, cursor);
+    else {
+        flush();
+        reportError(lineNo, "unknown transaction " + std::string(op));
+    }
+}
+
+// BORROW,<userID>,<isbn>,<borrowed>,<due>
+void BatchProcessor::borrow(std::uint64_t lineNo, CsvCursor& cursor) {
+    std::string userID, isbn;
+    int by, bm, bd, dy, dm, dd;
+    CsvStatus status;
+
+    bool parsed =
+        takeField(cursor, "userID", status, [&](std::string_view t) { userID.assign(t); return CsvError::NONE; }) &&
+        takeField(cursor, "isbn", status, [&](std::string_view t) { isbn.assign(t); return CsvError::NONE; }) &&
+        takeField(cursor, "borrowed", status, [&](std::string_view t) { return BorrowRecord::parseDate(t, by, bm, bd); }) &&
+        takeField(cursor, "due", status, [&](std::string_view t) { return BorrowRecord::parseDate(t, dy, dm, dd); }) &&
+        noExtraFields(cursor, status);
+    if (!parsed) {
+        flush();
+        reportError(lineNo, status.describe());
+        return;
+    }
+
+    startItem(Run::BORROW, lineNo);
+    borrows.push_back(BorrowRequest{ std::move(userID), std::move(isbn), by, bm, bd, dy, dm, dd });
+}
+
+// RETURN,<recordID>,<returned>,<lateFeePerDay>
+void BatchProcessor::giveBack(std::uint64_t lineNo, CsvCursor& cursor) {
+    std::uint64_t recordID;
+    int ry, rm, rd;
+    double fee;
+    CsvStatus status;
+
+    bool parsed =
+        takeField(cursor, "recordID", status, [&](std::string_view t) {
+            return BorrowRecord::parseRecordID(t, recordID) ? CsvError::NONE : CsvError::BAD_VALUE;
+        }) &&
+        takeField(cursor, "returned", status, [&](std::string_view t) { return BorrowRecord::parseDate(t, ry, rm, rd); }) &&
+        takeField(cursor, "lateFeePerDay", status, [&](std::string_view t) { return CsvFormat<double>::parse(t, fee); }) &&
+        noExtraFields(cursor, status);
+    if (!parsed) {
+        flush();
+        reportError(lineNo, status.describe());
+        return;
+    }
+
+    startItem(Run::RETURN, lineNo);
+    returns.push_back(ReturnRequest{ recordID, ry, rm, rd, fee });
+}
+
+// ADD_BOOK,<book CSV row>
+void BatchProcessor::addBook(std::uint64_t lineNo, std::string_view row) {
+    Book b;
+    CsvStatus status = Book::parseCSV(row, b);
+    if (!status.ok()) {
+        flush();
+        status.field++; // count the transaction name
+        reportError(lineNo, status.describe());
+        return;
+    }
+
+    startItem(Run::ADD_BOOK, lineNo);
+    newBooks.push_back(std::move(b));
+}
+
+// ADD_USER,<user CSV row>
+void BatchProcessor::addUser(std::uint64_t lineNo, std::string_view row) {
+    std::unique_ptr<User> u;
+    CsvStatus status = User::parseCSV(row, u);
+    if (!status.ok()) {
+        flush();
+        status.field++;
+        reportError(lineNo, status.describe());
+        return;
+    }
+
+    startItem(Run::ADD_USER, lineNo);
+    newUsers.push_back(std::move(u));
+}
+
+// Helper: the single ID field of a REMOVE_* line
+static bool takeOnlyField(CsvCursor& cursor, const char* name, std::string& id, CsvStatus& status) {
+    return takeField(cursor, name, status, [&](std::string_view t) { id.assign(t); return CsvError::NONE; }) &&
+           noExtraFields(cursor, status);
+}
+
+// REMOVE_BOOK,<isbn>
+void BatchProcessor::removeBook(std::uint64_t lineNo, CsvCursor& cursor) {
+    flush();
+    std::string isbn;
+    CsvStatus status;
+    if (!takeOnlyField(cursor, "isbn", isbn, status)) {
+        reportError(lineNo, status.describe());
+        return;
+    }
+
+    if (lib.removeBook(isbn))
+        reportOK(lineNo);
+    else
+        reportFailed(lineNo, "unknown book");
+}
+
+// REMOVE_USER,<userID>
+void BatchProcessor::removeUser(std::uint64_t lineNo, CsvCursor& cursor) {
+    flush();
+    std::string userID;
+    CsvStatus status;
+    if (!takeOnlyField(cursor, "userID", userID, status)) {
+        reportError(lineNo, status.describe());
+        return;
+    }
+
+    if (lib.removeUser(userID))
+        reportOK(lineNo);
+    else if (lib.hasOpenLoans(userID))
+        reportFailed(lineNo, "user has books on loan");
+    else
+        reportFailed(lineNo, "unknown user");
+}
+
+// Runs
+// Adds an item to the current run, applying the previous run first if it is of another kind
+void BatchProcessor::startItem(Run kind, std::uint64_t lineNo) {
+    if (current != kind || runLines.size() >= MAX_RUN)
+        flush();
+    current = kind;
+    runLines.push_back(lineNo);
+}
+
+// Applies the collected run with one bulk call and reports every item
+void BatchProcessor::flush() {
+    std::vector<ChangeStatus> statuses;
+    std::vector<std::uint64_t> recordIDs;
+
+    switch (current) {
+        case Run::NONE:
+            return;
+        case Run::BORROW: statuses = lib.borrowMany(borrows, &recordIDs);
+            break;
+        case Run::RETURN: statuses = lib.returnMany(returns);
+            break;
+        case Run::ADD_BOOK: statuses = lib.addBooks(std::move(newBooks));
+            break;
+        case Run::ADD_USER: statuses = lib.addUsers(std::move(newUsers));
+            break;
+    }
+
+    for (std::size_t i = 0; i < statuses.size(); ++i) {
+        if (current == Run::BORROW && statuses[i] == ChangeStatus::OK) {
+            succeeded++;
+            out << runLines[i] << ",OK," << BorrowRecord::formatRecordID(recordIDs[i]) << '\n';
+        }
+        else
+            report(runLines[i], statuses[i], current);
+    }
+
+    current = Run::NONE;
+    runLines.clear();
+    borrows.clear();
+    returns.clear();
+    newBooks.clear();
+    newUsers.clear();
+}
+
+// Result lines
+void BatchProcessor::report(std::uint64_t lineNo, ChangeStatus status, Run kind) {
+    switch (status) {
+        case ChangeStatus::OK: reportOK(lineNo);
+            break;
+        case ChangeStatus::DUPLICATE: reportFailed(lineNo, kind == Run::ADD_BOOK ? "duplicate ISBN" : "duplicate user ID");
+            break;
+        case ChangeStatus::UNKNOWN_USER: reportFailed(lineNo, "unknown user");
+            break;
+        case ChangeStatus::UNKNOWN_BOOK: reportFailed(lineNo, "unknown book");
+            break;
+        case ChangeStatus::NO_COPIES: reportFailed(lineNo, "no copies available");
+            break;
+        case ChangeStatus::UNKNOWN_RECORD: reportFailed(lineNo, "unknown record");
+            break;
+        case ChangeStatus::ALREADY_RETURNED: reportFailed(lineNo, "already returned");
+            break;
+        case ChangeStatus::INVALID_DATE: reportFailed(lineNo, "invalid date");
+            break;
+    }
+}
+
+void BatchProcessor::reportOK(std::uint64_t lineNo) {
+    succeeded++;
+    out << lineNo << ",OK\n";
+}
+
+void BatchProcessor::reportFailed(std::uint64_t lineNo, const char* reason) {
+    failed++;
+    out << lineNo << ",FAILED," << reason << '\n';
+}
+
+void BatchProcessor::reportError(std::uint64_t lineNo, const std::string& problem) {
+    failed++;
+    out << lineNo << ",ERROR," << problem << '\n';
+}
\ No newline at end of file
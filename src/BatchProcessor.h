@@ -0,0 +1,83 @@
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include <string>
+#include <string_view>
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "Library.h"
+#include "CsvCodec.h"
+
+/*
+ * BatchProcessor.h
+ * Declares the BatchProcessor class, which applies a file of transactions to a
+ * Library without the interactive menu (./library --batch <file>).
+ *
+ * One transaction per line, fields separated by commas:
+ *  - BORROW,<userID>,<isbn>,<borrowed YYYY-MM-DD>,<due YYYY-MM-DD>
+ *  - RETURN,<recordID>,<returned YYYY-MM-DD>,<lateFeePerDay>
+ *  - ADD_BOOK,<book CSV row>       - REMOVE_BOOK,<isbn>
+ *  - ADD_USER,<user CSV row>       - REMOVE_USER,<userID>
+ * Blank lines and lines starting with '#' are skipped.
+ *
+ * Every transaction line gets one result line, in input order:
+ *  - <line>,OK                 applied (BORROW adds ",<recordID>")
+ *  - <line>,FAILED,<reason>    well formed, but the library refused it
+ *  - <line>,ERROR,<problem>    couldn't be parsed, nothing was changed
+ * Results end in '\n' and are left to the stream's buffering, nothing is
+ * flushed per line.
+ *
+ * Consecutive transactions of the same kind are collected and applied with one
+ * bulk Library call (borrowMany, returnMany, addBooks, addUsers). A run ends at
+ * the first line of another kind, so changes still happen in file order.
+ */
+
+class BatchProcessor {
+private:
+    // Kind of the run being collected
+    enum class Run { NONE, BORROW, RETURN, ADD_BOOK, ADD_USER };
+
+    // Longest run applied in one bulk call
+    static constexpr std::size_t MAX_RUN = 4096;
+
+    Library& lib;
+    std::ostream& out;
+    std::size_t succeeded;
+    std::size_t failed;
+
+    Run current;
+    std::vector<std::uint64_t> runLines; // input line of each collected item
+    std::vector<BorrowRequest> borrows;
+    std::vector<ReturnRequest> returns;
+    std::vector<Book> newBooks;
+    std::vector<std::unique_ptr<User>> newUsers;
+
+    void startItem(Run kind, std::uint64_t lineNo);
+    void flush();
+    void report(std::uint64_t lineNo, ChangeStatus status, Run kind);
+
+    void runLine(std::uint64_t lineNo, std::string_view line);
+    void borrow(std::uint64_t lineNo, CsvCursor& cursor);
+    void giveBack(std::uint64_t lineNo, CsvCursor& cursor);
+    void addBook(std::uint64_t lineNo, std::string_view row);
+    void addUser(std::uint64_t lineNo, std::string_view row);
+    void removeBook(std::uint64_t lineNo, CsvCursor& cursor);
+    void removeUser(std::uint64_t lineNo, CsvCursor& cursor);
+
+    void reportOK(std::uint64_t lineNo);
+    void reportFailed(std::uint64_t lineNo, const char* reason);
+    void reportError(std::uint64_t lineNo, const std::string& problem);
+
+public:
+    BatchProcessor(Library& lib, std::ostream& out);
+
+    // Runs every transaction in filename, returns false if it can't be read
+    bool run(const std::string& filename);
+
+    std::size_t getSucceeded() const;
+    std::size_t getFailed() const; // FAILED and ERROR lines
+};
+
+#endif
\ No newline at end of file
@@ -14,35 +14,62 @@
  */
 
 // constructors
-Book::Book() : isbn(""), title(""), author(""), year(0), copiesTotal(0), copiesAvailable(0) {}
-Book::Book(const std::string& isbn, const std::string& title, const std::string& author, unsigned int year, unsigned int copiesTotal)
-    : isbn(isbn), title(title), author(author), year(year), copiesTotal(copiesTotal), copiesAvailable(copiesTotal) {}
+Book::Book() : isbn(""), title(), author(), year(0), copies(0) {}
+Book::Book(std::string_view isbn, std::string_view title, std::string_view author, unsigned int year, unsigned int copiesTotal)
+    : isbn(isbn), title(title), author(author), year(year), copies(packCopies(copiesTotal, copiesTotal)) {}
+Book::Book(std::string_view isbn, std::string_view title, std::string_view author, unsigned int year, unsigned int copiesTotal,
+           unsigned int copiesAvailable, StringArena* arena)
+    : isbn(isbn), title(title, arena), author(author, arena), year(year), copies(packCopies(copiesTotal, copiesAvailable)) {}
+
+Book::Book(const Book& other)
+    : isbn(other.isbn), title(other.title), author(other.author), year(other.year),
+      copies(other.copies.load(std::memory_order_relaxed)) {}
+Book::Book(Book&& other) noexcept
+    : isbn(std::move(other.isbn)), title(std::move(other.title)), author(std::move(other.author)), year(other.year),
+      copies(other.copies.load(std::memory_order_relaxed)) {}
+
+Book& Book::operator=(const Book& other) {
+    isbn = other.isbn;
+    title = other.title;
+    author = other.author;
+    year = other.year;
+    copies.store(other.copies.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+Book& Book::operator=(Book&& other) noexcept {
+    isbn = std::move(other.isbn);
+    title = std::move(other.title);
+    author = std::move(other.author);
+    year = other.year;
+    copies.store(other.copies.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
 
 // gettters
 const std::string& Book::getISBN() const {
     return isbn;
 }
-const std::string& Book::getTitle() const {
-    return title;
+std::string_view Book::getTitle() const {
+    return title.view();
 }
-const std::string& Book::getAuthor() const {
-    return author;
+std::string_view Book::getAuthor() const {
+    return author.view();
 }
 unsigned int Book::getYear() const {
     return year;
 }
 unsigned int Book::getCopiesTotal() const {
-    return copiesTotal;
+    return totalOf(copies.load(std::memory_order_relaxed));
 }
 unsigned int Book::getCopiesAvailable() const {
-    return copiesAvailable;
+    return availableOf(copies.load(std::memory_order_relaxed));
 }
 
 // setters
-void Book::setTitle(const std::string& t) {
+void Book::setTitle(std::string_view t) {
     title = t;
 }
-void Book::setAuthor(const std::string& a) {
+void Book::setAuthor(std::string_view a) {
     author = a;
 }
 void Book::setYear(unsigned int y) {
@@ -50,59 +77,94 @@ void Book::setYear(unsigned int y) {
 }
 
 // Inventory operators
+// Each one reads the packed counts, checks them and swaps in the new pair only
+// if no other thread changed them in between, retrying otherwise. The counts
+// publish no other data, so relaxed ordering is enough.
 void Book::addCopies(unsigned int n) {
     // Increases both total and available copies
-    copiesTotal +=n;
-    copiesAvailable +=n;
+    std::uint64_t c = copies.load(std::memory_order_relaxed);
+    while (!copies.compare_exchange_weak(c, packCopies(totalOf(c) + n, availableOf(c) + n),
+                                         std::memory_order_relaxed))
+        ;
 }
 bool Book::borrowOne() {
-    if (copiesAvailable == 0)
-        return false;
-    copiesAvailable--;
+    std::uint64_t c = copies.load(std::memory_order_relaxed);
+    do {
+        if (availableOf(c) == 0)
+            return false;
+    } while (!copies.compare_exchange_weak(c, c - 1, std::memory_order_relaxed));
     return true;
 }
 
 bool Book::returnOne() {
-    // Attempts to decrement available copies
-    if(copiesAvailable < copiesTotal) {
-        copiesAvailable++;
-        // true if copy was borrowed successfully
-        return true;
-    }
-    // flase if no copies are available
-    return false;
+    // Attempts to increment available copies
+    std::uint64_t c = copies.load(std::memory_order_relaxed);
+    do {
+        // false if every copy is already in
+        if (availableOf(c) >= totalOf(c))
+            return false;
+    } while (!copies.compare_exchange_weak(c, c + 1, std::memory_order_relaxed));
+    return true;
+}
+
+// CSV fields, in file order
+constexpr auto Book::csvFields() {
+    return std::make_tuple(
+        csvField("isbn", &Book::isbn),
+        csvField("title", &Book::title),
+        csvField("author", &Book::author),
+        csvField("year", &Book::year),
+        CsvCustomField<Book>{ "copiesTotal",
+            [](std::string_view text, Book& b) {
+                unsigned int total = 0;
+                CsvError err = CsvFormat<unsigned int>::parse(text, total);
+                b.copies = packCopies(total, availableOf(b.copies));
+                return err;
+            },
+            [](const Book& b, CsvWriter& out) {
+                out.number(b.getCopiesTotal());
+            } },
+        CsvCustomField<Book>{ "copiesAvailable",
+            [](std::string_view text, Book& b) {
+                unsigned int available = 0;
+                CsvError err = CsvFormat<unsigned int>::parse(text, available);
+                b.copies = packCopies(totalOf(b.copies), available);
+                return err;
+            },
+            [](const Book& b, CsvWriter& out) {
+                out.number(b.getCopiesAvailable());
+            } });
 }
 
 // CSV serialization
 // Converts all book data into string. This is used by Library I/O for saving book inventory
 std::string Book::serializeCSV() const {
-    std::ostringstream ss;
-    ss << isbn << "," << title << "," << author << "," << year << "," << copiesTotal << "," << copiesAvailable;
-    return ss.str();
+    return csvToString([this](char* first, char* last) { return writeCSV(first, last); });
 }
-// CSV deserialization
-// Reconstructs a Book object from a CSV line, uses stringstream and getline to extract fields
-Book Book::deserializeCSV(const std::string& line) {
-    std::stringstream ss(line);
-    std::string item;
-
-    std::string isbn, title, author;
-    unsigned int year = 0, total = 0, available = 0;
 
-    // Extract string fields (up to the comma)
-    std::getline(ss, isbn, ',');
-    std::getline(ss, title, ',');
-    std::getline(ss, author, ',');
+std::size_t Book::writeCSV(char* first, char* last) const {
+    return CsvCodec<Book>::format(*this, first, last);
+}
 
-    // Extract the numeric fields
-    ss >> year; ss.ignore(1);
-    ss >> total; ss.ignore(1);
-    ss >> available;
+// CSV deserialization
+// Reconstructs a Book object from a CSV line
+// The parsed title and author still point into line until keepText runs
+CsvStatus Book::parseCSV(std::string_view line, Book& out, StringArena* arena) {
+    CsvStatus status = CsvCodec<Book>::parse(line, out);
+    out.keepText(arena);
+    return status;
+}
 
-    // Construct book using the extracted values
-    Book b(isbn, title, author, year, total);
-    b.copiesAvailable = available;
+void Book::keepText(StringArena* arena) {
+    title.keepIn(arena);
+    author.keepIn(arena);
+}
 
+Book Book::deserializeCSV(std::string_view line) {
+    Book b;
+    CsvStatus status = parseCSV(line, b);
+    if (!status.ok())
+        throw std::runtime_error("Invalid CSV line for Book (" + status.describe() + "): " + std::string(line));
     return b;
 }
 
@@ -112,6 +174,7 @@ void Book::display(std::ostream& os) const {
     os << "Title: " << title << std::endl;
     os << "Author: " << author << std::endl;
     os << "Year: " << year << std::endl;
-    os << "Total Copies: " << copiesTotal << std::endl;
-    os << "Available Copies: " << copiesAvailable << std::endl;
+    std::uint64_t c = copies.load(std::memory_order_relaxed);
+    os << "Total Copies: " << totalOf(c) << std::endl;
+    os << "Available Copies: " << availableOf(c) << std::endl;
 }
\ No newline at end of file
@@ -2,8 +2,12 @@
 #define BOOK_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <sstream>
+#include <atomic>
+#include <cstdint>
+#include "CsvCodec.h"
 
 /*
  * Book.h
@@ -16,48 +20,77 @@
  *  - Total number of copies
  *  - Number of available copies
  *
+ * Title and author are ArenaStrings (see StringArena.h): a bulk load puts their
+ * text in the Library's arena, books built any other way own it.
+ *
+ * The copy counts share one atomic word, so borrowOne, returnOne and addCopies
+ * are lock-free compare-and-swap loops that can run on several threads at once
+ * and never let copiesAvailable exceed copiesTotal or drop below zero
+ * (bench/bench_book_counters.cpp compares them with a mutex per book).
+ *
  * The Book class provides:
  *  - Accessors and mutators for core book date
  *  - Inventory operations (borrow/return/add copies)
- *  - CSV serialization and deserialization for file storage
+ *  - CSV serialization and deserialization for file storage (through CsvCodec)
  *  - A formatted display function
  */
 
 class Book {
 private:
     std::string isbn;
-    std::string title;
-    std::string author;
+    ArenaString title;
+    ArenaString author;
     unsigned int year;
-    unsigned int copiesTotal;
-    unsigned int copiesAvailable;
+    // copiesTotal in the high 32 bits, copiesAvailable in the low 32
+    std::atomic<std::uint64_t> copies;
+
+    static constexpr std::uint64_t packCopies(unsigned int total, unsigned int available) {
+        return (static_cast<std::uint64_t>(total) << 32) | available;
+    }
+    static constexpr unsigned int totalOf(std::uint64_t c) { return static_cast<unsigned int>(c >> 32); }
+    static constexpr unsigned int availableOf(std::uint64_t c) { return static_cast<unsigned int>(c); }
+
+    // CSV field list used by CsvCodec<Book>
+    template <typename> friend class CsvCodec;
+    static constexpr auto csvFields();
+
+    void keepText(StringArena* arena); // after parsing, see ArenaString::keepIn
 
 public:
 // Constructor
 Book();
-Book(const std::string& isbn, const std::string& title, const std::string& author, unsigned int year, unsigned int copiesTotal);
+Book(std::string_view isbn, std::string_view title, std::string_view author, unsigned int year, unsigned int copiesTotal);
+Book(std::string_view isbn, std::string_view title, std::string_view author, unsigned int year, unsigned int copiesTotal,
+     unsigned int copiesAvailable, StringArena* arena = nullptr); // text in arena when given
+// Copies take a snapshot of the counts (the atomic itself can't be copied)
+Book(const Book& other);
+Book(Book&& other) noexcept;
+Book& operator=(const Book& other);
+Book& operator=(Book&& other) noexcept;
 
 // Getters
 const std::string& getISBN() const;
-const std::string& getTitle() const;
-const std::string& getAuthor() const;
+std::string_view getTitle() const;
+std::string_view getAuthor() const;
 unsigned int getYear() const;
 unsigned int getCopiesTotal() const;
 unsigned int getCopiesAvailable() const;
 
 // Setters
-void setTitle(const std::string& t);
-void setAuthor(const std::string& a);
+void setTitle(std::string_view t);  // the new text is always owned, the book
+void setAuthor(std::string_view a); // stops pointing into an arena for that field
 void setYear(unsigned int y);
 
-// Inventory operators
-void addCopies(unsigned int n);
-bool borrowOne();
-bool returnOne();
+// Inventory operators, safe to call concurrently
+void addCopies(unsigned int n); // raises total and available together
+bool borrowOne();               // false if no copy is available
+bool returnOne();               // false if no copy is out
 
 // file I/O
 std::string serializeCSV() const; // convert to CSV row
-static Book deserializeCSV(const std::string& line); // create from CSV row
+static Book deserializeCSV(std::string_view line); // create from CSV row, throws on a bad row
+static CsvStatus parseCSV(std::string_view line, Book& out, StringArena* arena = nullptr); // create from CSV row, reports the bad field
+std::size_t writeCSV(char* first, char* last) const; // row length, 0 if the buffer is too small
 
 // display
 void display(std::ostream& os) const;
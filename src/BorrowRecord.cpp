@@ -1,6 +1,8 @@
 #include "BorrowRecord.h"
+#include <charconv>
 #include <sstream>
 #include <iomanip>
+#include <stdexcept>
 
 /*
  * BorrowRecord.cpp
@@ -9,158 +11,317 @@
  * Includes:
  *  - Full constructor definitions
  *  - Logic for making a record returned
- *  - Late-day calculation using approximate date conversion
+ *  - Late-day calculation from day numbers
  *  - CSV serialization/deserialization operations
  *  - A formatted display method for human-readable output
  */
 
-// Helper: Convert a date (y, m, d) into an integer
-static int toDays(int y, int m, int d) {
-    return y * 365 + m * 30 + d;
-}
-
 // Constructors
 BorrowRecord::BorrowRecord()
-    : recordID(""), userID(""), isbn(""),
-    borrowedYear(0), borrowedMonth(0), borrowedDay(0),
-    dueYear(0), dueMonth(0), dueDay(0),
-    returned(false), returnYear(0), returnMonth(0), returnDay(0) {}
-
-BorrowRecord::BorrowRecord(std::string r, std::string u, std::string i, int by, int bm, int bd, int dy, int dm, int dd)
-    : recordID(r), userID(u), isbn(i),
-    borrowedYear(by), borrowedMonth(bm), borrowedDay(bd),
-    dueYear(dy), dueMonth(dm), dueDay(dd),
-    returned(false), returnYear(0), returnMonth(0), returnDay(0) {}
+    : recordID(0), userKey(SymbolTable::NONE), bookKey(SymbolTable::NONE),
+    borrowedOn(0), dueOn(0), returnedOn(NOT_RETURNED) {}
+
+BorrowRecord::BorrowRecord(std::uint64_t r, RecordSymbols& symbols, std::string_view u, std::string_view i,
+                           int by, int bm, int bd, int dy, int dm, int dd)
+    : recordID(r), userKey(symbols.userIDs.intern(u)), bookKey(symbols.isbns.intern(i)),
+    borrowedOn(daysFromCivil(by, bm, bd)), dueOn(daysFromCivil(dy, dm, dd)), returnedOn(NOT_RETURNED) {}
+
+BorrowRecord::BorrowRecord(std::uint64_t r, RecordSymbols& symbols, std::string_view u, std::string_view i,
+                           DayNumber borrowed, DayNumber due)
+    : recordID(r), userKey(symbols.userIDs.intern(u)), bookKey(symbols.isbns.intern(i)),
+    borrowedOn(borrowed), dueOn(due), returnedOn(NOT_RETURNED) {}
+
+BorrowRecord::BorrowRecord(std::uint64_t r, std::uint32_t user, std::uint32_t book, DayNumber borrowed, DayNumber due)
+    : recordID(r), userKey(user), bookKey(book),
+    borrowedOn(borrowed), dueOn(due), returnedOn(NOT_RETURNED) {}
+
+// Helper: text of a key, empty for a default-constructed record
+static std::string_view nameOf(const SymbolTable& table, std::uint32_t key) {
+    return key == SymbolTable::NONE ? std::string_view() : table.name(key);
+}
 
 // Getters
-const std::string& BorrowRecord::getRecordID() const {
+std::uint64_t BorrowRecord::getRecordID() const {
     return recordID;
 }
 
-const std::string& BorrowRecord::getUserID() const {
-    return userID;
+std::string_view BorrowRecord::getUserID(const RecordSymbols& symbols) const {
+    return nameOf(symbols.userIDs, userKey);
+}
+
+std::string_view BorrowRecord::getISBN(const RecordSymbols& symbols) const {
+    return nameOf(symbols.isbns, bookKey);
 }
 
-const std::string& BorrowRecord::getISBN() const {
-    return isbn;
+std::uint32_t BorrowRecord::getUserKey() const {
+    return userKey;
+}
+
+std::uint32_t BorrowRecord::getBookKey() const {
+    return bookKey;
 }
 
 bool BorrowRecord::isReturned() const {
-    return returned;
+    return returnedOn != NOT_RETURNED;
+}
+
+void BorrowRecord::getBorrowedDate(int& y, int& m, int& d) const {
+    civilFromDays(borrowedOn, y, m, d);
+}
+
+void BorrowRecord::getDueDate(int& y, int& m, int& d) const {
+    civilFromDays(dueOn, y, m, d);
+}
+
+void BorrowRecord::getReturnDate(int& y, int& m, int& d) const {
+    if (isReturned())
+        civilFromDays(returnedOn, y, m, d);
+    else
+        y = m = d = 0;
+}
+
+DayNumber BorrowRecord::getBorrowedDay() const {
+    return borrowedOn;
+}
+
+DayNumber BorrowRecord::getDueDay() const {
+    return dueOn;
+}
+
+DayNumber BorrowRecord::getReturnDay() const {
+    return returnedOn;
+}
+
+void BorrowRecord::setRecordID(std::uint64_t id) {
+    recordID = id;
 }
 
 // Mark the record as returned on the given date
 void BorrowRecord::markReturned(int y, int m, int d) {
-    returned = true;
-    returnYear = y;
-    returnMonth = m;
-    returnDay = d;
+    returnedOn = daysFromCivil(y, m, d);
+}
+
+void BorrowRecord::markReturned(DayNumber day) {
+    returnedOn = day;
 }
 
 // Calculate how many days late the return was
 int BorrowRecord::daysLate() const {
-    if (!returned)
+    if (!isReturned())
         return 0;
 
-    int due = toDays(dueYear, dueMonth, dueDay);
-    int ret = toDays(returnYear, returnMonth, returnDay);
-
-    int diff = ret - due;
+    int diff = returnedOn - dueOn;
     return (diff > 0 ? diff : 0);
 }
 
-// Serialize the record into a CSV format
-std::string BorrowRecord::serialize() const {
-    std::ostringstream ss;
-
-    ss << recordID << ","
-        << userID << ","
-        << isbn << ","
-        << borrowedYear << "-" << borrowedMonth << "-" << borrowedDay << ","
-        << dueYear << "-" << dueMonth << "-" << dueDay << ",";
-
-    if (returned) {
-        ss << "RETURNED,"
-            << returnYear << "-" << returnMonth << "-" << returnDay;
+// Parse a YYYY-MM-DD formatted string into integers
+CsvError BorrowRecord::parseDate(std::string_view s, int& y, int& m, int& d) {
+    s = trimBlanks(s);
+    const char* p = s.data();
+    const char* end = s.data() + s.size();
+
+    auto res = std::from_chars(p, end, y);
+    if (res.ec != std::errc() || res.ptr == end || *res.ptr != '-')
+        return CsvError::BAD_VALUE;
+    res = std::from_chars(res.ptr + 1, end, m);
+    if (res.ec != std::errc() || res.ptr == end || *res.ptr != '-')
+        return CsvError::BAD_VALUE;
+    res = std::from_chars(res.ptr + 1, end, d);
+    if (res.ec != std::errc() || res.ptr != end || !isValidDate(y, m, d))
+        return CsvError::BAD_VALUE;
+    return CsvError::NONE;
+}
+
+// Helper: Parse a date field into a day number
+static CsvError parseDay(std::string_view s, DayNumber& day) {
+    int y, m, d;
+    CsvError err = BorrowRecord::parseDate(s, y, m, d);
+    if (err == CsvError::NONE)
+        day = daysFromCivil(y, m, d);
+    return err;
+}
+
+// Helper: Write a day number as Y-M-D (no zero padding, same as the old stream output)
+static void writeDate(CsvWriter& out, DayNumber day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    out.number(y);
+    out.text("-");
+    out.number(m);
+    out.text("-");
+    out.number(d);
+}
+
+// Helper field for the user ID and ISBN columns. Rows are only ever parsed
+// into and written from a StagedBorrowRecord, which holds the text as a view;
+// the symbol tables are applied around the codec, never inside it.
+struct SymbolColumn {
+    const char* name;
+    std::string_view StagedBorrowRecord::*staged;
+
+    bool presentIn(const StagedBorrowRecord&) const { return true; }
+
+    CsvError parse(std::string_view text, StagedBorrowRecord& obj) const {
+        obj.*staged = text;
+        return CsvError::NONE;
     }
-    else {
-        ss << "NOT_RETURNED";
+
+    void format(const StagedBorrowRecord& obj, CsvWriter& out) const {
+        out.text(obj.*staged);
     }
-    return ss.str();
+};
+
+// CSV fields, in file order
+// REC<n>,user,isbn,borrowed,due,RETURNED,returned  or  ...,due,NOT_RETURNED
+constexpr auto BorrowRecord::csvFields() {
+    return std::make_tuple(
+        CsvCustomField<BorrowRecord>{ "recordID",
+            [](std::string_view text, BorrowRecord& r) {
+                return parseRecordID(text, r.recordID) ? CsvError::NONE : CsvError::BAD_VALUE;
+            },
+            [](const BorrowRecord& r, CsvWriter& out) {
+                out.text("REC");
+                out.number(r.recordID);
+            } },
+        SymbolColumn{ "userID", &StagedBorrowRecord::userText },
+        SymbolColumn{ "isbn", &StagedBorrowRecord::isbnText },
+        CsvCustomField<BorrowRecord>{ "borrowed",
+            [](std::string_view text, BorrowRecord& r) {
+                return parseDay(text, r.borrowedOn);
+            },
+            [](const BorrowRecord& r, CsvWriter& out) {
+                writeDate(out, r.borrowedOn);
+            } },
+        CsvCustomField<BorrowRecord>{ "due",
+            [](std::string_view text, BorrowRecord& r) {
+                return parseDay(text, r.dueOn);
+            },
+            [](const BorrowRecord& r, CsvWriter& out) {
+                writeDate(out, r.dueOn);
+            } },
+        CsvCustomField<BorrowRecord>{ "status",
+            [](std::string_view text, BorrowRecord& r) {
+                // The return date field that follows sets the real day
+                if (text == "RETURNED") r.returnedOn = 0;
+                else if (text == "NOT_RETURNED") r.returnedOn = NOT_RETURNED;
+                else return CsvError::BAD_VALUE;
+                return CsvError::NONE;
+            },
+            [](const BorrowRecord& r, CsvWriter& out) {
+                out.text(r.isReturned() ? "RETURNED" : "NOT_RETURNED");
+            } },
+        // Only present on returned records
+        CsvCustomField<BorrowRecord>{ "returnDate",
+            [](std::string_view text, BorrowRecord& r) {
+                return parseDay(text, r.returnedOn);
+            },
+            [](const BorrowRecord& r, CsvWriter& out) {
+                writeDate(out, r.returnedOn);
+            },
+            [](const BorrowRecord& r) { return r.isReturned(); } });
 }
 
-// Helper: Parse a YYYY-MM-DD formatted string into integers
-static void parseDate(const std::string& s, int& y, int& m, int& d) {
-    char dash;
-    std::stringstream ss(s);
-    ss >> y >> dash >> m >> dash >> d;
+// Serialize the record into a CSV format
+std::string BorrowRecord::serialize(const RecordSymbols& symbols) const {
+    return csvToString([&](char* first, char* last) { return writeCSV(symbols, first, last); });
 }
 
-// Deserialize a CSV string back into a BorrowRecord
-BorrowRecord BorrowRecord::deserialize(const std::string& line) {
-    std::stringstream ss(line);
+std::size_t BorrowRecord::writeCSV(const RecordSymbols& symbols, char* first, char* last) const {
+    StagedBorrowRecord row;
+    static_cast<BorrowRecord&>(row) = *this;
+    row.userText = getUserID(symbols);
+    row.isbnText = getISBN(symbols);
+    return CsvCodec<StagedBorrowRecord>::format(row, first, last);
+}
 
-    std::string recordID, userID, isbn;
-    std::string borrowedStr, dueStr;
-    std::string returnFlag, returnDateStr;
+// Deserialize a CSV string back into a BorrowRecord, interning its IDs in symbols
+CsvStatus BorrowRecord::parseCSV(std::string_view line, RecordSymbols& symbols, BorrowRecord& out) {
+    StagedBorrowRecord row;
+    CsvStatus status = CsvCodec<StagedBorrowRecord>::parse(line, row);
+    if (status.ok()) {
+        row.resolve(symbols.userIDs.intern(row.userText), symbols.isbns.intern(row.isbnText));
+        out = row;
+    }
+    return status;
+}
 
-    std::getline(ss, recordID, ',');
-    std::getline(ss, userID, ',');
-    std::getline(ss, isbn, ',');
-    std::getline(ss, borrowedStr, ',');
-    std::getline(ss, dueStr, ',');
-    std::getline(ss, returnFlag, ',');
+CsvStatus BorrowRecord::parseCSV(std::string_view line, StagedBorrowRecord& out) {
+    return CsvCodec<StagedBorrowRecord>::parse(line, out);
+}
 
-    int by, bm, bd;
-    int dy, dm, dd;
+void StagedBorrowRecord::resolve(std::uint32_t user, std::uint32_t book) {
+    userKey = user;
+    bookKey = book;
+}
 
-    parseDate(borrowedStr, by, bm, bd);
-    parseDate(dueStr, dy, dm, dd);
+BorrowRecord BorrowRecord::deserialize(std::string_view line, RecordSymbols& symbols) {
+    BorrowRecord rec;
+    CsvStatus status = parseCSV(line, symbols, rec);
+    if (!status.ok())
+        throw std::runtime_error("Invalid CSV line for BorrowRecord (" + status.describe() + "): " + std::string(line));
+    return rec;
+}
 
-    // Create base record
-    BorrowRecord rec(recordID, userID, isbn, by, bm, bd, dy, dm, dd);
+// Record ID text form
+std::string BorrowRecord::formatRecordID(std::uint64_t id) {
+    return "REC" + std::to_string(id);
+}
 
-    // If returned, read one more date
-    if (returnFlag == "RETURNED") {
-        std::getline(ss, returnDateStr, ',');
-        int ry, rm, rd;
-        parseDate(returnDateStr, ry, rm, rd);
-        rec.markReturned(ry, rm, rd);
+// Accepts "REC<n>" or a bare number, rejects anything else (including 0)
+bool BorrowRecord::parseRecordID(std::string_view text, std::uint64_t& id) {
+    std::size_t pos = (text.substr(0, 3) == "REC") ? 3 : 0;
+    if (pos == text.size())
+        return false;
+
+    std::uint64_t value = 0;
+    for (; pos < text.size(); ++pos) {
+        char c = text[pos];
+        if (c < '0' || c > '9')
+            return false;
+        if (value > (UINT64_MAX - (c - '0')) / 10)
+            return false;
+        value = value * 10 + (c - '0');
     }
+    if (value == 0)
+        return false;
 
-    return rec;
+    id = value;
+    return true;
+}
+
+// Helper: print a day number as YYYY-MM-DD
+static void printDate(std::ostream& os, DayNumber day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    os << y << "-" << std::right << std::setfill('0')
+       << std::setw(2) << m << "-" << std::setw(2) << d
+       << std::setfill(' ') << std::left;
 }
 
 // Display
-    void BorrowRecord::display(std::ostream& os) const {
+    void BorrowRecord::display(const RecordSymbols& symbols, std::ostream& os) const {
     os << "----------------------------------------------------" << std::endl;
     os << "                  BORROW RECORD                     " << std::endl;
     os << "----------------------------------------------------" << std::endl;
 
-    os << std::left << std::setw(18) << "Record ID:"    << recordID << std::endl;
-    os << std::left << std::setw(18) << "User ID:"      << userID << std::endl;
-    os << std::left << std::setw(18) << "ISBN:"         << isbn << std::endl;
+    os << std::left << std::setw(18) << "Record ID:"    << formatRecordID(recordID) << std::endl;
+    os << std::left << std::setw(18) << "User ID:"      << getUserID(symbols) << std::endl;
+    os << std::left << std::setw(18) << "ISBN:"         << getISBN(symbols) << std::endl;
 
-    os << std::left << std::setw(18) << "Borrowed Date:"
-       << borrowedYear << "-"
-       << std::setw(2) << std::setfill('0') << borrowedMonth << "-"
-       << std::setw(2) << std::setfill('0') << borrowedDay << std::endl;
-    os << std::setfill(' ');
+    os << std::left << std::setw(18) << "Borrowed Date:";
+    printDate(os, borrowedOn);
+    os << std::endl;
 
-    os << std::left << std::setw(18) << "Due Date:"
-       << dueYear << "-"
-       << std::setw(2) << std::setfill('0') << dueMonth << "-"
-       << std::setw(2) << std::setfill('0') << dueDay << std::endl;
-    os << std::setfill(' ');
+    os << std::left << std::setw(18) << "Due Date:";
+    printDate(os, dueOn);
+    os << std::endl;
 
-    if (returned) {
+    if (isReturned()) {
         os << std::left << std::setw(18) << "Returned:" << "YES" << std::endl;
 
-        os << std::left << std::setw(18) << "Return Date:"
-           << returnYear << "-"
-           << std::setw(2) << std::setfill('0') << returnMonth << "-"
-           << std::setw(2) << std::setfill('0') << returnDay << std::endl;
-        os << std::setfill(' ');
+        os << std::left << std::setw(18) << "Return Date:";
+        printDate(os, returnedOn);
+        os << std::endl;
 
         os << std::left << std::setw(18) << "Days Late:" << daysLate() << std::endl;
     } else {
@@ -2,13 +2,18 @@
 #define BORROW_RECORD_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <cstdint>
+#include "CsvCodec.h"
+#include "Date.h"
+#include "SymbolTable.h"
 
 /*
  * BorrowRecord.h
  * BorrowRecord stores the information about a single instance of a book being borrowed by a user.
  * Stores:
- *  - Record ID
+ *  - Record ID (numeric, shown as "REC<n>" in CSV and on screen)
  *  - User ID
  *  - Book ISBN
  *  - Borrowed date
@@ -16,60 +21,110 @@
  *  - Return date
  *  - Late fee calculation
  *
+ * Dates are kept as 32-bit day numbers (see Date.h), which keeps the record
+ * small and makes days late a single subtraction.
+ *
+ * The user ID and ISBN are interned: a record holds their 32-bit keys in the
+ * RecordSymbols of the Library that owns it, and the text is only looked up
+ * for display, CSV output and the string getters, which all take those
+ * symbols. Parsing on other threads goes through StagedBorrowRecord, which
+ * leaves the interning for later.
+ *
  * Include:
  *  - Marking a record as returned
- *  - Computing days late using simplified date math
+ *  - Computing days late from the day numbers
  *  - CSV serialization and parsing
  *  - formatted display function
  */
 
+struct StagedBorrowRecord;
+
+// The user ID and ISBN tables a set of records is interned in
+struct RecordSymbols {
+    SymbolTable userIDs;
+    SymbolTable isbns;
+};
+
 class BorrowRecord {
 private:
-    std::string recordID;
-    std::string userID;
-    std::string isbn;
-
-    // Borrowed date (YYYY-MM-DD)
-    int borrowedYear;
-    int borrowedMonth;
-    int borrowedDay;
-
-    //  Due date (YYYY-MM-DD)
-    int dueYear;
-    int dueMonth;
-    int dueDay;
-
-    // Return information
-    bool returned;
-    int returnYear;
-    int returnMonth;
-    int returnDay;
+    std::uint64_t recordID;
+    std::uint32_t userKey; // in RecordSymbols::userIDs
+    std::uint32_t bookKey; // in RecordSymbols::isbns
+
+    DayNumber borrowedOn;
+    DayNumber dueOn;
+    DayNumber returnedOn; // NOT_RETURNED until the book comes back
+
+    // CSV field list used by CsvCodec<StagedBorrowRecord>
+    template <typename> friend class CsvCodec;
+    static constexpr auto csvFields();
+
+    friend struct StagedBorrowRecord;
 
 public:
+    static constexpr DayNumber NOT_RETURNED = INT32_MIN;
+
     // Constructors
     BorrowRecord();
 
-    BorrowRecord(std::string r, std::string u, std::string i, int by, int bm, int bd, int dy, int dm, int dd);
+    BorrowRecord(std::uint64_t r, RecordSymbols& symbols, std::string_view u, std::string_view i,
+                 int by, int bm, int bd, int dy, int dm, int dd);
+    BorrowRecord(std::uint64_t r, RecordSymbols& symbols, std::string_view u, std::string_view i,
+                 DayNumber borrowed, DayNumber due);
+    BorrowRecord(std::uint64_t r, std::uint32_t user, std::uint32_t book, DayNumber borrowed, DayNumber due);
 
     // Getters
-    const std::string& getRecordID() const;
-    const std::string& getUserID() const;
-    const std::string& getISBN() const;
+    std::uint64_t getRecordID() const;
+    std::string_view getUserID(const RecordSymbols& symbols) const;
+    std::string_view getISBN(const RecordSymbols& symbols) const;
+    std::uint32_t getUserKey() const;
+    std::uint32_t getBookKey() const;
 
     bool isReturned() const;
+    void getBorrowedDate(int& y, int& m, int& d) const;
+    void getDueDate(int& y, int& m, int& d) const;
+    void getReturnDate(int& y, int& m, int& d) const; // all 0 while not returned
+
+    DayNumber getBorrowedDay() const;
+    DayNumber getDueDay() const;
+    DayNumber getReturnDay() const; // NOT_RETURNED while not returned
+
+    // Used by the loader to renumber records whose saved ID collides
+    void setRecordID(std::uint64_t id);
 
     // Mark the record as returned
     void markReturned(int y, int m, int d);
+    void markReturned(DayNumber day);
 
     // Calculate how many days late
     int daysLate() const;
 
     // Serialization
-    std::string serialize() const;
-    static BorrowRecord deserialize(const std::string& line);
+    std::string serialize(const RecordSymbols& symbols) const;
+    static BorrowRecord deserialize(std::string_view line, RecordSymbols& symbols); // throws on a bad row
+    static CsvStatus parseCSV(std::string_view line, RecordSymbols& symbols, BorrowRecord& out);
+    static CsvStatus parseCSV(std::string_view line, StagedBorrowRecord& out); // safe on any thread
+    std::size_t writeCSV(const RecordSymbols& symbols, char* first, char* last) const; // row length, 0 if the buffer is too small
+
+    // Record ID text form ("REC<n>"), only used for display and CSV
+    static std::string formatRecordID(std::uint64_t id);
+    static bool parseRecordID(std::string_view text, std::uint64_t& id);
+
+    // Date text form ("YYYY-MM-DD", zero padding optional), rejects days that don't exist
+    static CsvError parseDate(std::string_view text, int& y, int& m, int& d);
 
     // Display
-    void display(std::ostream& os = std::cout) const;
+    void display(const RecordSymbols& symbols, std::ostream& os = std::cout) const;
+};
+
+// A record parsed without touching any symbol table. The user ID and ISBN stay
+// as views into the parsed line until resolve() sets their keys. CSV output
+// goes through one too, with the views pointing at the symbol text.
+struct StagedBorrowRecord : BorrowRecord {
+    std::string_view userText;
+    std::string_view isbnText;
+
+    void resolve(std::uint32_t user, std::uint32_t book);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "CsvCodec.h"
+
+/*
+ * CsvCodec.cpp
+ * Implements the out-of-line parts of the CSV row codec declared in CsvCodec.h.
+ */
+
+// CsvStatus
+std::string CsvStatus::describe() const {
+    const char* what = "ok";
+    switch (error) {
+        case CsvError::NONE: what = "ok";
+            break;
+        case CsvError::MISSING_FIELD: what = "missing";
+            break;
+        case CsvError::BAD_NUMBER: what = "not a number";
+            break;
+        case CsvError::BAD_VALUE: what = "invalid value";
+            break;
+        case CsvError::EXTRA_FIELDS: what = "unexpected extra fields";
+            break;
+    }
+
+    std::string text = "field " + std::to_string(field + 1);
+    if (fieldName && *fieldName)
+        text += std::string(" (") + fieldName + ")";
+    return text + ": " + what;
+}
\ No newline at end of file
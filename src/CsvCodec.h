@@ -0,0 +1,307 @@
+#ifndef CSV_CODEC_H
+#define CSV_CODEC_H
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <charconv>
+#include <cstddef>
+#include <type_traits>
+#include <cstring>
+#include "StringArena.h"
+
+/*
+ * CsvCodec.h
+ * Declares the templated CSV row codec shared by Book, User and BorrowRecord.
+ *
+ * Each type lists its fields once, in a private static constexpr csvFields() that
+ * returns a tuple of field descriptors:
+ *  - csvField(name, &T::member) for a member read and written as one field
+ *    (std::string, integers and double)
+ *  - CsvCustomField for fields with their own text form (dates, record IDs,
+ *    enums). A custom field can be conditional, e.g. a return date that is
+ *    only written for returned records.
+ *
+ * CsvCodec<T> turns that list into a parser (std::from_chars) and a formatter
+ * (std::to_chars) at compile time; the field list is a constant, so member
+ * pointers and custom functions are inlined rather than called indirectly. The parser is strict: every field must be
+ * present and fully consumed, and a bad row produces a CsvStatus naming the
+ * field and the problem instead of a half-filled object. Numbers may have
+ * spaces or tabs around them, as the old stream parser allowed (a hand-typed
+ * "Math, 2.5" still loads); text fields are taken as they are. The formatter writes
+ * into a caller-supplied buffer and never allocates.
+ */
+
+// What went wrong with a row
+enum class CsvError { NONE, MISSING_FIELD, BAD_NUMBER, BAD_VALUE, EXTRA_FIELDS };
+
+// Result of parsing a row (formatting reports a short buffer by returning 0)
+struct CsvStatus {
+    CsvError error = CsvError::NONE;
+    std::size_t field = 0;       // 0-based field index
+    const char* fieldName = "";
+
+    bool ok() const { return error == CsvError::NONE; }
+
+    // e.g. "field 4 (year): not a number"
+    std::string describe() const;
+};
+
+// Walks the comma-separated fields of one line
+// (defined here, it runs once per field and needs to inline)
+class CsvCursor {
+private:
+    std::string_view rest;
+    bool done;
+    std::size_t index;
+
+public:
+    explicit CsvCursor(std::string_view line) : rest(line), done(false), index(0) {}
+
+    // Next field, returns false when the line has no fields left
+    bool next(std::string_view& field) {
+        if (done)
+            return false;
+
+        std::size_t comma = rest.find(',');
+        if (comma == std::string_view::npos) {
+            field = rest;
+            done = true;
+        }
+        else {
+            field = rest.substr(0, comma);
+            rest.remove_prefix(comma + 1);
+        }
+        index++;
+        return true;
+    }
+
+    bool atEnd() const { return done; }
+
+    // Index of the next field
+    std::size_t fieldIndex() const { return index; }
+};
+
+// Appends fields to a caller-supplied buffer, remembers if it ran out of room
+class CsvWriter {
+private:
+    char* pos;
+    char* end;
+    bool overflow;
+
+public:
+    CsvWriter(char* first, char* last) : pos(first), end(last), overflow(false) {}
+
+    void separator() { text(","); }
+
+    void text(std::string_view s) {
+        if (overflow)
+            return;
+        if (static_cast<std::size_t>(end - pos) < s.size()) {
+            overflow = true;
+            return;
+        }
+        std::memcpy(pos, s.data(), s.size());
+        pos += s.size();
+    }
+
+    template <typename N>
+    void number(N value) {
+        if (overflow)
+            return;
+        auto res = std::to_chars(pos, end, value);
+        if (res.ec != std::errc())
+            overflow = true;
+        else
+            pos = res.ptr;
+    }
+
+    char* position() const { return pos; }
+    bool overflowed() const { return overflow; }
+};
+
+// Helper: text without the spaces and tabs around it, for numeric fields
+inline std::string_view trimBlanks(std::string_view text) {
+    std::size_t first = text.find_first_not_of(" \t");
+    if (first == std::string_view::npos)
+        return std::string_view();
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// Text form of one value type
+template <typename T, typename Enable = void>
+struct CsvFormat;
+
+template <>
+struct CsvFormat<std::string> {
+    static CsvError parse(std::string_view text, std::string& value) {
+        value.assign(text.data(), text.size());
+        return CsvError::NONE;
+    }
+    static void format(const std::string& value, CsvWriter& out) {
+        out.text(value);
+    }
+};
+
+// Parsing only borrows the text of the line, the owner must call keepIn() before the line goes away
+template <>
+struct CsvFormat<ArenaString> {
+    static CsvError parse(std::string_view text, ArenaString& value) {
+        value = ArenaString::borrow(text);
+        return CsvError::NONE;
+    }
+    static void format(const ArenaString& value, CsvWriter& out) {
+        out.text(value.view());
+    }
+};
+
+template <typename T>
+struct CsvFormat<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>> {
+    static CsvError parse(std::string_view text, T& value) {
+        text = trimBlanks(text);
+        const char* last = text.data() + text.size();
+        auto res = std::from_chars(text.data(), last, value);
+        if (text.empty() || res.ec != std::errc() || res.ptr != last)
+            return CsvError::BAD_NUMBER;
+        return CsvError::NONE;
+    }
+    static void format(T value, CsvWriter& out) {
+        out.number(value);
+    }
+};
+
+// A field stored in one member
+template <typename Owner, typename Value>
+struct CsvField {
+    const char* name;
+    Value Owner::*member;
+
+    template <typename Obj>
+    bool presentIn(const Obj&) const { return true; }
+
+    template <typename Obj>
+    CsvError parse(std::string_view text, Obj& obj) const {
+        return CsvFormat<Value>::parse(text, obj.*member);
+    }
+
+    template <typename Obj>
+    void format(const Obj& obj, CsvWriter& out) const {
+        CsvFormat<Value>::format(obj.*member, out);
+    }
+};
+
+template <typename Owner, typename Value>
+constexpr CsvField<Owner, Value> csvField(const char* name, Value Owner::*member) {
+    return CsvField<Owner, Value>{ name, member };
+}
+
+// A field with its own parse/format functions. If present is set, the field only
+// exists in rows where present(obj) is true (checked after the earlier fields are parsed).
+template <typename Owner>
+struct CsvCustomField {
+    const char* name;
+    CsvError (*parseFn)(std::string_view text, Owner& obj);
+    void (*formatFn)(const Owner& obj, CsvWriter& out);
+    bool (*present)(const Owner& obj) = nullptr;
+
+    template <typename Obj>
+    bool presentIn(const Obj& obj) const { return !present || present(obj); }
+
+    template <typename Obj>
+    CsvError parse(std::string_view text, Obj& obj) const { return parseFn(text, obj); }
+
+    template <typename Obj>
+    void format(const Obj& obj, CsvWriter& out) const { formatFn(obj, out); }
+};
+
+// Parser and formatter generated from T::csvFields()
+template <typename T>
+class CsvCodec {
+private:
+    template <typename Field>
+    static bool parseField(const Field& f, CsvCursor& cursor, T& obj, CsvStatus& status) {
+        if (!f.presentIn(obj))
+            return true;
+
+        std::string_view text;
+        std::size_t index = cursor.fieldIndex();
+        if (!cursor.next(text)) {
+            status = CsvStatus{ CsvError::MISSING_FIELD, index, f.name };
+            return false;
+        }
+
+        CsvError err = f.parse(text, obj);
+        if (err != CsvError::NONE) {
+            status = CsvStatus{ err, index, f.name };
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Field>
+    static void formatField(const Field& f, const T& obj, CsvWriter& out, bool& first) {
+        if (!f.presentIn(obj))
+            return;
+        if (!first)
+            out.separator();
+        first = false;
+        f.format(obj, out);
+    }
+
+public:
+    // Parses the fields of T from the cursor, stops after the last one
+    static CsvStatus parseFields(CsvCursor& cursor, T& obj) {
+        constexpr auto fieldList = T::csvFields();
+        CsvStatus status;
+        std::apply([&](const auto&... fields) {
+            (parseField(fields, cursor, obj, status) && ...);
+        }, fieldList);
+        return status;
+    }
+
+    // Parses a whole line, extra fields at the end are an error
+    static CsvStatus parse(std::string_view line, T& obj) {
+        CsvCursor cursor(line);
+        CsvStatus status = parseFields(cursor, obj);
+        if (status.ok() && !cursor.atEnd())
+            status = CsvStatus{ CsvError::EXTRA_FIELDS, cursor.fieldIndex(), "" };
+        return status;
+    }
+
+    // Writes the fields of T. With leadingSeparator, a comma goes before the first one.
+    static void formatFields(const T& obj, CsvWriter& out, bool leadingSeparator = false) {
+        constexpr auto fieldList = T::csvFields();
+        bool first = !leadingSeparator;
+        std::apply([&](const auto&... fields) {
+            (formatField(fields, obj, out, first), ...);
+        }, fieldList);
+    }
+
+    // Writes a whole row into [first, last), returns the length or 0 if it didn't fit
+    static std::size_t format(const T& obj, char* first, char* last) {
+        CsvWriter out(first, last);
+        formatFields(obj, out);
+        return out.overflowed() ? 0 : static_cast<std::size_t>(out.position() - first);
+    }
+};
+
+// Helper: runs a buffer writer (returning the length, or 0 if the buffer was too
+// small) with a stack buffer first and bigger heap buffers after that
+template <typename WriteFn>
+std::string csvToString(WriteFn write) {
+    char small[256];
+    std::size_t n = write(small, small + sizeof(small));
+    if (n > 0)
+        return std::string(small, n);
+
+    for (std::size_t cap = sizeof(small) * 4;; cap *= 4) {
+        std::string big(cap, '\0');
+        n = write(&big[0], &big[0] + cap);
+        if (n > 0) {
+            big.resize(n);
+            return big;
+        }
+    }
+}
+
+#endif
\ No newline at end of file
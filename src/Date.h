@@ -0,0 +1,60 @@
+#ifndef DATE_H
+#define DATE_H
+
+#include <cstdint>
+
+/*
+ * Date.h
+ * Calendar helpers for dates stored as day numbers.
+ *
+ * A DayNumber counts days since 1970-01-01 in the proleptic Gregorian
+ * calendar, so the distance between two dates is one subtraction. The
+ * conversions are constexpr and exact for month lengths and leap years
+ * (Howard Hinnant's days_from_civil / civil_from_days algorithms).
+ */
+
+using DayNumber = std::int32_t;
+
+constexpr bool isLeapYear(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+constexpr int daysInMonth(int y, int m) {
+    constexpr int lengths[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return (m == 2 && isLeapYear(y)) ? 29 : lengths[m - 1];
+}
+
+// True if y-m-d is a real calendar day in years 1 to 9999
+constexpr bool isValidDate(int y, int m, int d) {
+    return y >= 1 && y <= 9999 && m >= 1 && m <= 12 && d >= 1 && d <= daysInMonth(y, m);
+}
+
+// y-m-d to day number, y-m-d must be valid
+constexpr DayNumber daysFromCivil(int y, int m, int d) {
+    y -= (m <= 2) ? 1 : 0;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);                        // [0, 399]
+    const unsigned doy = (153u * static_cast<unsigned>(m > 2 ? m - 3 : m + 9) + 2) / 5
+                         + static_cast<unsigned>(d) - 1;                                // [0, 365]
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                         // [0, 146096]
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+// Day number back to y-m-d
+constexpr void civilFromDays(DayNumber z, int& y, int& m, int& d) {
+    z += 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    y = static_cast<int>(yoe) + era * 400 + (m <= 2 ? 1 : 0);
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch is day 0");
+static_assert(daysFromCivil(2000, 3, 1) - daysFromCivil(2000, 2, 28) == 2, "2000 is a leap year");
+static_assert(daysFromCivil(2100, 3, 1) - daysFromCivil(2100, 2, 28) == 1, "2100 is not a leap year");
+
+#endif
\ No newline at end of file
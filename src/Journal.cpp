@@ -0,0 +1,89 @@
+#include "Journal.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*
+ * Journal.cpp
+ * Implements the Journal class declared in Journal.h using POSIX file I/O.
+ */
+
+// Constructor / destructor
+Journal::Journal() : fd(-1), pending(), pendingEntries(0), groupSize(1), lastSeq(0) {}
+
+Journal::~Journal() {
+    close();
+}
+
+bool Journal::open(const std::string& filename, std::size_t size) {
+    close();
+
+    fd = ::open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    groupSize = size > 0 ? size : 1;
+    return fd >= 0;
+}
+
+void Journal::close() {
+    if (fd < 0)
+        return;
+    commit();
+    ::close(fd);
+    fd = -1;
+}
+
+// Numbering
+void Journal::continueAfter(std::uint64_t seq) {
+    lastSeq = seq;
+}
+
+std::uint64_t Journal::lastSequence() const {
+    return lastSeq;
+}
+
+// Buffering
+std::uint64_t Journal::append(std::string_view entry) {
+    if (fd < 0)
+        return 0;
+
+    std::uint64_t seq = ++lastSeq;
+    pending += std::to_string(seq);
+    pending += ',';
+    pending.append(entry.data(), entry.size());
+    pending += '\n';
+    if (++pendingEntries >= groupSize)
+        commit();
+    return seq;
+}
+
+// Group commit: one write and one sync for everything buffered
+bool Journal::commit() {
+    if (fd < 0 || pending.empty())
+        return true;
+
+    const char* p = pending.data();
+    std::size_t left = pending.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            pending.erase(0, static_cast<std::size_t>(p - pending.data()));
+            std::cerr << "Journal write failed, " << pendingEntries << " change(s) not logged" << std::endl;
+            return false;
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+
+    pending.clear();
+    pendingEntries = 0;
+    return ::fdatasync(fd) == 0;
+}
+
+// Checkpoint
+bool Journal::clear() {
+    if (fd < 0)
+        return false;
+
+    pending.clear();
+    pendingEntries = 0;
+    return ::ftruncate(fd, 0) == 0 && ::fdatasync(fd) == 0;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Journal.h
+ * Declares the Journal class, an append-only write-ahead log of library changes.
+ *
+ * The Library appends one short text line per successful change, each
+ * starting with the entry's sequence number:
+ *  - <seq>,B,<recordID>,<userID>,<isbn>,<by>,<bm>,<bd>,<dy>,<dm>,<dd>  borrow
+ *  - <seq>,R,<recordID>,<ry>,<rm>,<rd>,<lateFeePerDay>                  return
+ *  - <seq>,AB,<book CSV row>        add book       - <seq>,RB,<isbn>     remove book
+ *  - <seq>,AU,<user CSV row>        add user       - <seq>,RU,<userID>   remove user
+ *
+ * Sequence numbers keep counting up across checkpoints. A saved data file
+ * records the last sequence number it includes, so replay can tell which
+ * entries a file already has (logs written before numbering have no <seq>).
+ *
+ * Entries are buffered and written with one write() and one fdatasync() per
+ * group (group commit). A group is committed when it reaches groupSize
+ * entries or when commit() is called.
+ *
+ * At startup the log is replayed on top of the last full save. A checkpoint
+ * (full save followed by clear()) folds the log back into the data files.
+ */
+
+class Journal {
+private:
+    int fd;
+    std::string pending;
+    std::size_t pendingEntries;
+    std::size_t groupSize;
+    std::uint64_t lastSeq;
+
+public:
+    Journal();
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Opens (or creates) the log for appending
+    bool open(const std::string& filename, std::size_t groupSize = 64);
+    void close();
+
+    // Numbers entries from seq + 1 on
+    void continueAfter(std::uint64_t seq);
+    std::uint64_t lastSequence() const;
+
+    // Numbers and buffers one entry, commits automatically once a group is full.
+    // Returns the entry's sequence number, 0 if the log isn't open.
+    std::uint64_t append(std::string_view entry);
+
+    // Writes and syncs every buffered entry
+    bool commit();
+
+    // Empties the log, called after a checkpoint
+    bool clear();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,269 @@
+#include "KeywordIndex.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cctype>
+
+/*
+ * KeywordIndex.cpp
+ * Implements the KeywordIndex class declared in KeywordIndex.h.
+ *
+ * Contains logic for:
+ *  - Tokenizing titles, authors and queries
+ *  - Keeping unordered posting lists and each slot's positions in them
+ *  - Answering AND queries from the shortest posting list
+ *  - Writing the index to a snapshot and checking it on the way back in
+ */
+
+// Tokenizer
+std::vector<std::string> KeywordIndex::tokenize(std::string_view text) {
+    std::vector<std::string> terms;
+    std::string current;
+
+    for (char c : text) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc)) {
+            current += static_cast<char>(std::tolower(uc));
+        }
+        else if (!current.empty()) {
+            terms.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty())
+        terms.push_back(current);
+
+    return terms;
+}
+
+// All distinct terms of a book's title and author
+std::vector<std::string> KeywordIndex::termsOf(const Book& book) {
+    std::vector<std::string> terms = tokenize(book.getTitle());
+    std::vector<std::string> authorTerms = tokenize(book.getAuthor());
+    terms.insert(terms.end(), authorTerms.begin(), authorTerms.end());
+
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+    return terms;
+}
+
+// ID of term, taking a freed ID (or a new one) if the term isn't indexed yet
+std::uint32_t KeywordIndex::termID(const std::string& term) {
+    auto it = termIDs.find(term);
+    if (it != termIDs.end())
+        return it->second;
+
+    std::uint32_t id;
+    if (!freeTerms.empty()) {
+        id = freeTerms.back();
+        freeTerms.pop_back();
+        termNames[id] = term;
+    }
+    else {
+        id = static_cast<std::uint32_t>(postings.size());
+        postings.emplace_back();
+        termNames.push_back(term);
+    }
+    termIDs.emplace(term, id);
+    return id;
+}
+
+bool KeywordIndex::hasTerm(std::size_t slot, std::uint32_t term) const {
+    for (const Entry& e : entries[slot])
+        if (e.term == term)
+            return true;
+    return false;
+}
+
+// Index maintenance
+void KeywordIndex::add(std::size_t slot, const Book& book) {
+    if (slot >= entries.size())
+        entries.resize(slot + 1);
+
+    std::vector<Entry>& own = entries[slot];
+    own.clear();
+    for (const auto& term : termsOf(book)) {
+        std::uint32_t id = termID(term);
+        own.push_back(Entry{ id, static_cast<std::uint32_t>(postings[id].size()) });
+        postings[id].push_back(static_cast<std::uint32_t>(slot));
+    }
+}
+
+void KeywordIndex::remove(std::size_t slot) {
+    if (slot >= entries.size())
+        return;
+
+    for (const Entry& e : entries[slot]) {
+        std::vector<std::uint32_t>& list = postings[e.term];
+
+        // Move the last slot of the list into the gap and point its entry there
+        std::uint32_t last = list.back();
+        if (last != slot) {
+            list[e.index] = last;
+            for (Entry& moved : entries[last])
+                if (moved.term == e.term) {
+                    moved.index = e.index;
+                    break;
+                }
+        }
+        list.pop_back();
+
+        if (list.empty()) {
+            termIDs.erase(termNames[e.term]);
+            std::string().swap(termNames[e.term]);
+            std::vector<std::uint32_t>().swap(list);
+            freeTerms.push_back(e.term);
+        }
+    }
+    std::vector<Entry>().swap(entries[slot]);
+}
+
+void KeywordIndex::clear() {
+    termIDs.clear();
+    termNames.clear();
+    postings.clear();
+    freeTerms.clear();
+    entries.clear();
+}
+
+// AND search: walk the shortest posting list, keep the slots that have every other term
+std::vector<std::size_t> KeywordIndex::search(const std::string& query) const {
+    std::vector<std::string> terms = tokenize(query);
+    if (terms.empty())
+        return {};
+
+    std::vector<std::uint32_t> ids;
+    for (const auto& term : terms) {
+        auto it = termIDs.find(term);
+        if (it == termIDs.end())
+            return {};  // one missing word means no book matches
+        ids.push_back(it->second);
+    }
+
+    std::uint32_t shortest = *std::min_element(ids.begin(), ids.end(),
+        [&](std::uint32_t a, std::uint32_t b) { return postings[a].size() < postings[b].size(); });
+
+    std::vector<std::size_t> result;
+    for (std::uint32_t slot : postings[shortest]) {
+        bool all = true;
+        for (std::uint32_t id : ids)
+            if (id != shortest && !hasTerm(slot, id)) {
+                all = false;
+                break;
+            }
+        if (all)
+            result.push_back(slot);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Snapshot section
+void KeywordIndex::save(SnapshotWriter& out, const std::vector<std::uint32_t>& slotRemap) const {
+    out.putStrings(termNames);
+    out.putArray(freeTerms);
+
+    std::vector<std::uint32_t> lengths, slots;
+    lengths.reserve(postings.size());
+    for (const auto& list : postings) {
+        lengths.push_back(static_cast<std::uint32_t>(list.size()));
+        for (std::uint32_t slot : list)
+            slots.push_back(slotRemap[slot]);
+    }
+    out.putArray(lengths);
+    out.putArray(slots);
+
+    // Entries go out in new slot order, so find the old slot of each new one
+    std::vector<std::uint32_t> oldSlots;
+    for (std::size_t old = 0; old < slotRemap.size(); ++old) {
+        std::uint32_t slot = slotRemap[old];
+        if (slot == UINT32_MAX)
+            continue;
+        if (slot >= oldSlots.size())
+            oldSlots.resize(slot + 1, UINT32_MAX);
+        oldSlots[slot] = static_cast<std::uint32_t>(old);
+    }
+
+    std::vector<std::uint32_t> counts;
+    std::vector<Entry> flat, own;
+    counts.reserve(oldSlots.size());
+    for (std::uint32_t old : oldSlots) {
+        own.clear();
+        if (old < entries.size())
+            own = entries[old];
+        std::sort(own.begin(), own.end(), [](const Entry& a, const Entry& b) { return a.term < b.term; });
+        counts.push_back(static_cast<std::uint32_t>(own.size()));
+        flat.insert(flat.end(), own.begin(), own.end());
+    }
+    out.putArray(counts);
+    out.putArray(flat);
+}
+
+// Rebuilt into temporaries and swapped in only once every list checks out:
+// each live term is named once, each posting is a slot below slotCount, and
+// each entry points at a posting holding its own slot (sorted terms rule out
+// two entries for one posting, equal totals rule out unreferenced postings)
+bool KeywordIndex::load(SnapshotReader& in, std::size_t slotCount) {
+    std::vector<std::string_view> names;
+    std::vector<std::uint32_t> freed, lengths, slots, counts;
+    std::vector<Entry> flat;
+    if (!in.getStrings(names) || !in.getArray(freed) || !in.getArray(lengths) || !in.getArray(slots) ||
+        !in.getArray(counts) || !in.getArray(flat))
+        return false;
+
+    const std::size_t terms = names.size();
+    if (lengths.size() != terms || counts.size() != slotCount || flat.size() != slots.size())
+        return false;
+
+    std::vector<bool> isFree(terms, false);
+    for (std::uint32_t t : freed) {
+        if (t >= terms || isFree[t] || !names[t].empty() || lengths[t] != 0)
+            return false;
+        isFree[t] = true;
+    }
+
+    std::unordered_map<std::string, std::uint32_t> loadedIDs;
+    std::vector<std::string> loadedNames(terms);
+    std::vector<std::vector<std::uint32_t>> loadedPostings(terms);
+    loadedIDs.reserve(terms);
+    std::size_t at = 0;
+    for (std::uint32_t t = 0; t < terms; ++t) {
+        if (isFree[t])
+            continue;
+        if (names[t].empty() || lengths[t] == 0 || lengths[t] > slots.size() - at)
+            return false;
+        loadedNames[t] = names[t];
+        if (!loadedIDs.emplace(loadedNames[t], t).second)
+            return false;
+        loadedPostings[t].assign(slots.begin() + at, slots.begin() + at + lengths[t]);
+        at += lengths[t];
+    }
+    if (at != slots.size())
+        return false;
+    for (std::uint32_t slot : slots)
+        if (slot >= slotCount)
+            return false;
+
+    std::vector<std::vector<Entry>> loadedEntries(slotCount);
+    at = 0;
+    for (std::size_t slot = 0; slot < slotCount; ++slot) {
+        if (counts[slot] > flat.size() - at)
+            return false;
+        for (std::size_t i = at; i < at + counts[slot]; ++i) {
+            const Entry& e = flat[i];
+            if (e.term >= terms || (i > at && flat[i - 1].term >= e.term) || e.index >= loadedPostings[e.term].size() ||
+                loadedPostings[e.term][e.index] != slot)
+                return false;
+        }
+        loadedEntries[slot].assign(flat.begin() + at, flat.begin() + at + counts[slot]);
+        at += counts[slot];
+    }
+    if (at != flat.size())
+        return false;
+
+    termIDs.swap(loadedIDs);
+    termNames.swap(loadedNames);
+    postings.swap(loadedPostings);
+    freeTerms.swap(freed);
+    entries.swap(loadedEntries);
+    return true;
+}
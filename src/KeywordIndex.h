@@ -0,0 +1,75 @@
+#ifndef KEYWORD_INDEX_H
+#define KEYWORD_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "Book.h"
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/*
+ * KeywordIndex.h
+ * Declares the KeywordIndex class, an inverted index over book titles and authors.
+ *
+ * Each lowercase word (term) maps to a posting list of book slots (the
+ * Library's stable slot numbers, see SlotMap.h). Posting lists are kept
+ * unordered, and every slot remembers where it sits in each of its terms'
+ * lists, so adding or removing a book is O(its terms) no matter how long the
+ * lists are: removal moves the list's last slot into the gap.
+ *
+ * A multi-word query walks the shortest posting list and keeps the books
+ * whose own term list has every other word, so a search never touches books
+ * that lack the rarest word. Results are sorted once, at the end.
+ *
+ * The Library keeps the index in step with its book list through add()
+ * and remove().
+ *
+ * Snapshot section (save/load): string table of term names by term ID (empty
+ * for freed IDs), uint32 freed term IDs, uint32 posting list lengths, uint32
+ * posting list slots back to back, uint32 entry count per slot, then the
+ * (term, index) entries back to back, each slot's sorted by term ID.
+ */
+
+class KeywordIndex {
+private:
+    // Where a slot sits in one term's posting list
+    struct Entry {
+        std::uint32_t term;
+        std::uint32_t index;
+    };
+
+    std::unordered_map<std::string, std::uint32_t> termIDs;
+    std::vector<std::string> termNames;                // term ID -> word, to drop emptied terms
+    std::vector<std::vector<std::uint32_t>> postings;  // term ID -> slots, unordered
+    std::vector<std::uint32_t> freeTerms;              // IDs of terms whose list emptied
+    std::vector<std::vector<Entry>> entries;           // slot -> one entry per term of its book
+
+    static std::vector<std::string> termsOf(const Book& book);
+    std::uint32_t termID(const std::string& term);
+    bool hasTerm(std::size_t slot, std::uint32_t term) const;
+
+public:
+    // Splits text into lowercase alphanumeric words
+    static std::vector<std::string> tokenize(std::string_view text);
+
+    // Index maintenance
+    void add(std::size_t slot, const Book& book);
+    void remove(std::size_t slot);
+    void clear();
+
+    // Snapshot section (see Snapshot.h). save() renumbers slots through
+    // slotRemap (old slot -> new slot, every indexed slot mapped); load()
+    // replaces the index, returns false and leaves it as it was if the
+    // section is damaged or names a slot >= slotCount.
+    void save(SnapshotWriter& out, const std::vector<std::uint32_t>& slotRemap) const;
+    bool load(SnapshotReader& in, std::size_t slotCount);
+
+    // Returns the sorted slots of books containing every word in query
+    std::vector<std::size_t> search(const std::string& query) const;
+};
+
+#endif
\ No newline at end of file
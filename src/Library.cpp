@@ -1,9 +1,19 @@
 #include "Library.h"
+#include "MappedFile.h"
+#include "CsvCodec.h"
+#include "Journal.h"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
 
 /*
  * Library.cpp
@@ -11,270 +21,1457 @@
  *
  * Contains logic for:
  *  - Searching, adding, and removing books
- *  - Managing users through polymorphic unique_ptr<User>
+ *  - Handing out generation-checked book and user handles
+ *  - Managing users stored by value in a std::variant (UserVariant)
  *  - Creating and updating BorrowRecord objects
  *  - Safe borrowing and returning of books
  *  - Late fee calculations and reporting
+ *  - Keeping the running LibraryStats in step with every change
+ *  - Loading CSV files through a memory mapping, one string_view per line
+ *  - Parsing large record files on several threads
+ *  - Logging every change to the attached Journal and replaying it at startup
+ *  - Dirty tracking, atomic file replacement and append-only record saves
+ *  - Overdue and due-soon lists from the due-date index
+ *  - Projected late fees over the open loan columns
+ *  - Group-by loan reports straight over the record list
+ *  - Catalog and loan shard locking for concurrent desks
  *
  * Ensures the system maintains consistent state and prevents invalid operations.
  */
 
+// First line of books.csv and users.csv, followed by the last journal sequence number they include
+static const char CHECKPOINT_TAG[] = "#checkpoint,";
+
+// Helper: number of copies of a book currently on loan
+static long copiesOutOf(const Book& b) {
+    return static_cast<long>(b.getCopiesTotal()) - static_cast<long>(b.getCopiesAvailable());
+}
+
+// Helper: flush a file's data to disk (fsync works through a read-only descriptor)
+static bool syncFile(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// Helper: flush the directory holding filename, so a rename into it is on disk
+static bool syncDirectoryOf(const std::string& filename) {
+    std::string::size_type slash = filename.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : filename.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// Helper: true if the file is empty or ends with a newline, so rows can be appended to it
+static bool endsWithNewline(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary | std::ios::ate);
+    if (!in.is_open() || in.tellg() <= 0)
+        return true;
+    in.seekg(-1, std::ios::end);
+    return in.get() == '\n';
+}
+
+// Helper: write a file through a temp file that is renamed over the target,
+// so a crash never leaves a half-written data file. The temp file is synced
+// before the rename and the directory after it, so once this returns true
+// the new contents survive a power loss (and the journal may be cleared).
+template <typename WriteRows>
+static bool writeFileAtomically(const std::string& filename, WriteRows writeRows) {
+    std::string tmp = filename + ".tmp";
+    {
+        std::ofstream fout(tmp, std::ios::trunc);
+        if (!fout.is_open())
+            return false;
+
+        writeRows(fout);
+        fout.close();
+        if (!fout || !syncFile(tmp)) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), filename.c_str()) == 0 && syncDirectoryOf(filename);
+}
+
+// Helper: write one CSV row and its newline. writeCSV formats into a stack
+// buffer, rows too long for it fall back to a heap string.
+template <typename WriteCsv>
+static void writeCsvLine(std::ostream& out, WriteCsv writeCSV) {
+    char buf[512];
+    std::size_t n = writeCSV(buf, buf + sizeof(buf) - 1);
+    if (n == 0) {
+        out << csvToString(writeCSV) << '\n';
+        return;
+    }
+    buf[n] = '\n';
+    out.write(buf, static_cast<std::streamsize>(n + 1));
+}
+
 // Private  helpers
+
+// Helper: table[key] = slot, growing the table as new keys come up
+static void setSlot(std::vector<std::uint32_t>& table, std::uint32_t key, std::uint32_t slot) {
+    if (key >= table.size())
+        table.resize(key + 1, OpenLoanColumns::NO_USER);
+    table[key] = slot;
+}
+
+// Helper: table[key], or the NO_SLOT value for keys the table hasn't seen
+static std::uint32_t slotOf(const std::vector<std::uint32_t>& table, std::uint32_t key) {
+    return key < table.size() ? table[key] : OpenLoanColumns::NO_USER;
+}
+
+// Both lookups go through the ISBN index instead of scanning the book list
 Book* Library::findBookByISBN(const std::string& isbn) {
-    for (auto& b : books) {
-        if (b.getISBN() == isbn)
-            return &b;
-    }
-    return nullptr;
+    auto it = bookIndex.find(isbn);
+    if (it == bookIndex.end())
+        return nullptr;
+    return &books.atSlot(it->second);
+}
+
+const Book* Library::findBookByISBN(const std::string& isbn) const {
+    auto it = bookIndex.find(isbn);
+    if (it == bookIndex.end())
+        return nullptr;
+    return &books.atSlot(it->second);
 }
 
 User* Library::findUserByID(const std::string& id) {
-    for (auto& u : users) {
-        if (u->getID() == id)
-            return u.get();
+    auto it = userIndex.find(id);
+    if (it == userIndex.end())
+        return nullptr;
+    return &userOf(users.atSlot(it->second));
+}
+
+const User* Library::findUserByID(const std::string& id) const {
+    auto it = userIndex.find(id);
+    if (it == userIndex.end())
+        return nullptr;
+    return &userOf(users.atSlot(it->second));
+}
+
+// Adds the book in slot to every book index
+void Library::indexBook(std::uint32_t slot) {
+    const Book& b = books.atSlot(slot);
+    bookIndex[b.getISBN()] = slot;
+    setSlot(bookSlotByKey, symbols.isbns.intern(b.getISBN()), slot);
+    indexBookWords(slot);
+}
+
+// Adds the book in slot to the title/author indexes only
+void Library::indexBookWords(std::uint32_t slot) {
+    const Book& b = books.atSlot(slot);
+    keywordIndex.add(slot, b);
+    prefixIndex.add(slot, b);
+}
+
+// Removes the book in slot from every book index
+void Library::unindexBook(std::uint32_t slot) {
+    const Book& b = books.atSlot(slot);
+    bookIndex.erase(b.getISBN());
+    setSlot(bookSlotByKey, symbols.isbns.find(b.getISBN()), NO_SLOT);
+    keywordIndex.remove(slot);
+    prefixIndex.remove(slot);
+}
+
+// Loan shard of a user key, see Locking in Library.h
+Library::LoanShard& Library::shardOf(std::uint32_t userKey) {
+    return loanShards[userKey % LOAN_SHARDS];
+}
+
+const Library::LoanShard& Library::shardOf(std::uint32_t userKey) const {
+    return loanShards[userKey % LOAN_SHARDS];
+}
+
+// Every loan shard shared, in ascending order, for whole-history passes
+std::vector<std::shared_lock<std::shared_mutex>> Library::lockAllShards() const {
+    std::vector<std::shared_lock<std::shared_mutex>> locks;
+    locks.reserve(LOAN_SHARDS);
+    for (const LoanShard& shard : loanShards)
+        locks.emplace_back(shard.lock);
+    return locks;
+}
+
+// logOrderLock, held only while a journal is attached (nothing else is ordered by it)
+std::unique_lock<std::mutex> Library::lockLogOrder() {
+    return journal ? std::unique_lock<std::mutex>(logOrderLock) : std::unique_lock<std::mutex>();
+}
+
+// Records a new user's slot and points their open loan columns at it
+void Library::relinkUserLoans(const std::string& userID, std::uint32_t slot) {
+    std::uint32_t key = symbols.userIDs.intern(userID);
+    setSlot(userSlotByKey, key, slot);
+
+    LoanShard& shard = shardOf(key);
+    if (key / LOAN_SHARDS < shard.openLoansByUser.size()) {
+        for (std::uint64_t id : shard.openLoansByUser[key / LOAN_SHARDS])
+            shard.openLoanColumns.setUser(id, slot);
     }
-    return nullptr;
 }
 
+// Adds (direction 1) or takes out (-1) a user's fees in their shard's fee totals
+void Library::countUserFees(std::uint32_t userKey, double feesDue, int direction) {
+    if (feesDue > 0) {
+        LoanShard& shard = shardOf(userKey);
+        shard.usersWithFees += direction;
+        shard.totalFeesDue += direction * feesDue;
+    }
+}
+
+// Adds an unreturned record to its user's open loan list and the due-date index.
+// Caller holds the record's shard exclusively (or catalogLock).
+void Library::addOpenLoan(const BorrowRecord& rec) {
+    std::uint32_t user = rec.getUserKey();
+    LoanShard& shard = shardOf(user);
+    if (user / LOAN_SHARDS >= shard.openLoansByUser.size())
+        shard.openLoansByUser.resize(user / LOAN_SHARDS + 1);
+    shard.openLoansByUser[user / LOAN_SHARDS].push_back(rec.getRecordID());
+    // New loans are usually due last, the end hint makes that insert O(1)
+    shard.dueIndex.emplace_hint(shard.dueIndex.end(), rec.getDueDay(), rec.getRecordID());
+
+    shard.openLoanColumns.add(rec.getRecordID(), rec.getDueDay(), slotOf(userSlotByKey, user));
+    shard.openLoans++;
+}
+
+// Drops a returned record from its user's open loan list and the due-date index
+void Library::closeOpenLoan(const BorrowRecord& rec) {
+    LoanShard& shard = shardOf(rec.getUserKey());
+    shard.dueIndex.erase({ rec.getDueDay(), rec.getRecordID() });
+    shard.openLoanColumns.remove(rec.getRecordID());
+    shard.openLoans--;
+
+    std::vector<std::uint64_t>& loans = shard.openLoansByUser[rec.getUserKey() / LOAN_SHARDS];
+    for (std::size_t i = 0; i < loans.size(); ++i) {
+        if (loans[i] == rec.getRecordID()) {
+            loans[i] = loans.back();
+            loans.pop_back();
+            break;
+        }
+    }
+    if (loans.empty())
+        std::vector<std::uint64_t>().swap(loans);
+}
+
+// Adds a late fee through the library so the fee totals stay current. Caller
+// holds the user's shard exclusively (or catalogLock).
+void Library::chargeFees(std::uint32_t userKey, User& user, double amt) {
+    bool hadFees = user.getFeesDue() > 0;
+    user.addFees(amt);
+    usersDirty = true;
+
+    LoanShard& shard = shardOf(userKey);
+    shard.totalFeesDue += amt;
+    if (!hadFees && user.getFeesDue() > 0)
+        shard.usersWithFees++;
+}
+
+// Appends an entry to the write-ahead log, if one is attached. Caller holds
+// logOrderLock (or catalogLock exclusively), so entries are numbered in order.
+void Library::logChange(const std::string& entry) {
+    if (!journal)
+        return;
+    std::uint64_t seq = journal->append(entry);
+    if (seq != 0)
+        changeSeq = seq;
+}
+
+// Adds a new record to the history and the open loan indexes. Caller holds
+// the record's shard exclusively (or catalogLock).
+BorrowRecord& Library::appendRecord(const BorrowRecord& rec) {
+    BorrowRecord& added = records.at(records.append(rec));
+    addOpenLoan(added);
+    return added;
+}
+
+// Marks an open record returned and takes it out of the open loan indexes
+void Library::closeRecord(BorrowRecord& rec, int ry, int rm, int rd) {
+    std::size_t position = records.positionOf(rec.getRecordID());
+    records.markReturned(position, daysFromCivil(ry, rm, rd));
+    closeOpenLoan(rec);
+
+    // Returning changes a row that may already be saved, records.csv then needs a rewrite
+    if (position < recordsSaved)
+        recordsRewrite = true;
+}
 
 // Constructor
 Library::Library()
-    : books(), users(), records() {}
+    : books(), users(), records(), symbols(), bookText(), userText(), bookIndex(), userIndex(),
+      nextRecordID(1), copiesOut(0), userSlotByKey(), bookSlotByKey(), loanShards(),
+      keywordIndex(), prefixIndex(), journal(nullptr), parsePool(),
+      catalogLock(), logOrderLock(),
+      booksFile(), usersFile(), recordsFile(),
+      booksDirty(true), usersDirty(true), recordsRewrite(true), recordsSaved(0),
+      changeSeq(0), booksCheckpoint(0), usersCheckpoint(0),
+      rejectedBooks(), rejectedUsers(), rejectedRecords() {}
 
 
 // Book management
 bool Library::addBook(const Book& book) {
+    std::unique_lock lock(catalogLock);
+    return addOneBook(book);
+}
+
+bool Library::addOneBook(const Book& book) {
     if (findBookByISBN(book.getISBN()))
         return false;
 
-    books.push_back(book);
+    indexBook(books.insert(book).slot);
+    copiesOut += copiesOutOf(book);
+    booksDirty = true;
+    logChange("AB," + book.serializeCSV());
     return true;
 }
 
 bool Library::removeBook(const std::string& isbn) {
-    for (auto it = books.begin(); it != books.end(); ++it) {
-        if (it->getISBN() == isbn) {
-            books.erase(it);
-            return true;
-        }
-    }
-    return false;
+    std::unique_lock lock(catalogLock);
+    return removeOneBook(isbn);
+}
+
+// Slots don't move, so only the removed book leaves the indexes
+bool Library::removeOneBook(const std::string& isbn) {
+    auto it = bookIndex.find(isbn);
+    if (it == bookIndex.end())
+        return false;
+
+    std::uint32_t slot = it->second;
+    copiesOut -= copiesOutOf(books.atSlot(slot));
+    unindexBook(slot);
+    books.eraseSlot(slot);
+    booksDirty = true;
+    logChange("RB," + isbn);
+    return true;
+}
+
+std::optional<Book> Library::searchBook(const std::string& isbn) const {
+    std::shared_lock lock(catalogLock);
+    const Book* b = findBookByISBN(isbn);
+    return b ? std::optional<Book>(*b) : std::nullopt;
+}
+
+BookHandle Library::findBook(const std::string& isbn) const {
+    std::shared_lock lock(catalogLock);
+    auto it = bookIndex.find(isbn);
+    if (it == bookIndex.end())
+        return BookHandle();
+    return books.handleOf(it->second);
+}
+
+std::optional<Book> Library::getBook(BookHandle h) const {
+    std::shared_lock lock(catalogLock);
+    const Book* b = books.get(h);
+    return b ? std::optional<Book>(*b) : std::nullopt;
 }
 
-Book* Library::searchBook(const std::string& isbn) {
-    return findBookByISBN(isbn);
+// Books whose title or author contain every word of the query
+std::vector<Book> Library::searchBooksByKeywords(const std::string& query) const {
+    std::shared_lock lock(catalogLock);
+    std::vector<Book> result;
+    for (std::size_t slot : keywordIndex.search(query))
+        result.push_back(books.atSlot(static_cast<std::uint32_t>(slot)));
+    return result;
+}
+
+// Type-ahead: the first books (alphabetically) whose title or author starts with prefix
+std::vector<Book> Library::autocompleteBooks(const std::string& prefix, std::size_t limit) const {
+    std::shared_lock lock(catalogLock);
+    std::vector<Book> result;
+    for (std::size_t slot : prefixIndex.complete(prefix, limit))
+        result.push_back(books.atSlot(static_cast<std::uint32_t>(slot)));
+    return result;
 }
 
 // User management
 bool Library::addUser(std::unique_ptr<User> user) {
+    std::unique_lock lock(catalogLock);
+    return addOneUser(std::move(user));
+}
+
+bool Library::addOneUser(std::unique_ptr<User> user) {
     if (findUserByID(user->getID()))
         return false;
 
-    users.push_back(std::move(user));
+    usersDirty = true;
+    logChange("AU," + user->serializeCSV());
+    std::uint32_t slot = users.insert(User::toVariant(std::move(user))).slot;
+    const User& added = userOf(users.atSlot(slot));
+    userIndex[added.getID()] = slot;
+    relinkUserLoans(added.getID(), slot);
+    countUserFees(symbols.userIDs.find(added.getID()), added.getFeesDue(), 1);
     return true;
 }
 
 bool Library::removeUser(const std::string& id) {
+    std::unique_lock lock(catalogLock);
+    return removeOneUser(id);
+}
+
+// Other users keep their slots, so their open loan columns are left alone
+bool Library::removeOneUser(const std::string& id) {
+    auto it = userIndex.find(id);
+    if (it == userIndex.end())
+        return false;
+
+    // Users holding books can't be removed
+    std::uint32_t key = symbols.userIDs.find(id);
+    const LoanShard& shard = shardOf(key);
+    if (key / LOAN_SHARDS < shard.openLoansByUser.size() && !shard.openLoansByUser[key / LOAN_SHARDS].empty())
+        return false;
+
+    std::uint32_t slot = it->second;
+    userIndex.erase(it);
+    setSlot(userSlotByKey, key, NO_SLOT);
+    countUserFees(key, userOf(users.atSlot(slot)).getFeesDue(), -1);
+
+    users.eraseSlot(slot);
+    usersDirty = true;
+    logChange("RU," + id);
+    return true;
+}
+
+// Fees change under the user's shard lock, so the copy is taken under it too
+std::optional<UserVariant> Library::copyUser(std::uint32_t slot) const {
+    const UserVariant& u = users.atSlot(slot);
+    std::shared_lock shard(shardOf(symbols.userIDs.find(userOf(u).getID())).lock);
+    return u;
+}
+
+std::optional<UserVariant> Library::searchUser(const std::string& id) const {
+    std::shared_lock lock(catalogLock);
+    auto it = userIndex.find(id);
+    if (it == userIndex.end())
+        return std::nullopt;
+    return copyUser(it->second);
+}
+
+UserHandle Library::findUser(const std::string& id) const {
+    std::shared_lock lock(catalogLock);
+    auto it = userIndex.find(id);
+    if (it == userIndex.end())
+        return UserHandle();
+    return users.handleOf(it->second);
+}
+
+std::optional<UserVariant> Library::getUser(UserHandle h) const {
+    std::shared_lock lock(catalogLock);
+    if (!users.get(h))
+        return std::nullopt;
+    return copyUser(h.slot);
+}
+
+bool Library::hasOpenLoans(const std::string& userID) const {
+    std::shared_lock lock(catalogLock);
+    std::uint32_t key = symbols.userIDs.find(userID);
+    const LoanShard& shard = shardOf(key);
+    std::shared_lock loans(shard.lock);
+    return key / LOAN_SHARDS < shard.openLoansByUser.size() && !shard.openLoansByUser[key / LOAN_SHARDS].empty();
+}
+
+// Copies of the given records, taken while the shard holding them is locked
+std::vector<BorrowRecord> Library::copyRecords(const std::vector<std::uint64_t>& ids) const {
+    std::vector<BorrowRecord> result;
+    result.reserve(ids.size());
+    for (std::uint64_t id : ids)
+        result.push_back(*records.find(id));
+    return result;
+}
+
+std::vector<BorrowRecord> Library::getOpenLoans(const std::string& userID) const {
+    std::shared_lock lock(catalogLock);
+    std::uint32_t key = symbols.userIDs.find(userID);
+    const LoanShard& shard = shardOf(key);
+    std::shared_lock loans(shard.lock);
+
+    if (key / LOAN_SHARDS >= shard.openLoansByUser.size())
+        return std::vector<BorrowRecord>();
+    return copyRecords(shard.openLoansByUser[key / LOAN_SHARDS]);
+}
+
+// The tables only grow and their text never moves, so this needs no lock
+const RecordSymbols& Library::getRecordSymbols() const {
+    return symbols;
+}
+
+// Open loans with first <= due day <= last, read off each shard's ordered
+// due-date index and merged by (due day, record ID)
+std::vector<BorrowRecord> Library::loansDueIn(DayNumber first, DayNumber last) const {
+    std::vector<BorrowRecord> result;
+    if (first > last)
+        return result;
+
+    std::shared_lock lock(catalogLock);
+    for (const LoanShard& shard : loanShards) {
+        std::shared_lock loans(shard.lock);
+        auto it = shard.dueIndex.lower_bound({ first, 0 });
+        for (; it != shard.dueIndex.end() && it->first <= last; ++it)
+            result.push_back(*records.find(it->second));
+    }
+
+    std::sort(result.begin(), result.end(), [](const BorrowRecord& a, const BorrowRecord& b) {
+        return a.getDueDay() != b.getDueDay() ? a.getDueDay() < b.getDueDay() : a.getRecordID() < b.getRecordID();
+    });
+    return result;
+}
+
+std::vector<BorrowRecord> Library::getOverdueLoans(DayNumber asOf) const {
+    return loansDueIn(INT32_MIN, asOf - 1);
+}
+
+std::vector<BorrowRecord> Library::getLoansDueWithin(DayNumber from, int days) const {
+    std::int64_t last = std::min<std::int64_t>(static_cast<std::int64_t>(from) + days, INT32_MAX);
+    return loansDueIn(from, static_cast<DayNumber>(last));
+}
+
+// Late days are summed per user as integers, the fee rate is applied once per user
+std::vector<std::pair<std::string, double>> Library::projectLateFees(DayNumber asOf, double lateFeePerDay) const {
+    std::shared_lock lock(catalogLock);
+    std::vector<std::uint64_t> lateDays(users.slotCount(), 0);
+    for (const LoanShard& shard : loanShards) {
+        std::shared_lock loans(shard.lock);
+        shard.openLoanColumns.accrueLateDays(asOf, lateDays);
+    }
+
+    std::vector<std::pair<std::string, double>> result;
     for (auto it = users.begin(); it != users.end(); ++it) {
-        if ((*it)->getID() == id) {
-            users.erase(it);
-            return true;
+        double fee = static_cast<double>(lateDays[it.slot()]) * lateFeePerDay;
+        if (fee > 0)
+            result.emplace_back(userOf(*it).getID(), fee);
+    }
+    return result;
+}
+
+// Plain per-record scan with the same rules as returnBook, shares no state with the columns
+std::vector<std::pair<std::string, double>> Library::projectLateFeesReference(DayNumber asOf, double lateFeePerDay) const {
+    std::shared_lock lock(catalogLock);
+    auto shards = lockAllShards();
+    std::vector<double> fees(users.slotCount(), 0.0);
+    records.forEachRun([&](const BorrowRecord* run, std::size_t n) {
+        for (const BorrowRecord* r = run; r != run + n; ++r) {
+            if (r->isReturned())
+                continue;
+            int late = asOf - r->getDueDay();
+            auto user = userIndex.find(std::string(r->getUserID(symbols)));
+            if (late > 0 && user != userIndex.end())
+                fees[user->second] += late * lateFeePerDay;
         }
+    });
+
+    std::vector<std::pair<std::string, double>> result;
+    for (auto it = users.begin(); it != users.end(); ++it) {
+        if (fees[it.slot()] > 0)
+            result.emplace_back(userOf(*it).getID(), fees[it.slot()]);
     }
-    return false;
+    return result;
 }
 
-User* Library::searchUser(const std::string& id) {
-    return findUserByID(id);
+// Helper: "YYYY-MM" for a BORROW_MONTH group number
+static std::string monthLabel(std::size_t group) {
+    char text[16];
+    std::snprintf(text, sizeof text, "%04d-%02d", static_cast<int>(group / 12), static_cast<int>(group % 12) + 1);
+    return text;
+}
+
+std::vector<LoanGroup> Library::loanReport(LoanGroupBy by, LoanMeasure measure) const {
+    // Each grouping is a key column, a group count and a label per group
+    static const char* const typeLabels[] = { "Student", "Teacher", "Other", "Unknown" };
+    constexpr std::uint32_t UNKNOWN_TYPE = 3;
+
+    std::shared_lock lock(catalogLock);
+    auto shards = lockAllShards();
+
+    LoanKey key = LoanKey::USER;
+    std::vector<std::uint32_t> userTypes; // user symbol -> typeLabels index
+    std::size_t groups = 0;
+
+    switch (by) {
+        case LoanGroupBy::BORROW_MONTH:
+            key = LoanKey::BORROW_MONTH;
+            groups = MONTH_GROUPS;
+            break;
+        case LoanGroupBy::USER_TYPE:
+            userTypes.assign(symbols.userIDs.size(), UNKNOWN_TYPE);
+            for (std::size_t key = 0; key < userSlotByKey.size(); ++key) {
+                if (userSlotByKey[key] != NO_SLOT)
+                    userTypes[key] = static_cast<std::uint32_t>(userOf(users.atSlot(userSlotByKey[key])).getUserType());
+            }
+            groups = 4;
+            break;
+        case LoanGroupBy::USER:
+            groups = symbols.userIDs.size();
+            break;
+        case LoanGroupBy::ISBN:
+            key = LoanKey::BOOK;
+            groups = symbols.isbns.size();
+            break;
+    }
+
+    GroupTotals totals;
+    totals.count.assign(groups, 0);
+    totals.sum.assign(groups, 0);
+    records.forEachColumnRun([&](const RecordLog::ColumnRun& run) {
+        aggregateLoans(run, key, by == LoanGroupBy::USER_TYPE ? &userTypes : nullptr, measure, totals);
+    });
+
+    std::vector<LoanGroup> result;
+    for (std::size_t g = 0; g < groups; ++g) {
+        if (totals.count[g] == 0)
+            continue;
+
+        LoanGroup row;
+        switch (by) {
+            case LoanGroupBy::BORROW_MONTH: row.key = monthLabel(g); break;
+            case LoanGroupBy::USER_TYPE:    row.key = typeLabels[g]; break;
+            case LoanGroupBy::USER:         row.key = symbols.userIDs.name(static_cast<std::uint32_t>(g)); break;
+            case LoanGroupBy::ISBN:         row.key = symbols.isbns.name(static_cast<std::uint32_t>(g)); break;
+        }
+        row.count = totals.count[g];
+        row.sum = totals.sum[g];
+        row.average = static_cast<double>(row.sum) / static_cast<double>(row.count);
+        result.push_back(std::move(row));
+    }
+
+    // Keys are numbered in first-seen order, IDs are listed in text order
+    if (by == LoanGroupBy::USER || by == LoanGroupBy::ISBN)
+        std::sort(result.begin(), result.end(), [](const LoanGroup& a, const LoanGroup& b) { return a.key < b.key; });
+    return result;
 }
 
 // Borrow a book
 bool Library::borrowBook(const std::string& userID, const std::string& isbn,
                          int by, int bm, int bd, int dy, int dm, int dd)
 {
+    std::shared_lock lock(catalogLock);
+    return borrowOne(userID, isbn, by, bm, bd, dy, dm, dd) == ChangeStatus::OK;
+}
+
+// Caller holds catalogLock. The copy is taken with Book's atomic borrowOne and
+// the record goes to the user's loan shard, so desks serving users in
+// different shards don't wait for each other.
+ChangeStatus Library::borrowOne(const std::string& userID, const std::string& isbn,
+                                int by, int bm, int bd, int dy, int dm, int dd,
+                                std::uint64_t* newRecordID)
+{
+    if (!isValidDate(by, bm, bd) || !isValidDate(dy, dm, dd))
+        return ChangeStatus::INVALID_DATE;
+
     User* user = findUserByID(userID);
-    if (!user) return false;
+    if (!user) return ChangeStatus::UNKNOWN_USER;
 
-    Book* book = findBookByISBN(isbn);
-    if (!book) return false;
+    auto it = bookIndex.find(isbn);
+    if (it == bookIndex.end()) return ChangeStatus::UNKNOWN_BOOK;
 
-    if (!book->borrowOne()) return false;
+    std::unique_lock loans(shardOf(symbols.userIDs.find(userID)).lock);
+    std::uint64_t id;
+    {
+        std::unique_lock logOrder = lockLogOrder();
+        if (!books.atSlot(it->second).borrowOne()) return ChangeStatus::NO_COPIES;
 
-    // Create borrow record ID
-    std::string recID = "REC" + std::to_string(records.size() + 1);
+        // Take the next ID from the sequence
+        id = nextRecordID++;
+        logChange("B," + std::to_string(id) + "," + userID + "," + isbn + ","
+                  + std::to_string(by) + "," + std::to_string(bm) + "," + std::to_string(bd) + ","
+                  + std::to_string(dy) + "," + std::to_string(dm) + "," + std::to_string(dd));
+    }
+    appendRecord(BorrowRecord(id, symbols, userID, isbn, by, bm, bd, dy, dm, dd));
 
-    BorrowRecord rec(recID, userID, isbn, by, bm, bd, dy, dm, dd);
-    records.push_back(rec);
-    return true;
+    copiesOut++;
+    booksDirty = true;
+
+    if (newRecordID)
+        *newRecordID = id;
+    return ChangeStatus::OK;
 }
 
 // Return a book
+bool Library::returnBook(std::uint64_t recordID,
+                         int ry, int rm, int rd,
+                         double lateFeePerDay)
+{
+    std::shared_lock lock(catalogLock);
+    return returnOne(recordID, ry, rm, rd, lateFeePerDay) == ChangeStatus::OK;
+}
+
+// Caller holds catalogLock. A record's user never changes, so the record alone
+// tells which shard to lock; everything else is read once that is held.
+ChangeStatus Library::returnOne(std::uint64_t recordID,
+                                int ry, int rm, int rd,
+                                double lateFeePerDay)
+{
+    BorrowRecord* rec = records.find(recordID);
+    if (!rec)
+        return ChangeStatus::UNKNOWN_RECORD;
+
+    std::uint32_t userKey = rec->getUserKey();
+    std::unique_lock loans(shardOf(userKey).lock);
+    if (rec->isReturned())
+        return ChangeStatus::ALREADY_RETURNED;
+    if (!isValidDate(ry, rm, rd))
+        return ChangeStatus::INVALID_DATE;
+
+    closeRecord(*rec, ry, rm, rd);
+
+    std::uint32_t bookSlot = slotOf(bookSlotByKey, rec->getBookKey());
+    char fee[32];
+    *std::to_chars(fee, fee + sizeof(fee) - 1, lateFeePerDay).ptr = '\0';
+    {
+        std::unique_lock logOrder = lockLogOrder();
+        if (bookSlot != NO_SLOT && books.atSlot(bookSlot).returnOne()) {
+            copiesOut--;
+            booksDirty = true;
+        }
+        logChange("R," + std::to_string(recordID) + "," + std::to_string(ry) + ","
+                  + std::to_string(rm) + "," + std::to_string(rd) + "," + fee);
+    }
+
+    // Late fees
+    int late = rec->daysLate();
+    std::uint32_t userSlot = slotOf(userSlotByKey, userKey);
+    if (late > 0 && userSlot != NO_SLOT)
+        chargeFees(userKey, userOf(users.atSlot(userSlot)), late * lateFeePerDay);
+    return ChangeStatus::OK;
+}
+
+// Accepts the "REC<n>" form shown to users
 bool Library::returnBook(const std::string& recordID,
                          int ry, int rm, int rd,
                          double lateFeePerDay)
 {
-    for (auto& rec : records) {
-        if (rec.getRecordID() == recordID) {
+    std::uint64_t id;
+    if (!BorrowRecord::parseRecordID(recordID, id))
+        return false;
+    return returnBook(id, ry, rm, rd, lateFeePerDay);
+}
 
-            if (rec.isReturned())
-                return false;
+// Bulk changes
+std::vector<ChangeStatus> Library::addBooks(std::vector<Book> batch) {
+    std::unique_lock lock(catalogLock);
+    std::vector<ChangeStatus> result;
+    result.reserve(batch.size());
+    books.reserve(books.size() + batch.size());
+    bookIndex.reserve(bookIndex.size() + batch.size());
 
-            rec.markReturned(ry, rm, rd);
+    for (Book& b : batch) {
+        // One probe covers existing books and earlier books of this batch
+        auto entry = bookIndex.try_emplace(b.getISBN(), NO_SLOT);
+        if (!entry.second) {
+            result.push_back(ChangeStatus::DUPLICATE);
+            continue;
+        }
 
-            Book* b = findBookByISBN(rec.getISBN());
-            if (b)
-                b->returnOne();
+        logChange("AB," + b.serializeCSV());
+        copiesOut += copiesOutOf(b);
+        std::uint32_t slot = books.insert(std::move(b)).slot;
+        entry.first->second = slot;
+        setSlot(bookSlotByKey, symbols.isbns.intern(entry.first->first), slot);
+        indexBookWords(slot);
+        booksDirty = true;
+        result.push_back(ChangeStatus::OK);
+    }
+    return result;
+}
 
-            // Late fees
-            int late = rec.daysLate();
-            if (late > 0) {
-                User* u = findUserByID(rec.getUserID());
-                if (u)
-                    u->addFees(late * lateFeePerDay);
-            }
+std::vector<ChangeStatus> Library::addUsers(std::vector<std::unique_ptr<User>> batch) {
+    std::unique_lock lock(catalogLock);
+    std::vector<ChangeStatus> result;
+    result.reserve(batch.size());
+    users.reserve(users.size() + batch.size());
+    userIndex.reserve(userIndex.size() + batch.size());
 
-            return true;
+    for (auto& user : batch) {
+        auto entry = userIndex.try_emplace(user->getID(), NO_SLOT);
+        if (!entry.second) {
+            result.push_back(ChangeStatus::DUPLICATE);
+            continue;
         }
+
+        logChange("AU," + user->serializeCSV());
+        double fees = user->getFeesDue();
+        entry.first->second = users.insert(User::toVariant(std::move(user))).slot;
+        relinkUserLoans(entry.first->first, entry.first->second);
+        countUserFees(symbols.userIDs.find(entry.first->first), fees, 1);
+        usersDirty = true;
+        result.push_back(ChangeStatus::OK);
     }
-    return false;
+    return result;
+}
+
+std::vector<ChangeStatus> Library::borrowMany(const std::vector<BorrowRequest>& batch,
+                                              std::vector<std::uint64_t>* recordIDs)
+{
+    std::shared_lock lock(catalogLock);
+    std::vector<ChangeStatus> result;
+    result.reserve(batch.size());
+    if (recordIDs) {
+        recordIDs->clear();
+        recordIDs->reserve(batch.size());
+    }
+
+    for (const BorrowRequest& r : batch) {
+        std::uint64_t id = 0;
+        result.push_back(borrowOne(r.userID, r.isbn, r.by, r.bm, r.bd, r.dy, r.dm, r.dd, &id));
+        if (recordIDs)
+            recordIDs->push_back(id);
+    }
+    return result;
+}
+
+std::vector<ChangeStatus> Library::returnMany(const std::vector<ReturnRequest>& batch) {
+    std::shared_lock lock(catalogLock);
+    std::vector<ChangeStatus> result;
+    result.reserve(batch.size());
+
+    for (const ReturnRequest& r : batch)
+        result.push_back(returnOne(r.recordID, r.ry, r.rm, r.rd, r.lateFeePerDay));
+    return result;
 }
 
 // Reporting
 int Library::getTotalBooks() const {
+    std::shared_lock lock(catalogLock);
     return books.size();
 }
 
 int Library::getTotalUsers() const {
+    std::shared_lock lock(catalogLock);
     return users.size();
 }
 
 int Library::getBorrowedCount() const {
-    int count = 0;
-    for (const auto& r : records)
-        if (!r.isReturned())
-            count++;
-    return count;
+    return getStats().openLoans;
 }
 
 int Library::getAvailableCopies(const std::string& isbn) const {
-    for (const auto& b : books)
-        if (b.getISBN() == isbn)
-            return b.getCopiesAvailable();
-    return -1;
+    std::shared_lock lock(catalogLock);
+    auto it = bookIndex.find(isbn);
+    if (it == bookIndex.end())
+        return -1;
+    return books.atSlot(it->second).getCopiesAvailable();
 }
 
-// Display
+// Every shard is held at once, so the totals are from one moment
+LibraryStats Library::getStats() const {
+    std::shared_lock lock(catalogLock);
+    auto shards = lockAllShards();
+
+    LibraryStats stats;
+    stats.copiesOut = copiesOut;
+    for (const LoanShard& shard : loanShards) {
+        stats.openLoans += shard.openLoans;
+        stats.usersWithFees += shard.usersWithFees;
+        stats.totalFeesDue += shard.totalFeesDue;
+    }
+    return stats;
+}
+
+// Display. Books and users are shown with the catalog to themselves, so no
+// borrow or return changes them halfway through.
 void Library::displayAllBooks() const {
+    std::unique_lock lock(catalogLock);
     for (const auto& b : books)
         b.display(std::cout);
 }
 
 void Library::displayAllUsers() const {
+    std::unique_lock lock(catalogLock);
     for (const auto& u : users)
-        u->display(std::cout);
+        displayUser(u, std::cout);
 }
 
 void Library::displayAllRecords() const {
-    for (const auto& r : records)
-        r.display(std::cout);
+    std::unique_lock lock(catalogLock);
+    records.forEachRun([this](const BorrowRecord* run, std::size_t n) {
+        for (const BorrowRecord* r = run; r != run + n; ++r)
+            r->display(symbols, std::cout);
+    });
+}
+
+// Loading helpers, shared by the CSV loaders (loadSnapshot uses the clear helpers)
+void Library::clearBooks() {
+    books.clear();
+    bookText.clear();
+    bookIndex.clear();
+    bookSlotByKey.clear();
+    keywordIndex.clear();
+    prefixIndex.clear();
+    copiesOut = 0;
+    rejectedBooks.clear();
+    booksFile.clear();
+    booksDirty = true;
+    booksCheckpoint = 0;
+}
+
+// Adds a loaded book, returns false (and drops it) if its ISBN is already taken
+bool Library::appendLoadedBook(Book b) {
+    if (bookIndex.count(b.getISBN())) {
+        booksDirty = true; // the saved file still has the duplicate
+        return false;
+    }
+
+    copiesOut += copiesOutOf(b);
+    indexBook(books.insert(std::move(b)).slot);
+    return true;
+}
+
+void Library::clearUsers() {
+    users.clear();
+    userText.clear();
+    userIndex.clear();
+    userSlotByKey.clear();
+    for (LoanShard& shard : loanShards) {
+        shard.openLoanColumns.unlinkUsers();
+        shard.usersWithFees = 0;
+        shard.totalFeesDue = 0.0;
+    }
+    rejectedUsers.clear();
+    usersFile.clear();
+    usersDirty = true;
+    usersCheckpoint = 0;
+}
+
+// Adds a loaded user, returns false (and drops it) if its ID is already taken
+bool Library::appendLoadedUser(UserVariant u) {
+    const User& user = userOf(u);
+    if (userIndex.count(user.getID())) {
+        usersDirty = true;
+        return false;
+    }
+
+    double fees = user.getFeesDue();
+    std::uint32_t slot = users.insert(std::move(u)).slot;
+    const std::string& id = userOf(users.atSlot(slot)).getID();
+    userIndex[id] = slot;
+    relinkUserLoans(id, slot);
+    countUserFees(symbols.userIDs.find(id), fees, 1);
+    return true;
+}
+
+void Library::clearRecords() {
+    records.clear();
+    nextRecordID = 1;
+    for (LoanShard& shard : loanShards) {
+        shard.openLoans = 0;
+        shard.openLoansByUser.clear();
+        shard.dueIndex.clear();
+        shard.openLoanColumns.clear();
+    }
+    rejectedRecords.clear();
+    recordsFile.clear();
+    recordsRewrite = true;
+    recordsSaved = 0;
+}
+
+// Adds a loaded record. position is the record's 1-based place in the file.
+// Loaded IDs are kept unless they are 0, larger than the record log's ID table
+// should be grown to for this many records (gaps left by hand-deleted rows are fine), or
+// already taken
+bool Library::isLoadableID(std::uint64_t id, std::size_t recordCount) {
+    return id != 0 && id <= recordCount + MAX_RECORD_ID_GAP;
+}
+
+// First pass of a load: new IDs, including the ones given to renumbered rows,
+// start after every ID the load keeps
+void Library::noteLoadedID(std::uint64_t id, std::size_t recordCount) {
+    if (isLoadableID(id, recordCount) && id >= nextRecordID)
+        nextRecordID = id + 1;
+}
+
+void Library::appendLoadedRecord(BorrowRecord r, std::size_t recordCount) {
+    std::uint64_t id = r.getRecordID();
+    if (!isLoadableID(id, recordCount) || records.find(id)) {
+        r.setRecordID(nextRecordID++);
+        recordsRewrite = true;
+        std::cerr << "Reassigned record ID " << BorrowRecord::formatRecordID(id)
+                  << " to " << BorrowRecord::formatRecordID(r.getRecordID()) << std::endl;
+    }
+
+    const BorrowRecord& added = records.at(records.append(r));
+    if (!added.isReturned())
+        addOpenLoan(added);
 }
 
 // Book file loading
 bool Library::loadBooks(const std::string& filename) {
-    std::ifstream fin(filename);
-    if (!fin.is_open())
+    MappedFile file;
+    if (!file.open(filename))
         return false;
 
-    books.clear();
-    std::string line;
+    std::unique_lock lock(catalogLock);
+    clearBooks();
+    booksDirty = false;
+    std::string_view line;
 
-    while (std::getline(fin, line)) {
+    while (file.nextLine(line)) {
         if (line.empty()) continue;
+        if (readCheckpoint(line, booksCheckpoint)) continue;
 
-        try {
-            books.push_back(Book::deserializeCSV(line));
+        Book b;
+        CsvStatus status = Book::parseCSV(line, b, &bookText);
+        if (!status.ok()) {
+            std::cerr << "Error parsing book line (" << status.describe() << "), kept as is: " << line << std::endl;
+            rejectedBooks.emplace_back(line);
+            continue;
         }
-        catch (...) {
-            std::cerr << "Error parsing book line: " << line << std::endl;
+
+        // First row for an ISBN wins, later duplicates are reported and skipped
+        if (!appendLoadedBook(std::move(b))) {
+            std::cerr << "Duplicate ISBN in book line, kept as is: " << line << std::endl;
+            rejectedBooks.emplace_back(line);
         }
     }
+    booksFile = filename;
     return true;
 }
 
-bool Library::saveBooks(const std::string& filename) const {
-    std::ofstream fout(filename);
-    if (!fout.is_open())
-        return false;
-
-    for (const auto& b : books)
-        fout << b.serializeCSV() << "\n";
+bool Library::saveBooks(const std::string& filename) {
+    std::unique_lock lock(catalogLock);
+    if (!booksDirty && filename == booksFile)
+        return true;
 
-    return true;
+    bool ok = writeFileAtomically(filename, [this](std::ostream& out) {
+        if (changeSeq != 0)
+            out << CHECKPOINT_TAG << changeSeq << '\n';
+        for (const auto& b : books)
+            writeCsvLine(out, [&b](char* first, char* last) { return b.writeCSV(first, last); });
+        for (const auto& line : rejectedBooks)
+            out << line << '\n';
+    });
+    if (ok) {
+        booksFile = filename;
+        booksDirty = false;
+        booksCheckpoint = changeSeq;
+    }
+    return ok;
 }
 
 // User File Loading
 bool Library::loadUsers(const std::string& filename) {
-    std::ifstream fin(filename);
-    if (!fin.is_open())
+    MappedFile file;
+    if (!file.open(filename))
         return false;
 
-    users.clear();
-    std::string line;
+    std::unique_lock lock(catalogLock);
+    clearUsers();
+    usersDirty = false;
+    std::string_view line;
 
-    while (std::getline(fin, line)) {
+    while (file.nextLine(line)) {
         if (line.empty()) continue;
+        if (readCheckpoint(line, usersCheckpoint)) continue;
 
-        try {
-            std::unique_ptr<User> u = User::deserializeCSV(line);
-            users.push_back(std::move(u));
-        } catch (...) {
-            std::cerr << "Error parsing user line: " << line << std::endl;
+        UserVariant u;
+        CsvStatus status = User::parseCSV(line, u, &userText);
+        if (!status.ok()) {
+            std::cerr << "Error parsing user line (" << status.describe() << "), kept as is: " << line << std::endl;
+            rejectedUsers.emplace_back(line);
+            continue;
+        }
+
+        if (!appendLoadedUser(std::move(u))) {
+            std::cerr << "Duplicate user ID in user line, kept as is: " << line << std::endl;
+            rejectedUsers.emplace_back(line);
         }
     }
+    usersFile = filename;
     return true;
 }
 
-bool Library::saveUsers(const std::string& filename) const {
-    std::ofstream fout(filename);
-    if (!fout.is_open())
-        return false;
+bool Library::saveUsers(const std::string& filename) {
+    std::unique_lock lock(catalogLock);
+    if (!usersDirty && filename == usersFile)
+        return true;
 
-    for (const auto& u : users) {
-        fout << u ->serializeCSV() << std::endl;
+    bool ok = writeFileAtomically(filename, [this](std::ostream& out) {
+        if (changeSeq != 0)
+            out << CHECKPOINT_TAG << changeSeq << '\n';
+        for (const auto& u : users)
+            writeCsvLine(out, [&u](char* first, char* last) { return writeUserCSV(u, first, last); });
+        for (const auto& line : rejectedUsers)
+            out << line << '\n';
+    });
+    if (ok) {
+        usersFile = filename;
+        usersDirty = false;
+        usersCheckpoint = changeSeq;
     }
-    return true;
+    return ok;
+}
+
+// Records parsed from one newline-aligned piece of records.csv
+struct RecordChunk {
+    std::string_view text;
+    std::vector<StagedBorrowRecord> records; // IDs not interned yet, parsing may run on any thread
+    std::vector<std::pair<std::string_view, CsvStatus>> errors; // lines that failed to parse
+};
+
+// Helper: parse every line of a chunk, used by both the serial and parallel paths
+static void parseRecordChunk(RecordChunk& chunk) {
+    MappedFile::LineReader reader(chunk.text);
+    std::string_view line;
+
+    while (reader.next(line)) {
+        if (line.empty()) continue;
+
+        StagedBorrowRecord r;
+        CsvStatus status = BorrowRecord::parseCSV(line, r);
+        if (!status.ok()) {
+            chunk.errors.emplace_back(line, status);
+            continue;
+        }
+        chunk.records.push_back(std::move(r));
+    }
+}
+
+// Helper: split text into up to n pieces that each end on a line boundary
+static std::vector<RecordChunk> splitIntoChunks(std::string_view text, unsigned n) {
+    std::vector<RecordChunk> chunks;
+    std::size_t begin = 0;
+
+    for (unsigned i = 1; i <= n && begin < text.size(); ++i) {
+        std::size_t end = text.size();
+        if (i < n) {
+            std::size_t nl = text.find('\n', std::max(begin, text.size() / n * i));
+            if (nl != std::string_view::npos)
+                end = nl + 1;
+        }
+        chunks.emplace_back();
+        chunks.back().text = text.substr(begin, end - begin);
+        begin = end;
+    }
+    return chunks;
 }
 
 // Borrow record file loading
-bool Library::loadRecords(const std::string& filename) {
-    std::ifstream fin(filename);
-    if (!fin.is_open())
+// The file is cut into one chunk per thread, the chunks are parsed in parallel,
+// and the results are merged in file order. Chunking only changes who parses a
+// line, so the loaded records are the same as with threads = 1.
+bool Library::loadRecords(const std::string& filename, unsigned threads) {
+    MappedFile file;
+    if (!file.open(filename))
         return false;
 
-    records.clear();
-    std::string line;
+    // Threads aren't worth starting for small files
+    const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+    std::string_view text = file.contents();
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, text.size() / MIN_CHUNK_BYTES + 1));
 
-    while (std::getline(fin, line)) {
-        if (line.empty()) continue;
+    std::vector<RecordChunk> chunks = splitIntoChunks(text, threads);
+    if (chunks.size() == 1)
+        parseRecordChunk(chunks[0]);
+    else
+        parsePool.parallelFor(chunks.size(), [&](std::size_t i) { parseRecordChunk(chunks[i]); });
 
-        try {
-            BorrowRecord r = BorrowRecord::deserialize(line);
-            records.push_back(r);
+    // Parsed without the lock, merged (and interned) with the library to ourselves
+    std::unique_lock lock(catalogLock);
+    clearRecords();
+    recordsRewrite = false;
+
+    std::size_t total = 0;
+    for (const auto& chunk : chunks)
+        total += chunk.records.size();
+
+    for (const auto& chunk : chunks)
+        for (const auto& r : chunk.records)
+            noteLoadedID(r.getRecordID(), total);
+
+    for (const auto& chunk : chunks)
+        for (const auto& bad : chunk.errors) {
+            std::cerr << "Error parsing record line (" << bad.second.describe() << "), kept as is: " << bad.first << std::endl;
+            rejectedRecords.emplace_back(bad.first);
         }
-        catch (...) {
-            std::cerr << "Error parsing record line: " << line << std::endl;
+
+    // Merge in file order. User IDs and ISBNs are interned here, on this thread,
+    // a batch at a time so the symbol table lookups of a batch overlap.
+    constexpr std::size_t BATCH = SymbolTable::BATCH;
+    std::string_view userText[BATCH], isbnText[BATCH];
+    std::uint32_t userKeys[BATCH], bookKeys[BATCH];
+
+    for (auto& chunk : chunks) {
+        for (std::size_t base = 0; base < chunk.records.size(); base += BATCH) {
+            const std::size_t n = std::min(BATCH, chunk.records.size() - base);
+            for (std::size_t i = 0; i < n; ++i) {
+                userText[i] = chunk.records[base + i].userText;
+                isbnText[i] = chunk.records[base + i].isbnText;
+            }
+            symbols.userIDs.internMany(userText, n, userKeys);
+            symbols.isbns.internMany(isbnText, n, bookKeys);
+
+            for (std::size_t i = 0; i < n; ++i) {
+                StagedBorrowRecord& r = chunk.records[base + i];
+                r.resolve(userKeys[i], bookKeys[i]);
+                appendLoadedRecord(std::move(r), total);
+            }
         }
+
+        // Release each chunk's copies as soon as they're merged
+        std::vector<StagedBorrowRecord>().swap(chunk.records);
     }
+    recordsFile = filename;
+    recordsSaved = records.size();
     return true;
 }
 
-bool Library::saveRecords(const std::string& filename) const {
-    std::ofstream fout(filename);
-    if (!fout.is_open())
+// records.csv only grows at the end: unless a saved row changed (a return),
+// only the records added since the last load or save are appended
+bool Library::saveRecords(const std::string& filename) {
+    std::unique_lock lock(catalogLock);
+    bool ok;
+
+    if (filename == recordsFile && !recordsRewrite) {
+        if (recordsSaved == records.size())
+            return true;
+
+        // A hand-edited file may have lost its final newline
+        bool terminated = endsWithNewline(filename);
+        std::ofstream fout(filename, std::ios::app);
+        ok = fout.is_open();
+        if (ok && !terminated)
+            fout << '\n';
+        for (std::size_t i = recordsSaved; ok && i < records.size(); ++i) {
+            const BorrowRecord& r = records.at(i);
+            writeCsvLine(fout, [&](char* first, char* last) { return r.writeCSV(symbols, first, last); });
+        }
+        fout.close();
+        ok = ok && fout && syncFile(filename);
+    }
+    else {
+        ok = writeFileAtomically(filename, [this](std::ostream& out) {
+            records.forEachRun([&](const BorrowRecord* run, std::size_t n) {
+                for (const BorrowRecord* r = run; r != run + n; ++r)
+                    writeCsvLine(out, [&](char* first, char* last) { return r->writeCSV(symbols, first, last); });
+            });
+            for (const auto& line : rejectedRecords)
+                out << line << '\n';
+        });
+    }
+
+    if (ok) {
+        recordsFile = filename;
+        recordsRewrite = false;
+        recordsSaved = records.size();
+    }
+    return ok;
+}
+
+bool Library::hasUnsavedChanges() const {
+    std::shared_lock lock(catalogLock);
+    return booksDirty || usersDirty || recordsRewrite || recordsSaved != records.size();
+}
+
+void Library::markSavedTo(const std::string& booksFilename, const std::string& usersFilename,
+                          const std::string& recordsFilename) {
+    std::unique_lock lock(catalogLock);
+    booksFile = booksFilename;
+    usersFile = usersFilename;
+    recordsFile = recordsFilename;
+    booksDirty = usersDirty = recordsRewrite = false;
+    recordsSaved = records.size();
+}
+
+// Write-ahead log
+void Library::attachJournal(Journal* j) {
+    std::unique_lock lock(catalogLock);
+    journal = j;
+    if (journal)
+        journal->continueAfter(std::max(changeSeq.load(), journal->lastSequence()));
+}
+
+// "#checkpoint,<seq>" lines of books.csv and users.csv. Returns false for any other line.
+bool Library::readCheckpoint(std::string_view line, std::uint64_t& checkpoint) {
+    std::string_view tag = CHECKPOINT_TAG;
+    if (line.substr(0, tag.size()) != tag)
+        return false;
+
+    std::string_view digits = line.substr(tag.size());
+    std::uint64_t seq = 0;
+    auto [end, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), seq);
+    if (ec != std::errc() || end != digits.data() + digits.size()) {
+        std::cerr << "Bad checkpoint line: " << line << std::endl;
+        return true;
+    }
+    checkpoint = seq;
+    changeSeq = std::max(changeSeq.load(), seq);
+    return true;
+}
+
+// Helper: the next field of a journal entry as a number, the whole field must parse
+template <typename N>
+static bool nextNumber(CsvCursor& fields, N& value) {
+    std::string_view text;
+    return fields.next(text) && CsvFormat<N>::parse(text, value) == CsvError::NONE;
+}
+
+// Helper: the next field of a journal entry as a record ID
+static bool nextRecordIDField(CsvCursor& fields, std::uint64_t& id) {
+    std::string_view text;
+    return fields.next(text) && BorrowRecord::parseRecordID(text, id);
+}
+
+// A logged borrow (<id>,<userID>,<isbn>,<by>,<bm>,<bd>,<dy>,<dm>,<dd>), split by
+// file: the record is recreated unless records.csv already has it, the copy is
+// taken only if books.csv is older than the entry. IDs are held to the same
+// limit as IDs loaded from records.csv, counting the record this entry adds.
+bool Library::replayBorrow(CsvCursor& fields, bool takeCopy) {
+    std::uint64_t id;
+    std::string_view userID, isbn;
+    int by, bm, bd, dy, dm, dd;
+    bool parsed = nextRecordIDField(fields, id) && fields.next(userID) && fields.next(isbn) &&
+                  nextNumber(fields, by) && nextNumber(fields, bm) && nextNumber(fields, bd) &&
+                  nextNumber(fields, dy) && nextNumber(fields, dm) && nextNumber(fields, dd) &&
+                  fields.atEnd();
+    if (!parsed || !isValidDate(by, bm, bd) || !isValidDate(dy, dm, dd) || !isLoadableID(id, records.size() + 1))
         return false;
 
-    for (const auto& r : records)
-        fout << r.serialize() << "\n";
+    auto book = bookIndex.find(std::string(isbn));
+    bool applied = false;
 
+    if (!records.find(id)) {
+        appendRecord(BorrowRecord(id, symbols, userID, isbn, by, bm, bd, dy, dm, dd));
+        if (id >= nextRecordID)
+            nextRecordID = id + 1;
+        applied = true;
+    }
+    if (takeCopy && book != bookIndex.end() && books.atSlot(book->second).borrowOne()) {
+        copiesOut++;
+        booksDirty = true;
+        applied = true;
+    }
+    return applied;
+}
+
+// A logged return (<id>,<ry>,<rm>,<rd>,<lateFeePerDay>), split the same way: the
+// record is closed if records.csv has it open, the copy goes back if books.csv
+// is older than the entry, and the fee is charged if users.csv is
+bool Library::replayReturn(CsvCursor& fields, bool returnCopy, bool chargeFee) {
+    std::uint64_t id;
+    int ry, rm, rd;
+    double lateFeePerDay;
+    bool parsed = nextRecordIDField(fields, id) && nextNumber(fields, ry) && nextNumber(fields, rm) &&
+                  nextNumber(fields, rd) && nextNumber(fields, lateFeePerDay) && fields.atEnd();
+    if (!parsed || !isValidDate(ry, rm, rd))
+        return false;
+
+    BorrowRecord* rec = records.find(id);
+    if (!rec)
+        return false;
+    bool applied = false;
+
+    if (!rec->isReturned()) {
+        closeRecord(*rec, ry, rm, rd);
+        applied = true;
+    }
+
+    std::uint32_t bookSlot = slotOf(bookSlotByKey, rec->getBookKey());
+    if (returnCopy && bookSlot != NO_SLOT && books.atSlot(bookSlot).returnOne()) {
+        copiesOut--;
+        booksDirty = true;
+        applied = true;
+    }
+
+    std::uint32_t userSlot = slotOf(userSlotByKey, rec->getUserKey());
+    int late = rec->daysLate();
+    if (chargeFee && late > 0 && userSlot != NO_SLOT) {
+        chargeFees(rec->getUserKey(), userOf(users.atSlot(userSlot)), late * lateFeePerDay);
+        applied = true;
+    }
+    return applied;
+}
+
+// Re-applies logged changes on top of the data loaded from the last save.
+// Numbered entries are applied per data file: only the parts that are newer
+// than the checkpoint of books.csv, users.csv (or, for records, than the
+// record's own state in records.csv) are redone. So replaying a log whose
+// checkpoint didn't finish clearing it, or one that was only partly saved,
+// leaves each file's state as it was plus exactly the changes it misses.
+// Entries that aren't numbered, or whose fields don't parse in full, are skipped.
+bool Library::replayJournal(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename))
+        return false;
+
+    // Replay runs alone
+    std::unique_lock lock(catalogLock);
+
+    // Changes made during replay are already in the log
+    Journal* attached = journal;
+    journal = nullptr;
+
+    std::string_view text = file.contents();
+
+    // A crash can leave the last entry half written, it has no newline yet
+    std::size_t complete = text.rfind('\n');
+    text = (complete == std::string_view::npos) ? std::string_view() : text.substr(0, complete + 1);
+
+    MappedFile::LineReader reader(text);
+    std::string_view line;
+    std::size_t applied = 0, skipped = 0;
+
+    while (reader.next(line)) {
+        if (line.empty()) continue;
+
+        // <seq>,<op>,<fields>
+        CsvCursor fields(line);
+        std::string_view seqText, op;
+        std::uint64_t seq = 0;
+        if (!fields.next(seqText) || CsvFormat<std::uint64_t>::parse(seqText, seq) != CsvError::NONE || seq == 0 ||
+            !fields.next(op)) {
+            std::cerr << "Error parsing journal entry: " << line << std::endl;
+            skipped++;
+            continue;
+        }
+        changeSeq = std::max(changeSeq.load(), seq);
+        bool newerThanBooks = seq > booksCheckpoint;
+        bool newerThanUsers = seq > usersCheckpoint;
+
+        std::size_t restStart = static_cast<std::size_t>(op.data() + op.size() - line.data()) + 1;
+        std::string_view rest = fields.atEnd() ? std::string_view() : line.substr(restStart);
+        bool ok = false;
+
+        try {
+            if (op == "B") {
+                ok = replayBorrow(fields, newerThanBooks);
+            }
+            else if (op == "R") {
+                ok = replayReturn(fields, newerThanBooks, newerThanUsers);
+            }
+            else if (op == "AB") {
+                ok = newerThanBooks && addOneBook(Book::deserializeCSV(rest));
+            }
+            else if (op == "RB") {
+                ok = newerThanBooks && removeOneBook(std::string(rest));
+            }
+            else if (op == "AU") {
+                ok = newerThanUsers && addOneUser(User::deserializeCSV(rest));
+            }
+            else if (op == "RU") {
+                ok = newerThanUsers && removeOneUser(std::string(rest));
+            }
+            else {
+                std::cerr << "Unknown journal entry: " << line << std::endl;
+            }
+        }
+        catch (...) {
+            std::cerr << "Error parsing journal entry: " << line << std::endl;
+        }
+
+        if (ok) applied++;
+        else skipped++;
+    }
+
+    // Books and users now hold every logged change
+    booksCheckpoint = usersCheckpoint = changeSeq;
+
+    journal = attached;
+    if (applied + skipped > 0)
+        std::cout << "Recovered " << applied << " change(s) from " << filename
+                  << " (" << skipped << " already applied or invalid)" << std::endl;
     return true;
-}
\ No newline at end of file
+}
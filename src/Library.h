@@ -5,9 +5,29 @@
 #include <string>
 #include <memory>
 #include <iostream>
+#include <unordered_map>
+#include <set>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include "Book.h"
 #include "User.h"
 #include "BorrowRecord.h"
+#include "KeywordIndex.h"
+#include "PrefixIndex.h"
+#include "OpenLoanColumns.h"
+#include "LoanReport.h"
+#include "RecordLog.h"
+#include "StringArena.h"
+#include "SlotMap.h"
+#include "ThreadPool.h"
+
+class Journal;
+class CsvCursor;
 
 /*
  * Library.h
@@ -21,42 +41,293 @@
  *  - Reporting functions
  *
  * The Library class stores:
- *  - A list of Book objects
- *  - A list of polymorphic User objects
- *  - A list of BorrowRecord log enteries
+ *  - Book objects in a slot map (dense list + stable slot numbers)
+ *  - Users of every type by value (UserVariant) in a slot map
+ *  - A log of BorrowRecord enteries (see RecordLog.h)
+ *  - Arenas holding the text of loaded books and users
+ *  - An ISBN -> slot hash index over the books for O(1) lookups
+ *  - A user ID -> slot hash index over the users for O(1) lookups
+ *  - Incrementally maintained circulation statistics
+ *  - Record user/book keys -> user and book slots, so record joins are array lookups
+ *  - Loan shards, each holding the open loans of the users whose key falls in it:
+ *     - a user key -> open loan list, so per-user loans never need a record scan
+ *     - open loans ordered by due date, for overdue and due-soon lists
+ *     - open loans as due-day / user-slot columns, for projected late fees
+ *  - The whole borrow history as integer columns next to the records (in the
+ *    RecordLog), for group-by reports
+ *  - A keyword index over book titles and authors, and a sorted title/author
+ *    key list (with a small pending set) for autocomplete
+ *  - An optional write-ahead Journal that receives every change
+ *  - Which collections changed since they were last saved
+ *  - The locks that let several desks (threads) share one Library
+ *
+ * Thread safety: every public function may be called from any thread. Lookups,
+ * reports, borrows and returns run side by side; adding, removing, loading,
+ * saving and displaying wait for them and run alone. Borrows and returns of
+ * users in different loan shards don't wait for each other at all. Books, users and records
+ * are handed out as copies taken under the locks that guard them, so a copy
+ * never changes under the caller and never dangles; to change a book or user,
+ * go through Library.
 */
 
+// Running circulation totals. Every mutation in Library updates these, so
+// report numbers are O(1) and always equal a full rescan of the data.
+struct LibraryStats {
+    int openLoans = 0;          // records not yet returned
+    long copiesOut = 0;         // sum of (total - available) over all books
+    int usersWithFees = 0;      // users with feesDue > 0
+    double totalFeesDue = 0.0;  // sum of feesDue over all users
+};
+
+// Generation-checked references to a book / user (see SlotMap.h). Looking a
+// handle up skips the ID lookup, and it stops resolving once its own book or
+// user is removed, even if the slot is reused.
+using BookHandle = SlotMap<Book>::Handle;
+using UserHandle = SlotMap<UserVariant>::Handle;
+
+// Outcome of one item in a bulk call (addBooks, addUsers, borrowMany, returnMany)
+enum class ChangeStatus { OK, DUPLICATE, UNKNOWN_USER, UNKNOWN_BOOK, NO_COPIES, UNKNOWN_RECORD, ALREADY_RETURNED, INVALID_DATE };
+
+// Grouping for loanReport()
+enum class LoanGroupBy { BORROW_MONTH, USER_TYPE, USER, ISBN };
+
+// One row of loanReport(). average is sum / count.
+struct LoanGroup {
+    std::string key; // "YYYY-MM", Student/Teacher/Other/Unknown, user ID or ISBN
+    std::uint64_t count = 0;
+    std::int64_t sum = 0;
+    double average = 0.0;
+};
+
+// One borrow for borrowMany()
+struct BorrowRequest {
+    std::string userID;
+    std::string isbn;
+    int by = 0, bm = 0, bd = 0; // borrowed
+    int dy = 0, dm = 0, dd = 0; // due
+};
+
+// One return for returnMany()
+struct ReturnRequest {
+    std::uint64_t recordID = 0;
+    int ry = 0, rm = 0, rd = 0;
+    double lateFeePerDay = 0.0;
+};
+
 class Library {
 private:
-    std::vector<Book> books;
-    std::vector<std::unique_ptr<User>> users;
-    std::vector<BorrowRecord> records;
+    SlotMap<Book> books;
+    SlotMap<UserVariant> users;
+    RecordLog records;
+
+    // The user ID and ISBN text behind the keys in records (and in the user and book key tables)
+    RecordSymbols symbols;
+
+    // Text of the books / users that came from loadBooks, loadUsers or loadSnapshot.
+    // Released with the collection (clearBooks / clearUsers), copies handed out own their text.
+    StringArena bookText;
+    StringArena userText;
+
+    // ISBN -> slot in books, kept in sync by every function that adds or removes books
+    std::unordered_map<std::string, std::uint32_t> bookIndex;
+
+    // User ID -> slot in users, kept in sync by addUser, removeUser and loadUsers
+    std::unordered_map<std::string, std::uint32_t> userIndex;
+
+    // Record IDs are a monotonic sequence starting at 1
+    std::atomic<std::uint64_t> nextRecordID;
+
+    // sum of (total - available) over all books, the other stats are kept per loan shard
+    std::atomic<long> copiesOut;
+
+    // Interned user ID / ISBN (the keys BorrowRecord stores) -> slot in users /
+    // books, NO_SLOT if not loaded. Grown as keys appear, kept with userIndex and bookIndex.
+    static constexpr std::uint32_t NO_SLOT = OpenLoanColumns::NO_USER;
+    std::vector<std::uint32_t> userSlotByKey;
+    std::vector<std::uint32_t> bookSlotByKey;
+
+    // The open loans and fees of the users whose key is shard number mod
+    // LOAN_SHARDS, with the lock that guards them (see Locking below)
+    struct LoanShard {
+        mutable std::shared_mutex lock;
+
+        // User key / LOAN_SHARDS -> IDs of that user's unreturned records
+        std::vector<std::vector<std::uint64_t>> openLoansByUser;
+
+        // (due day, record ID) of every unreturned record, kept with openLoansByUser
+        std::set<std::pair<DayNumber, std::uint64_t>> dueIndex;
+
+        // The same open loans as columns, user slots follow the user list
+        OpenLoanColumns openLoanColumns;
+
+        // This shard's part of LibraryStats
+        int openLoans = 0;
+        int usersWithFees = 0;
+        double totalFeesDue = 0.0;
+    };
+    // Whole-history passes hold every shard plus catalogLock, which has to stay
+    // under ThreadSanitizer's limit of 64 locks held by one thread
+    static constexpr std::size_t LOAN_SHARDS = 32;
+    std::array<LoanShard, LOAN_SHARDS> loanShards;
+
+    // Title/author words -> book slots, and sorted title/author keys for
+    // autocomplete, maintained alongside bookIndex
+    KeywordIndex keywordIndex;
+    PrefixIndex prefixIndex;
+
+    // Write-ahead log, not owned. nullptr means changes aren't logged.
+    Journal* journal;
+
+    // Workers for parsing records.csv in parallel, started by the first such
+    // load and kept for later ones
+    ThreadPool parsePool;
+
+    // Locking. Every public function holds catalogLock: exclusive when it adds,
+    // removes, loads, saves or displays, shared otherwise. Under a shared catalogLock
+    //  - a book's copy counts need no lock, Book changes them atomically
+    //  - copiesOut, nextRecordID and the dirty flags are atomics
+    //  - a user's fees, open loans and records belong to the lock of their key's
+    //    loan shard, shared for reading, exclusive for changes. Records are
+    //    appended under it, so whole-history passes lock every shard shared.
+    //  - with a journal attached, logOrderLock is held from a borrow or return's
+    //    copy count change to its journal entry, so the log replays copies in
+    //    the order they were taken and given back
+    // Locks are always taken in that order: catalogLock, loan shards (ascending),
+    // logOrderLock.
+    mutable std::shared_mutex catalogLock;
+    std::mutex logOrderLock;
+
+    // Save tracking. A collection is only written when it changed since it was
+    // last loaded from or saved to that same file.
+    std::string booksFile, usersFile, recordsFile;
+    std::atomic<bool> booksDirty, usersDirty;
+    std::atomic<bool> recordsRewrite; // a record that is already on disk has changed
+    std::size_t recordsSaved;         // records.at(0 .. recordsSaved - 1) are on disk as they are now
+
+    // Journal sequence numbers (see Journal.h). books.csv and users.csv start
+    // with a "#checkpoint,<seq>" line naming the last change they include.
+    // booksCheckpoint / usersCheckpoint are the last change the loaded books /
+    // users include (the file's checkpoint, then changeSeq once the log is
+    // replayed), so replay skips what they already have. changeSeq is the last
+    // change in memory.
+    std::atomic<std::uint64_t> changeSeq;
+    std::uint64_t booksCheckpoint, usersCheckpoint;
+
+    // Rows a load couldn't use (parse errors, duplicate ISBNs or user IDs), kept
+    // as read and written back after the other rows whenever the file is
+    // rewritten, so a save never deletes a row just because it didn't parse
+    std::vector<std::string> rejectedBooks, rejectedUsers, rejectedRecords;
 
     Book* findBookByISBN(const std::string& isbn);
+    const Book* findBookByISBN(const std::string& isbn) const;
+    void indexBook(std::uint32_t slot);
+    void indexBookWords(std::uint32_t slot);
+    void unindexBook(std::uint32_t slot);
     User* findUserByID(const std::string& id);
+    const User* findUserByID(const std::string& id) const;
+    std::optional<UserVariant> copyUser(std::uint32_t slot) const;
+    LoanShard& shardOf(std::uint32_t userKey);
+    const LoanShard& shardOf(std::uint32_t userKey) const;
+    std::vector<std::shared_lock<std::shared_mutex>> lockAllShards() const;
+    std::unique_lock<std::mutex> lockLogOrder();
+    void addOpenLoan(const BorrowRecord& rec);
+    void closeOpenLoan(const BorrowRecord& rec);
+    std::vector<BorrowRecord> copyRecords(const std::vector<std::uint64_t>& ids) const;
+    void relinkUserLoans(const std::string& userID, std::uint32_t slot);
+    void countUserFees(std::uint32_t userKey, double feesDue, int direction);
+    std::vector<BorrowRecord> loansDueIn(DayNumber first, DayNumber last) const;
+    void chargeFees(std::uint32_t userKey, User& user, double amt);
+    ChangeStatus borrowOne(const std::string& userID, const std::string& isbn, int by, int bm, int bd, int dy, int dm, int dd,
+                           std::uint64_t* newRecordID = nullptr);
+    ChangeStatus returnOne(std::uint64_t recordID, int ry, int rm, int rd, double lateFeePerDay);
+    void logChange(const std::string& entry);
+    BorrowRecord& appendRecord(const BorrowRecord& rec);
+    void closeRecord(BorrowRecord& rec, int ry, int rm, int rd);
+    bool readCheckpoint(std::string_view line, std::uint64_t& checkpoint);
+    bool replayBorrow(CsvCursor& fields, bool takeCopy);
+    bool replayReturn(CsvCursor& fields, bool returnCopy, bool chargeFee);
+
+    // The work of the public add/remove calls, for callers that hold catalogLock exclusively
+    bool addOneBook(const Book& book);
+    bool removeOneBook(const std::string& isbn);
+    bool addOneUser(std::unique_ptr<User> user);
+    bool removeOneUser(const std::string& id);
+
+    void clearBooks();
+    bool appendLoadedBook(Book b);
+    void clearUsers();
+    bool appendLoadedUser(UserVariant u);
+    // A load calls clearRecords, then noteLoadedID for every record, then
+    // appendLoadedRecord for each in file order; recordCount is the load's total
+    static constexpr std::uint64_t MAX_RECORD_ID_GAP = 1 << 20;
+    static bool isLoadableID(std::uint64_t id, std::size_t recordCount);
+    void clearRecords();
+    void noteLoadedID(std::uint64_t id, std::size_t recordCount);
+    void appendLoadedRecord(BorrowRecord r, std::size_t recordCount);
 
 public:
     Library();
 
     // Book Management
     bool addBook(const Book& book);
-    bool removeBook(const std::string& isbn);
-    Book* searchBook(const std::string& isbn);
+    bool removeBook(const std::string& isbn); // amortized O(1), see bench/bench_remove.cpp
+    std::optional<Book> searchBook(const std::string& isbn) const; // a copy, empty if not found
+    BookHandle findBook(const std::string& isbn) const;            // a handle that resolves to nothing if not found
+    std::optional<Book> getBook(BookHandle h) const;               // empty once that book is removed
+    std::vector<Book> searchBooksByKeywords(const std::string& query) const;
+    std::vector<Book> autocompleteBooks(const std::string& prefix, std::size_t limit) const;
 
     // User Management
     bool addUser(std::unique_ptr<User> user);
-    bool removeUser(const std::string& id);
-    User* searchUser(const std::string& id);
+    bool removeUser(const std::string& id); // fails while the user has books out
+    std::optional<UserVariant> searchUser(const std::string& id) const; // a copy, empty if not found
+    UserHandle findUser(const std::string& id) const;
+    std::optional<UserVariant> getUser(UserHandle h) const;
+    bool hasOpenLoans(const std::string& userID) const;
+    std::vector<BorrowRecord> getOpenLoans(const std::string& userID) const;
+
+    // Text of the user ID and ISBN keys in the records handed out, for display.
+    // Lives as long as the Library.
+    const RecordSymbols& getRecordSymbols() const;
+
+    // Due-date queries over open loans, earliest due date first, O(k + log n)
+    std::vector<BorrowRecord> getOverdueLoans(DayNumber asOf) const; // due before asOf
+    std::vector<BorrowRecord> getLoansDueWithin(DayNumber from, int days) const; // due in [from, from + days]
+
+    // Nightly accrual: the late fees each user's open loans would owe if returned on
+    // asOf, in user list order, users owing nothing left out. Runs over the open
+    // loan columns; the reference version scans every record and is only for checks.
+    // Each entry is a user ID and its projected fee.
+    std::vector<std::pair<std::string, double>> projectLateFees(DayNumber asOf, double lateFeePerDay) const;
+    std::vector<std::pair<std::string, double>> projectLateFeesReference(DayNumber asOf, double lateFeePerDay) const;
+
+    // Group-by over the whole borrow history (see LoanReport.h for the
+    // measures). Groups without loans are left out; months, user types and IDs
+    // come out in ascending order. USER_TYPE uses each user's current type,
+    // loans of users that are no longer loaded count as "Unknown".
+    std::vector<LoanGroup> loanReport(LoanGroupBy by, LoanMeasure measure) const;
 
     // Borrow / Return
     bool borrowBook(const std::string& userID, const std::string& isbn, int by, int bm, int bd, int dy, int dm, int dd);
+    bool returnBook(std::uint64_t recordID, int ry, int rm, int rd, double lateFeePerDay);
     bool returnBook(const std::string& recordID, int ry, int rm, int rd, double lateFeePerDay);
 
+    // Bulk changes, one status per item in input order. Capacity is reserved once,
+    // each book/user is checked against existing data and earlier items of the same
+    // batch with a single index probe, and items are moved in rather than copied.
+    // borrowMany can also report each new record ID (0 where the borrow failed).
+    std::vector<ChangeStatus> addBooks(std::vector<Book> batch);
+    std::vector<ChangeStatus> addUsers(std::vector<std::unique_ptr<User>> batch);
+    std::vector<ChangeStatus> borrowMany(const std::vector<BorrowRequest>& batch,
+                                         std::vector<std::uint64_t>* recordIDs = nullptr);
+    std::vector<ChangeStatus> returnMany(const std::vector<ReturnRequest>& batch);
+
     // getters
     int getTotalBooks() const;
     int getTotalUsers() const;
     int getBorrowedCount() const;
     int getAvailableCopies(const std::string& isbn) const;
+    LibraryStats getStats() const; // a consistent copy
 
     // Reports
     void displayAllBooks() const;
@@ -64,14 +335,33 @@ public:
     void displayAllRecords() const;
 
     // File I/O
+    // Saves skip unchanged collections and replace files atomically (temp file + rename).
+    // Only changes made through Library are tracked.
     bool loadBooks(const std::string& filename);
-    bool saveBooks(const std::string& filename) const;
+    bool saveBooks(const std::string& filename);
 
     bool loadUsers(const std::string& filename);
-    bool saveUsers(const std::string& filename) const;
+    bool saveUsers(const std::string& filename);
+
+    // threads = 0 uses one thread per core, 1 forces the serial path
+    bool loadRecords(const std::string& filename, unsigned threads = 0);
+    bool saveRecords(const std::string& filename); // appends new records when it can
+
+    bool hasUnsavedChanges() const;
+    // Declares that these CSV files already hold the current state, e.g. after
+    // loading a snapshot that was written right after them
+    void markSavedTo(const std::string& booksFilename, const std::string& usersFilename,
+                     const std::string& recordsFilename);
+
+    // Binary snapshot of books, users, records and their indexes (format in
+    // Snapshot.h). Loading only works on a Library that has loaded nothing yet,
+    // and skips parsing and index building; see bench/bench_snapshot.cpp.
+    bool saveSnapshot(const std::string& filename) const;
+    bool loadSnapshot(const std::string& filename);
 
-    bool loadRecords(const std::string& filename);
-    bool saveRecords(const std::string& filename) const;
+    // Write-ahead log (see Journal.h). Replay before attaching.
+    void attachJournal(Journal* j);
+    bool replayJournal(const std::string& filename);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "LoanReport.h"
+
+/*
+ * LoanReport.cpp
+ * Implements the group-by pass declared in LoanReport.h.
+ */
+
+// Helper: one pass over n rows for a fixed measure. groupOf(i) gives the group of row i.
+// The measure switch sits outside the loop so each loop body stays branch-light.
+template <typename GroupOf>
+static void accumulate(const RecordLog::ColumnRun& run, GroupOf groupOf, LoanMeasure measure, GroupTotals& totals) {
+    std::uint64_t* count = totals.count.data();
+    std::int64_t* sum = totals.sum.data();
+    const std::size_t n = run.n;
+    const DayNumber* borrowed = run.borrowed;
+    const DayNumber* due = run.due;
+    const DayNumber* returned = run.returned;
+
+    switch (measure) {
+        case LoanMeasure::LOANS:
+            for (std::size_t i = 0; i < n; ++i)
+                count[groupOf(i)]++;
+            break;
+
+        case LoanMeasure::DAYS_OUT:
+            for (std::size_t i = 0; i < n; ++i) {
+                if (returned[i] == BorrowRecord::NOT_RETURNED)
+                    continue;
+                std::uint32_t g = groupOf(i);
+                count[g]++;
+                sum[g] += returned[i] - borrowed[i];
+            }
+            break;
+
+        case LoanMeasure::DAYS_LATE:
+            for (std::size_t i = 0; i < n; ++i) {
+                if (returned[i] == BorrowRecord::NOT_RETURNED)
+                    continue;
+                std::uint32_t g = groupOf(i);
+                std::int32_t late = returned[i] - due[i];
+                count[g]++;
+                sum[g] += late > 0 ? late : 0;
+            }
+            break;
+    }
+}
+
+// Helper: borrow month group of a day number
+static std::uint32_t monthGroup(DayNumber day) {
+    int y, m, d;
+    civilFromDays(day, y, m, d);
+    return static_cast<std::uint32_t>(y * 12 + m - 1);
+}
+
+void aggregateLoans(const RecordLog::ColumnRun& run, LoanKey key, const std::vector<std::uint32_t>* remap,
+                    LoanMeasure measure, GroupTotals& totals)
+{
+    if (key == LoanKey::BORROW_MONTH) {
+        const DayNumber* b = run.borrowed;
+        if (remap)
+            accumulate(run, [&](std::size_t i) { return (*remap)[monthGroup(b[i])]; }, measure, totals);
+        else
+            accumulate(run, [b](std::size_t i) { return monthGroup(b[i]); }, measure, totals);
+        return;
+    }
+
+    const std::uint32_t* column = key == LoanKey::USER ? run.user : run.book;
+    if (remap) {
+        const std::uint32_t* map = remap->data();
+        accumulate(run, [map, column](std::size_t i) { return map[column[i]]; }, measure, totals);
+    }
+    else {
+        accumulate(run, [column](std::size_t i) { return column[i]; }, measure, totals);
+    }
+}
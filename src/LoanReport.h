@@ -0,0 +1,49 @@
+#ifndef LOAN_REPORT_H
+#define LOAN_REPORT_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "RecordLog.h"
+
+/*
+ * LoanReport.h
+ * Declares the group-by pass behind Library::loanReport.
+ *
+ * The pass reads the integer columns the RecordLog keeps next to its records
+ * (see RecordLog.h): user and book keys (interned, see SymbolTable.h) and
+ * the borrowed, due and returned day numbers. A report only loads the
+ * columns it needs, 4 bytes per record for a plain count and 12 for a
+ * days-late sum, and never touches a string.
+ *
+ * aggregateLoans() adds each row's measure to the totals of the row's group,
+ * where the group comes from one key column. It takes one contiguous run of
+ * rows, the Library calls it once per run of its log.
+ */
+
+// What is added up per group
+enum class LoanMeasure {
+    LOANS,      // every loan counts, sum stays 0
+    DAYS_OUT,   // returned loans, sum of days from borrow to return
+    DAYS_LATE   // returned loans, sum of days late (0 for on-time returns)
+};
+
+// Which record field picks the group
+enum class LoanKey { USER, BOOK, BORROW_MONTH };
+
+// BORROW_MONTH groups are year * 12 + month - 1, which fits below this
+constexpr std::size_t MONTH_GROUPS = 10000 * 12;
+
+// Count and sum of one measure per group number
+struct GroupTotals {
+    std::vector<std::uint64_t> count;
+    std::vector<std::int64_t> sum;
+};
+
+// Adds the measure of every row of run to totals[group]. The group is the row's
+// key, passed through remap when one is given. totals.count and totals.sum must
+// be larger than every group number that can come up.
+void aggregateLoans(const RecordLog::ColumnRun& run, LoanKey key, const std::vector<std::uint32_t>* remap,
+                    LoanMeasure measure, GroupTotals& totals);
+
+#endif
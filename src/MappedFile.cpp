@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * MappedFile.cpp
+ * Implements the MappedFile class declared in MappedFile.h using POSIX mmap.
+ */
+
+// Constructor / destructor
+MappedFile::MappedFile() : data(nullptr), size(0), reader() {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+// Maps the file read-only. An empty file opens successfully with no contents
+// (mmap can't map zero bytes).
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    if (st.st_size > 0) {
+        void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        // Loaders read front to back
+        madvise(p, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        data = static_cast<const char*>(p);
+        size = static_cast<std::size_t>(st.st_size);
+    }
+    reader = LineReader(contents());
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data)
+        munmap(const_cast<char*>(data), size);
+    data = nullptr;
+    size = 0;
+    reader = LineReader();
+}
+
+std::string_view MappedFile::contents() const {
+    return std::string_view(data, size);
+}
+
+// Line iteration
+MappedFile::LineReader::LineReader(std::string_view text) : rest(text) {}
+
+bool MappedFile::LineReader::next(std::string_view& line) {
+    if (rest.empty())
+        return false;
+
+    const char* nl = static_cast<const char*>(std::memchr(rest.data(), '\n', rest.size()));
+    std::size_t len = nl ? static_cast<std::size_t>(nl - rest.data()) : rest.size();
+
+    line = rest.substr(0, len);
+    rest.remove_prefix(len + (nl ? 1 : 0));
+
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return true;
+}
+
+bool MappedFile::nextLine(std::string_view& line) {
+    return reader.next(line);
+}
\ No newline at end of file
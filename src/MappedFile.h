@@ -0,0 +1,57 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/*
+ * MappedFile.h
+ * Declares the MappedFile class, a read-only memory mapping of a whole file.
+ *
+ * The Library loaders use it to walk a CSV file line by line as
+ * std::string_view slices of the mapping, so reading a file costs no
+ * per-line allocation or copying.
+ *
+ * The mapping is released when the MappedFile is destroyed, so views
+ * returned by nextLine() must not outlive it.
+ */
+
+class MappedFile {
+public:
+    // Splits a block of text into lines, accepts both "\n" and "\r\n" endings
+    class LineReader {
+    private:
+        std::string_view rest;
+
+    public:
+        explicit LineReader(std::string_view text = std::string_view());
+
+        // Next line without its line ending, returns false at end of text
+        bool next(std::string_view& line);
+    };
+
+private:
+    const char* data;
+    std::size_t size;
+    LineReader reader;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps filename, returns false if it can't be opened
+    bool open(const std::string& filename);
+    void close();
+
+    // Whole file contents
+    std::string_view contents() const;
+
+    // Next line without its line ending, returns false at end of file
+    bool nextLine(std::string_view& line);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "OpenLoanColumns.h"
+#include <algorithm>
+
+/*
+ * OpenLoanColumns.cpp
+ * Implements the OpenLoanColumns class declared in OpenLoanColumns.h.
+ */
+
+// Maintenance
+void OpenLoanColumns::add(std::uint64_t recordID, DayNumber dueDay, std::uint32_t user) {
+    position[recordID] = static_cast<std::uint32_t>(due.size());
+
+    due.push_back(dueDay);
+    userSlot.push_back(user);
+    recordIDs.push_back(recordID);
+}
+
+// Swap-with-last removal
+void OpenLoanColumns::remove(std::uint64_t recordID) {
+    auto it = position.find(recordID);
+    std::size_t i = it->second;
+    std::size_t last = due.size() - 1;
+
+    if (i != last) {
+        due[i] = due[last];
+        userSlot[i] = userSlot[last];
+        recordIDs[i] = recordIDs[last];
+        position[recordIDs[i]] = static_cast<std::uint32_t>(i);
+    }
+    position.erase(it);
+    due.pop_back();
+    userSlot.pop_back();
+    recordIDs.pop_back();
+}
+
+void OpenLoanColumns::setUser(std::uint64_t recordID, std::uint32_t user) {
+    userSlot[position.at(recordID)] = user;
+}
+
+void OpenLoanColumns::unlinkUsers() {
+    std::fill(userSlot.begin(), userSlot.end(), NO_USER);
+}
+
+void OpenLoanColumns::clear() {
+    due.clear();
+    userSlot.clear();
+    recordIDs.clear();
+    position.clear();
+}
+
+std::size_t OpenLoanColumns::size() const {
+    return due.size();
+}
+
+// Helper: late days for count loans starting at dueDay, branch-free so it vectorizes
+template <std::size_t COUNT>
+static void lateDaysOf(const DayNumber* dueDay, DayNumber asOf, std::int32_t* late) {
+    for (std::size_t i = 0; i < COUNT; ++i) {
+        std::int32_t diff = asOf - dueDay[i];
+        late[i] = diff > 0 ? diff : 0;
+    }
+}
+
+// Two passes per block: the late-day arithmetic over a fixed-size block (full
+// blocks have a constant trip count, which -O2 vectorizes), then only loans that
+// are actually late are added to their user.
+void OpenLoanColumns::accrueLateDays(DayNumber asOf, std::vector<std::uint64_t>& lateDays) const {
+    constexpr std::size_t BLOCK = 1024;
+    std::int32_t late[BLOCK];
+
+    const DayNumber* dueDay = due.data();
+    const std::uint32_t* user = userSlot.data();
+    const std::size_t n = due.size();
+
+    for (std::size_t base = 0; base < n; base += BLOCK) {
+        const std::size_t len = std::min(BLOCK, n - base);
+
+        if (len == BLOCK) {
+            lateDaysOf<BLOCK>(dueDay + base, asOf, late);
+        }
+        else {
+            for (std::size_t i = 0; i < len; ++i) {
+                std::int32_t diff = asOf - dueDay[base + i];
+                late[i] = diff > 0 ? diff : 0;
+            }
+        }
+
+        for (std::size_t i = 0; i < len; ++i) {
+            if (late[i] != 0 && user[base + i] != NO_USER)
+                lateDays[user[base + i]] += static_cast<std::uint64_t>(late[i]);
+        }
+    }
+}
\ No newline at end of file
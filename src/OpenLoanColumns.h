@@ -0,0 +1,50 @@
+#ifndef OPEN_LOAN_COLUMNS_H
+#define OPEN_LOAN_COLUMNS_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "Date.h"
+
+/*
+ * OpenLoanColumns.h
+ * Declares the OpenLoanColumns class, the open loans laid out as parallel
+ * arrays (structure of arrays) for whole-collection passes.
+ *
+ * Column i holds one unreturned record: its due day and its user's slot (in the
+ * Library's user slot map, NO_USER if the user isn't loaded). Removal swaps
+ * the last loan into the gap, so the columns stay dense and a pass over them is
+ * a straight walk through two contiguous int32 arrays.
+ *
+ * The Library keeps one set of columns per loan shard, in step with that
+ * shard's open loans and user slots. Record IDs of a shard are sparse, so the
+ * ID -> column table is a hash map rather than an array indexed by ID.
+ */
+
+class OpenLoanColumns {
+public:
+    static constexpr std::uint32_t NO_USER = UINT32_MAX;
+
+private:
+    std::vector<DayNumber> due;
+    std::vector<std::uint32_t> userSlot;
+    std::vector<std::uint64_t> recordIDs;   // owner of each column entry, for swap removal
+    std::unordered_map<std::uint64_t, std::uint32_t> position; // record ID -> column index
+
+public:
+    // Maintenance
+    void add(std::uint64_t recordID, DayNumber dueDay, std::uint32_t user);
+    void remove(std::uint64_t recordID);
+    void setUser(std::uint64_t recordID, std::uint32_t user);
+    void unlinkUsers(); // every loan to NO_USER, used when the user list is cleared
+    void clear();
+
+    std::size_t size() const;
+
+    // Adds max(0, asOf - due) of every loan to lateDays[its user slot].
+    // lateDays must be larger than every user slot in the columns.
+    void accrueLateDays(DayNumber asOf, std::vector<std::uint64_t>& lateDays) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "PrefixIndex.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <cctype>
+
+/*
+ * PrefixIndex.cpp
+ * Implements the PrefixIndex class declared in PrefixIndex.h.
+ *
+ * Contains logic for:
+ *  - Key normalization
+ *  - Pending adds, slot generations and merging them into the sorted entries
+ *  - Reading the first N matches of a prefix off both in order
+ *  - Writing the live entries to a snapshot and reading them back as the sorted vector
+ */
+
+// Constructor
+PrefixIndex::PrefixIndex() : sorted(), pending(), generations(), liveKeys(), deadCount(0), text() {}
+
+// Normalization
+std::string PrefixIndex::normalize(std::string_view text) {
+    std::string key;
+    key.reserve(text.size());
+
+    for (char c : text) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isspace(uc)) {
+            if (!key.empty() && key.back() != ' ')
+                key += ' ';
+        }
+        else {
+            key += static_cast<char>(std::tolower(uc));
+        }
+    }
+    if (!key.empty() && key.back() == ' ')
+        key.pop_back();
+    return key;
+}
+
+bool PrefixIndex::isLive(const Entry& e) const {
+    return e.generation == generations[e.slot];
+}
+
+void PrefixIndex::insertKey(const std::string& key, std::size_t slot) {
+    if (key.empty())
+        return;
+    pending.insert(Entry{ text.store(key), static_cast<std::uint32_t>(slot), generations[slot] });
+    liveKeys[slot]++;
+    mergeIfDue();
+}
+
+// Rebuilds sorted from its live entries and the pending ones, into a fresh arena
+// so the text of removed keys is dropped too
+void PrefixIndex::mergeIfDue() {
+    if (pending.size() + deadCount <= sorted.size() / 8 + 1024)
+        return;
+
+    StringArena merged;
+    std::vector<Entry> entries;
+    entries.reserve(sorted.size() + pending.size() - std::min(deadCount, sorted.size() + pending.size()));
+
+    auto keep = [&](const Entry& e) {
+        if (isLive(e))
+            entries.push_back(Entry{ merged.store(e.key), e.slot, e.generation });
+    };
+    auto p = pending.begin();
+    for (const Entry& e : sorted) {
+        for (; p != pending.end() && *p < e; ++p)
+            keep(*p);
+        keep(e);
+    }
+    for (; p != pending.end(); ++p)
+        keep(*p);
+
+    sorted.swap(entries);
+    pending.clear();
+    deadCount = 0;
+    text = std::move(merged);
+}
+
+// Index maintenance
+void PrefixIndex::add(std::size_t slot, const Book& book) {
+    if (slot >= generations.size()) {
+        generations.resize(slot + 1, 0);
+        liveKeys.resize(slot + 1, 0);
+    }
+    std::string title = normalize(book.getTitle());
+    std::string author = normalize(book.getAuthor());
+    insertKey(title, slot);
+    // A title equal to the author is one entry
+    if (author != title)
+        insertKey(author, slot);
+}
+
+void PrefixIndex::remove(std::size_t slot) {
+    if (slot >= generations.size() || liveKeys[slot] == 0)
+        return;
+    generations[slot]++;
+    deadCount += liveKeys[slot];
+    liveKeys[slot] = 0;
+    mergeIfDue();
+}
+
+void PrefixIndex::clear() {
+    sorted.clear();
+    pending.clear();
+    generations.clear();
+    liveKeys.clear();
+    deadCount = 0;
+    text.clear();
+}
+
+// Lookup: walk the sorted entries and the pending ones together, in key order
+std::vector<std::size_t> PrefixIndex::complete(const std::string& prefix, std::size_t limit) const {
+    std::vector<std::size_t> result;
+    std::string key = normalize(prefix);
+    if (key.empty() || limit == 0)
+        return result;
+
+    Entry probe{ key, 0, 0 };
+    auto s = std::lower_bound(sorted.begin(), sorted.end(), probe);
+    auto p = pending.lower_bound(probe);
+    auto matches = [&](const Entry& e) { return e.key.substr(0, key.size()) == key; };
+
+    while (result.size() < limit) {
+        bool haveSorted = s != sorted.end() && matches(*s);
+        bool havePending = p != pending.end() && matches(*p);
+        if (!haveSorted && !havePending)
+            break;
+
+        const Entry& e = (haveSorted && (!havePending || *s < *p)) ? *s++ : *p++;
+        // A book can match on both its title and its author
+        if (isLive(e) && std::find(result.begin(), result.end(), e.slot) == result.end())
+            result.push_back(e.slot);
+    }
+    return result;
+}
+
+// Snapshot section
+void PrefixIndex::save(SnapshotWriter& out, const std::vector<std::uint32_t>& slotRemap) const {
+    std::vector<Entry> live;
+    live.reserve(sorted.size() + pending.size());
+    auto keep = [&](const Entry& e) {
+        if (isLive(e))
+            live.push_back(Entry{ e.key, slotRemap[e.slot], 0 });
+    };
+    auto p = pending.begin();
+    for (const Entry& e : sorted) {
+        for (; p != pending.end() && *p < e; ++p)
+            keep(*p);
+        keep(e);
+    }
+    for (; p != pending.end(); ++p)
+        keep(*p);
+
+    // Renumbering only reorders entries under equal keys
+    if (!std::is_sorted(live.begin(), live.end()))
+        std::sort(live.begin(), live.end());
+
+    std::vector<std::string_view> keys;
+    std::vector<std::uint32_t> slots;
+    keys.reserve(live.size());
+    slots.reserve(live.size());
+    for (const Entry& e : live) {
+        keys.push_back(e.key);
+        slots.push_back(e.slot);
+    }
+    out.putStrings(keys);
+    out.putArray(slots);
+}
+
+// Entries must be non-empty, strictly ascending and at most two per slot (title and author)
+bool PrefixIndex::load(SnapshotReader& in, std::size_t slotCount) {
+    std::vector<std::string_view> keys;
+    std::string_view blob;
+    std::vector<std::uint32_t> slots;
+    if (!in.getStrings(keys, &blob) || !in.getArray(slots) || slots.size() != keys.size())
+        return false;
+
+    StringArena loadedText;
+    rebaseStrings(keys, blob, loadedText.store(blob).data());
+
+    std::vector<std::uint8_t> loadedLive(slotCount, 0);
+    std::vector<Entry> loaded;
+    loaded.reserve(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        Entry e{ keys[i], slots[i], 0 };
+        if (e.key.empty() || e.slot >= slotCount || loadedLive[e.slot] == 2 || (i > 0 && !(loaded.back() < e)))
+            return false;
+        loadedLive[e.slot]++;
+        loaded.push_back(e);
+    }
+
+    sorted.swap(loaded);
+    pending.clear();
+    generations.assign(slotCount, 0);
+    liveKeys.swap(loadedLive);
+    deadCount = 0;
+    text = std::move(loadedText);
+    return true;
+}
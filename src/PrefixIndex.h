@@ -0,0 +1,89 @@
+#ifndef PREFIX_INDEX_H
+#define PREFIX_INDEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <cstdint>
+#include "Book.h"
+#include "StringArena.h"
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/*
+ * PrefixIndex.h
+ * Declares the PrefixIndex class, the sorted key list used for title and
+ * author type-ahead.
+ *
+ * Every book is entered twice, under its normalized title and its normalized
+ * author (lowercase, single spaces). Entries are (key, slot) pairs kept in
+ * one sorted vector, with the key text packed into a StringArena, so the
+ * whole index costs about two small entries plus the key text per book. A
+ * lookup binary searches for the prefix and reads matches in alphabetical
+ * order until it has enough, so its cost depends on log(catalog size) and
+ * the number of results asked for.
+ *
+ * Changes don't shift the vector: an added entry goes into a small sorted
+ * set of pending entries, and lookups read both in step. Removing a book
+ * doesn't look its entries up at all: each slot has a generation number,
+ * entries carry the generation they were added under, and remove(slot) just
+ * bumps the slot's generation, which makes every entry added before it stale.
+ * Lookups skip stale entries. Once pending and stale entries reach an eighth
+ * of the vector the two are merged into a new vector and arena, dropping the
+ * stale ones. Add is amortized O(log n), remove amortized O(1).
+ *
+ * A snapshot holds the live entries only, already merged and in order:
+ * a string table of keys, then uint32 slot[n]. Loading it is one copy of the
+ * key text and no sorting.
+ */
+
+class PrefixIndex {
+private:
+    struct Entry {
+        std::string_view key; // in text
+        std::uint32_t slot;
+        std::uint32_t generation; // stale once it differs from generations[slot]
+
+        bool operator<(const Entry& other) const {
+            if (key != other.key)
+                return key < other.key;
+            return slot != other.slot ? slot < other.slot : generation < other.generation;
+        }
+    };
+
+    std::vector<Entry> sorted;
+    std::set<Entry> pending;                // added since the last merge
+    std::vector<std::uint32_t> generations; // slot -> current generation
+    std::vector<std::uint8_t> liveKeys;     // slot -> entries under the current generation
+    std::size_t deadCount;                  // stale entries in sorted and pending
+    StringArena text;                       // key text of sorted and pending entries
+
+    bool isLive(const Entry& e) const;
+    void insertKey(const std::string& key, std::size_t slot);
+    void mergeIfDue();
+
+public:
+    PrefixIndex();
+
+    // Lowercases and collapses whitespace, used for keys and prefixes alike
+    static std::string normalize(std::string_view text);
+
+    // Index maintenance
+    void add(std::size_t slot, const Book& book);
+    void remove(std::size_t slot);
+    void clear();
+
+    // Snapshot section (see Snapshot.h). save() renumbers slots through
+    // slotRemap (old slot -> new slot, every live slot mapped); load()
+    // replaces the index, returns false and leaves it as it was if the
+    // section is damaged or names a slot >= slotCount.
+    void save(SnapshotWriter& out, const std::vector<std::uint32_t>& slotRemap) const;
+    bool load(SnapshotReader& in, std::size_t slotCount);
+
+    // Up to limit book slots whose title or author starts with prefix
+    std::vector<std::size_t> complete(const std::string& prefix, std::size_t limit) const;
+};
+
+#endif
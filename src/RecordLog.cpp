@@ -0,0 +1,119 @@
+#include "RecordLog.h"
+
+/*
+ * RecordLog.cpp
+ * Implements the RecordLog class declared in RecordLog.h.
+ */
+
+RecordLog::RecordLog()
+    : records(), positions(), userColumn(), bookColumn(), borrowedColumn(), dueColumn(), returnedColumn(), count(0) {
+    for (std::size_t k = 0; k < SEGMENTS; ++k) {
+        records[k].store(nullptr, std::memory_order_relaxed);
+        positions[k].store(nullptr, std::memory_order_relaxed);
+        userColumn[k].store(nullptr, std::memory_order_relaxed);
+        bookColumn[k].store(nullptr, std::memory_order_relaxed);
+        borrowedColumn[k].store(nullptr, std::memory_order_relaxed);
+        dueColumn[k].store(nullptr, std::memory_order_relaxed);
+        returnedColumn[k].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+RecordLog::~RecordLog() {
+    clear();
+}
+
+// Segment number of a position or ID and its offset inside that segment
+std::size_t RecordLog::segmentOf(std::uint64_t index, std::size_t& offset) {
+    std::uint64_t v = index + FIRST;
+    unsigned top = 63 - static_cast<unsigned>(__builtin_clzll(v));
+    offset = static_cast<std::size_t>(v - (std::uint64_t(1) << top));
+    return top - FIRST_BITS;
+}
+
+// Two threads may reach a new segment together; the one that loses the race
+// frees its copy and uses the winner's
+template <typename T>
+T* RecordLog::segment(std::atomic<T*>* table, std::size_t k) {
+    T* seg = table[k].load(std::memory_order_acquire);
+    if (seg)
+        return seg;
+
+    T* fresh = new T[FIRST << k]();
+    if (table[k].compare_exchange_strong(seg, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+        return fresh;
+    delete[] fresh;
+    return seg;
+}
+
+std::size_t RecordLog::append(const BorrowRecord& rec) {
+    assert(rec.getRecordID() <= MAX_ID);
+    const std::size_t position = count.fetch_add(1, std::memory_order_relaxed);
+    std::size_t offset;
+    std::size_t k = segmentOf(position, offset);
+    segment(records, k)[offset] = rec;
+    segment(userColumn, k)[offset] = rec.getUserKey();
+    segment(bookColumn, k)[offset] = rec.getBookKey();
+    segment(borrowedColumn, k)[offset] = rec.getBorrowedDay();
+    segment(dueColumn, k)[offset] = rec.getDueDay();
+    segment(returnedColumn, k)[offset] = rec.getReturnDay();
+
+    k = segmentOf(rec.getRecordID(), offset);
+    segment(positions, k)[offset].store(position + 1, std::memory_order_release);
+    return position;
+}
+
+std::size_t RecordLog::positionOf(std::uint64_t id) const {
+    if (id > MAX_ID)
+        return NONE;
+    std::size_t offset;
+    std::size_t k = segmentOf(id, offset);
+    const std::atomic<std::size_t>* seg = positions[k].load(std::memory_order_acquire);
+    std::size_t p = seg ? seg[offset].load(std::memory_order_acquire) : 0;
+    return p == 0 ? NONE : p - 1;
+}
+
+BorrowRecord* RecordLog::find(std::uint64_t id) {
+    std::size_t p = positionOf(id);
+    return p == NONE ? nullptr : &at(p);
+}
+
+const BorrowRecord* RecordLog::find(std::uint64_t id) const {
+    std::size_t p = positionOf(id);
+    return p == NONE ? nullptr : &at(p);
+}
+
+void RecordLog::markReturned(std::size_t position, DayNumber day) {
+    std::size_t offset;
+    std::size_t k = segmentOf(position, offset);
+    records[k].load(std::memory_order_acquire)[offset].markReturned(day);
+    returnedColumn[k].load(std::memory_order_acquire)[offset] = day;
+}
+
+BorrowRecord& RecordLog::at(std::size_t position) {
+    std::size_t offset;
+    std::size_t k = segmentOf(position, offset);
+    return records[k].load(std::memory_order_acquire)[offset];
+}
+
+const BorrowRecord& RecordLog::at(std::size_t position) const {
+    std::size_t offset;
+    std::size_t k = segmentOf(position, offset);
+    return records[k].load(std::memory_order_acquire)[offset];
+}
+
+std::size_t RecordLog::size() const {
+    return count.load(std::memory_order_acquire);
+}
+
+void RecordLog::clear() {
+    for (std::size_t k = 0; k < SEGMENTS; ++k) {
+        delete[] records[k].exchange(nullptr, std::memory_order_relaxed);
+        delete[] positions[k].exchange(nullptr, std::memory_order_relaxed);
+        delete[] userColumn[k].exchange(nullptr, std::memory_order_relaxed);
+        delete[] bookColumn[k].exchange(nullptr, std::memory_order_relaxed);
+        delete[] borrowedColumn[k].exchange(nullptr, std::memory_order_relaxed);
+        delete[] dueColumn[k].exchange(nullptr, std::memory_order_relaxed);
+        delete[] returnedColumn[k].exchange(nullptr, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+}
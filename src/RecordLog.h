@@ -0,0 +1,129 @@
+#ifndef RECORD_LOG_H
+#define RECORD_LOG_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include "BorrowRecord.h"
+
+/*
+ * RecordLog.h
+ * Declares the RecordLog class, the Library's borrow history: every record
+ * ever loaded or borrowed, in the order it was added, plus a direct-addressed
+ * record ID -> position table.
+ *
+ * Next to the records the log keeps a columnar copy of the integer fields
+ * (user key, book key and the three day numbers), one array per field, for
+ * the group-by reports in LoanReport.h: a report reads 4 to 12 bytes per
+ * record from these instead of the whole 32-byte record. Append fills in both,
+ * and a return has to go through markReturned() so the returned column
+ * follows the record.
+ *
+ * Both live in segments that double in size and never move, so appending
+ * never relocates a record and several threads can append at once: each
+ * append claims the next position with one atomic add, fills it in, then
+ * publishes the record's ID. find() only sees a record once its ID is
+ * published, and a record found that way is complete.
+ *
+ * What the log doesn't do is order appends against readers that walk it:
+ * size(), forEachRun() and forEachColumnRun() count a claimed position before its record is
+ * filled in. The Library only walks the log while every loan shard is locked
+ * (or the catalog is held exclusively), when no append is in progress.
+ */
+
+class RecordLog {
+public:
+    static constexpr std::size_t NONE = SIZE_MAX;
+
+private:
+    // Segment k holds positions (and IDs) [FIRST * (2^k - 1), FIRST * (2^(k+1) - 1))
+    static constexpr unsigned FIRST_BITS = 12;
+    static constexpr std::size_t FIRST = std::size_t(1) << FIRST_BITS;
+    static constexpr std::size_t SEGMENTS = 64 - FIRST_BITS;
+
+public:
+    // Highest record ID (and position) the segments can address
+    static constexpr std::uint64_t MAX_ID = ~std::uint64_t(0) - FIRST;
+
+private:
+
+    std::atomic<BorrowRecord*> records[SEGMENTS];
+    std::atomic<std::atomic<std::size_t>*> positions[SEGMENTS]; // ID -> position + 1, 0 if unused
+    std::atomic<std::uint32_t*> userColumn[SEGMENTS];            // by position, like records
+    std::atomic<std::uint32_t*> bookColumn[SEGMENTS];
+    std::atomic<DayNumber*> borrowedColumn[SEGMENTS];
+    std::atomic<DayNumber*> dueColumn[SEGMENTS];
+    std::atomic<DayNumber*> returnedColumn[SEGMENTS];
+    std::atomic<std::size_t> count;
+
+    static std::size_t segmentOf(std::uint64_t index, std::size_t& offset);
+    template <typename T>
+    static T* segment(std::atomic<T*>* table, std::size_t k); // allocates it on first use
+
+public:
+    RecordLog();
+    RecordLog(const RecordLog&) = delete;
+    RecordLog& operator=(const RecordLog&) = delete;
+    ~RecordLog();
+
+    // Adds rec at the next position and publishes its ID, safe on any thread.
+    // The ID must not be in the log yet and must be at most MAX_ID (the
+    // Library checks IDs from files and the journal with isLoadableID).
+    // Returns the position.
+    std::size_t append(const BorrowRecord& rec);
+
+    // The record with this ID, nullptr if none is published
+    BorrowRecord* find(std::uint64_t id);
+    const BorrowRecord* find(std::uint64_t id) const;
+    std::size_t positionOf(std::uint64_t id) const; // NONE if none is published
+
+    // Sets the return day of the record at position, in the record and its column
+    void markReturned(std::size_t position, DayNumber day);
+
+    BorrowRecord& at(std::size_t position);
+    const BorrowRecord& at(std::size_t position) const;
+    std::size_t size() const;
+
+    // Calls f(first, n) for each contiguous run of records, in log order
+    template <typename F>
+    void forEachRun(F f) const {
+        const std::size_t n = size();
+        std::size_t done = 0;
+        for (std::size_t k = 0; done < n; ++k) {
+            std::size_t len = std::min(FIRST << k, n - done);
+            f(static_cast<const BorrowRecord*>(records[k].load(std::memory_order_acquire)), len);
+            done += len;
+        }
+    }
+
+    // One contiguous run of the columns, n rows each
+    struct ColumnRun {
+        const std::uint32_t* user;
+        const std::uint32_t* book;
+        const DayNumber* borrowed;
+        const DayNumber* due;
+        const DayNumber* returned;
+        std::size_t n;
+    };
+
+    // Calls f(const ColumnRun&) for each contiguous run of the columns, in log order
+    template <typename F>
+    void forEachColumnRun(F f) const {
+        const std::size_t n = size();
+        std::size_t done = 0;
+        for (std::size_t k = 0; done < n; ++k) {
+            ColumnRun run{ userColumn[k].load(std::memory_order_acquire), bookColumn[k].load(std::memory_order_acquire),
+                           borrowedColumn[k].load(std::memory_order_acquire), dueColumn[k].load(std::memory_order_acquire),
+                           returnedColumn[k].load(std::memory_order_acquire), std::min(FIRST << k, n - done) };
+            f(run);
+            done += run.n;
+        }
+    }
+
+    // Not thread safe
+    void clear();
+};
+
+#endif
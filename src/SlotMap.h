@@ -0,0 +1,204 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+
+/*
+ * SlotMap.h
+ * Declares the SlotMap class template, a dense array of values addressed
+ * through stable, generation-checked handles.
+ *
+ * Values live contiguously in insertion order, so iterating a SlotMap walks
+ * one array in the order values were added. Each value also owns a slot: a
+ * small fixed entry that records where the value currently sits. A slot
+ * number never changes while its value exists, so indexes can store slot
+ * numbers and are not touched when other values move.
+ *
+ * Erase leaves a hole (the value is reset and skipped by iteration) rather
+ * than moving another value into the gap, so erasing never reorders what is
+ * left. Once holes outnumber values the array is compacted in one pass,
+ * keeping order, which keeps erase amortized O(1).
+ *
+ * A Handle is a slot number plus the slot's generation. Erasing a value frees
+ * its slot and bumps the generation, so a handle to an erased value stops
+ * resolving instead of pointing at whatever reuses the slot. Insert, erase and
+ * handle lookups are O(1) (erase amortized).
+ *
+ * Pointers and references to values are only good until the next insert or
+ * erase; hold a Handle (or a slot number kept in step with the map) for longer.
+ */
+
+template <typename T>
+class SlotMap {
+public:
+    static constexpr std::uint32_t NO_SLOT = UINT32_MAX;
+
+    struct Handle {
+        std::uint32_t slot = NO_SLOT;
+        std::uint32_t generation = 0;
+
+        bool operator==(const Handle& other) const { return slot == other.slot && generation == other.generation; }
+        bool operator!=(const Handle& other) const { return !(*this == other); }
+    };
+
+private:
+    struct Slot {
+        std::uint32_t position;   // index into values while in use, next free slot while free
+        std::uint32_t generation; // bumped every time the slot is freed
+        bool used;
+    };
+
+    std::vector<T> values;
+    std::vector<std::uint32_t> owners; // position -> slot, NO_SLOT for a hole left by erase
+    std::vector<Slot> slots;
+    std::uint32_t freeHead = NO_SLOT;  // most recently freed slot, NO_SLOT if none
+    std::size_t live = 0;              // values that are not holes
+
+    void freeSlot(std::uint32_t slot) {
+        slots[slot].used = false;
+        slots[slot].generation++;
+        slots[slot].position = freeHead;
+        freeHead = slot;
+    }
+
+    // Squeezes the holes out, keeping the remaining values in order
+    void compact() {
+        std::size_t out = 0;
+        for (std::size_t pos = 0; pos < values.size(); pos++) {
+            if (owners[pos] == NO_SLOT)
+                continue;
+            if (out != pos) {
+                values[out] = std::move(values[pos]);
+                owners[out] = owners[pos];
+            }
+            slots[owners[out]].position = static_cast<std::uint32_t>(out);
+            out++;
+        }
+        values.resize(out);
+        owners.resize(out);
+    }
+
+    template <typename Map, typename Value>
+    class Iterator {
+        Map* map;
+        std::size_t pos;
+
+        void skipHoles() {
+            while (pos < map->owners.size() && map->owners[pos] == NO_SLOT)
+                pos++;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value*;
+        using reference = Value&;
+
+        Iterator(Map* m, std::size_t p) : map(m), pos(p) { skipHoles(); }
+
+        Value& operator*() const { return map->values[pos]; }
+        Value* operator->() const { return &map->values[pos]; }
+        Iterator& operator++() { pos++; skipHoles(); return *this; }
+        Iterator operator++(int) { Iterator old = *this; ++*this; return old; }
+        bool operator==(const Iterator& other) const { return pos == other.pos; }
+        bool operator!=(const Iterator& other) const { return pos != other.pos; }
+
+        // Slot of the value the iterator is on
+        std::uint32_t slot() const { return map->owners[pos]; }
+    };
+
+public:
+    using iterator = Iterator<SlotMap, T>;
+    using const_iterator = Iterator<const SlotMap, const T>;
+
+    // Adds a value at the end of the iteration order and returns its handle.
+    // Freed slots are reused first.
+    Handle insert(T value) {
+        std::uint32_t slot = freeHead;
+        if (slot != NO_SLOT) {
+            freeHead = slots[slot].position;
+        }
+        else {
+            slot = static_cast<std::uint32_t>(slots.size());
+            slots.push_back(Slot{ 0, 0, false });
+        }
+
+        slots[slot].position = static_cast<std::uint32_t>(values.size());
+        slots[slot].used = true;
+        values.push_back(std::move(value));
+        owners.push_back(slot);
+        live++;
+        return Handle{ slot, slots[slot].generation };
+    }
+
+    // Removes the value in slot (which must be in use). Other values keep their order.
+    void eraseSlot(std::uint32_t slot) {
+        std::uint32_t pos = slots[slot].position;
+        values[pos] = T(); // drop what the value owns now, not at compaction
+        owners[pos] = NO_SLOT;
+        live--;
+        freeSlot(slot);
+
+        if (values.size() - live > live)
+            compact();
+    }
+
+    bool erase(Handle h) {
+        if (!contains(h))
+            return false;
+        eraseSlot(h.slot);
+        return true;
+    }
+
+    bool contains(Handle h) const {
+        return h.slot < slots.size() && slots[h.slot].used && slots[h.slot].generation == h.generation;
+    }
+
+    // nullptr if the handle's value was erased
+    T* get(Handle h) { return contains(h) ? &values[slots[h.slot].position] : nullptr; }
+    const T* get(Handle h) const { return contains(h) ? &values[slots[h.slot].position] : nullptr; }
+
+    // Unchecked access by slot number, for indexes that are kept in step with the map
+    T& atSlot(std::uint32_t slot) { return values[slots[slot].position]; }
+    const T& atSlot(std::uint32_t slot) const { return values[slots[slot].position]; }
+    Handle handleOf(std::uint32_t slot) const { return Handle{ slot, slots[slot].generation }; }
+
+    // Iteration in insertion order; iterator::slot() gives each value's slot
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, values.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, values.size()); }
+
+    std::size_t size() const { return live; }
+    bool empty() const { return live == 0; }
+    std::size_t slotCount() const { return slots.size(); } // every slot number is below this
+
+    void reserve(std::size_t n) {
+        values.reserve(n);
+        owners.reserve(n);
+        slots.reserve(n);
+    }
+
+    // Erases every value. Outstanding handles stop resolving, and slots are
+    // handed out again from 0 so a reload numbers values as a fresh map would.
+    void clear() {
+        values.clear();
+        owners.clear();
+        live = 0;
+        freeHead = NO_SLOT;
+        for (std::size_t i = slots.size(); i-- > 0;) {
+            if (slots[i].used)
+                slots[i].generation++;
+            slots[i].used = false;
+            slots[i].position = freeHead;
+            freeHead = static_cast<std::uint32_t>(i);
+        }
+    }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "Snapshot.h"
+#include "Library.h"
+#include "MappedFile.h"
+#include <fstream>
+#include <cstdio>
+
+/*
+ * Snapshot.cpp
+ * Implements the snapshot buffer helpers from Snapshot.h and the
+ * Library::saveSnapshot() / Library::loadSnapshot() pair.
+ *
+ * Loading reads and checks the whole snapshot into temporary objects first,
+ * so a truncated or foreign file leaves the Library as it was (apart from
+ * symbols that nothing refers to) and the caller can fall back to the CSV
+ * files. Once everything checks out the temporaries are moved in; nothing is
+ * parsed, hashed or sorted again except the ISBN and user ID hash maps.
+ */
+
+// SnapshotWriter
+const std::string& SnapshotWriter::bytes() const {
+    return buffer;
+}
+
+// SnapshotReader
+SnapshotReader::SnapshotReader(std::string_view data) : rest(data) {}
+
+bool SnapshotReader::getStrings(std::vector<std::string_view>& strings, std::string_view* blob) {
+    std::vector<std::uint32_t> lengths;
+    if (!getArray(lengths))
+        return false;
+
+    std::uint64_t total = 0;
+    for (std::uint32_t len : lengths)
+        total += len;
+    if (total > rest.size())
+        return false;
+
+    strings.clear();
+    strings.reserve(lengths.size());
+    std::size_t at = 0;
+    for (std::uint32_t len : lengths) {
+        strings.push_back(rest.substr(at, len));
+        at += len;
+    }
+    if (blob)
+        *blob = rest.substr(0, at);
+    rest.remove_prefix(at);
+    return true;
+}
+
+bool SnapshotReader::atEnd() const {
+    return rest.empty();
+}
+
+// Helper: new slot of every old slot (NO_SLOT where there is no value), in iteration order
+template <typename T>
+static std::vector<std::uint32_t> slotRemapOf(const SlotMap<T>& map) {
+    std::vector<std::uint32_t> remap(map.slotCount(), SlotMap<T>::NO_SLOT);
+    std::uint32_t next = 0;
+    for (auto it = map.begin(); it != map.end(); ++it)
+        remap[it.slot()] = next++;
+    return remap;
+}
+
+// Helper: a key -> slot table with its slots renumbered
+static std::vector<std::uint32_t> remapSlots(std::vector<std::uint32_t> table, const std::vector<std::uint32_t>& remap) {
+    for (std::uint32_t& slot : table)
+        if (slot < remap.size())
+            slot = remap[slot];
+    return table;
+}
+
+// Helper: a key -> slot table is valid if every slot below count appears
+// once, under a key whose name is keyOf(that slot)
+template <typename KeyOf>
+static bool isSlotTable(const std::vector<std::uint32_t>& table, std::size_t count, const SymbolTable& names, KeyOf keyOf) {
+    if (table.size() > names.size())
+        return false;
+    std::vector<bool> seen(count, false);
+    std::size_t found = 0;
+    for (std::uint32_t key = 0; key < table.size(); ++key) {
+        std::uint32_t slot = table[key];
+        if (slot == OpenLoanColumns::NO_USER)
+            continue;
+        if (slot >= count || seen[slot] || names.name(key) != keyOf(slot))
+            return false;
+        seen[slot] = true;
+        found++;
+    }
+    return found == count;
+}
+
+// Save the whole library state, written to a temp file and renamed into place
+bool Library::saveSnapshot(const std::string& filename) const {
+    std::unique_lock lock(catalogLock);
+    SnapshotWriter out;
+    out.put(SNAPSHOT_MAGIC);
+    out.put(SNAPSHOT_VERSION);
+    out.put(BYTE_ORDER_MARK);
+    out.put(SymbolTable::hashCheck());
+    out.put(nextRecordID.load());
+    out.put(changeSeq.load());
+
+    // Books
+    const std::vector<std::uint32_t> bookRemap = slotRemapOf(books);
+    std::vector<std::string_view> strings;
+    std::vector<std::uint32_t> years, totals, available;
+    for (const auto& b : books) {
+        strings.push_back(b.getISBN());
+        strings.push_back(b.getTitle());
+        strings.push_back(b.getAuthor());
+        years.push_back(b.getYear());
+        totals.push_back(b.getCopiesTotal());
+        available.push_back(b.getCopiesAvailable());
+    }
+    out.put(static_cast<std::uint64_t>(books.size()));
+    out.putStrings(strings);
+    out.putArray(years);
+    out.putArray(totals);
+    out.putArray(available);
+    out.putArray(remapSlots(bookSlotByKey, bookRemap));
+    out.putStrings(rejectedBooks);
+    out.put(booksCheckpoint);
+
+    // Users
+    const std::vector<std::uint32_t> userRemap = slotRemapOf(users);
+    strings.clear();
+    std::vector<std::uint8_t> kinds, types;
+    std::vector<double> fees;
+    for (const auto& v : users) {
+        const User& u = userOf(v);
+        strings.push_back(u.getID());
+        strings.push_back(u.getName());
+
+        if (const Student* s = std::get_if<Student>(&v)) {
+            strings.push_back(s->getMajor());
+            kinds.push_back(static_cast<std::uint8_t>(SnapshotUserKind::STUDENT));
+        }
+        else if (const Teacher* t = std::get_if<Teacher>(&v)) {
+            strings.push_back(t->getDepartment());
+            kinds.push_back(static_cast<std::uint8_t>(SnapshotUserKind::TEACHER));
+        }
+        else {
+            strings.push_back(std::string_view());
+            kinds.push_back(static_cast<std::uint8_t>(SnapshotUserKind::USER));
+        }
+        types.push_back(static_cast<std::uint8_t>(u.getUserType()));
+        fees.push_back(u.getFeesDue());
+    }
+    out.put(static_cast<std::uint64_t>(users.size()));
+    out.putStrings(strings);
+    out.putArray(kinds);
+    out.putArray(types);
+    out.putArray(fees);
+    out.putArray(remapSlots(userSlotByKey, userRemap));
+    out.putStrings(rejectedUsers);
+    out.put(usersCheckpoint);
+
+    keywordIndex.save(out, bookRemap);
+    prefixIndex.save(out, bookRemap);
+
+    // Records, the integer fields straight from the record log's columns
+    std::vector<std::uint64_t> ids;
+    std::vector<std::uint32_t> userKeys, bookKeys;
+    std::vector<DayNumber> borrowed, due, returned;
+    ids.reserve(records.size());
+    records.forEachRun([&](const BorrowRecord* run, std::size_t n) {
+        for (const BorrowRecord* r = run; r != run + n; ++r)
+            ids.push_back(r->getRecordID());
+    });
+    records.forEachColumnRun([&](const RecordLog::ColumnRun& run) {
+        userKeys.insert(userKeys.end(), run.user, run.user + run.n);
+        bookKeys.insert(bookKeys.end(), run.book, run.book + run.n);
+        borrowed.insert(borrowed.end(), run.borrowed, run.borrowed + run.n);
+        due.insert(due.end(), run.due, run.due + run.n);
+        returned.insert(returned.end(), run.returned, run.returned + run.n);
+    });
+    out.put(static_cast<std::uint64_t>(ids.size()));
+    out.putArray(ids);
+    out.putArray(userKeys);
+    out.putArray(bookKeys);
+    out.putArray(borrowed);
+    out.putArray(due);
+    out.putArray(returned);
+    out.putStrings(rejectedRecords);
+
+    symbols.userIDs.save(out);
+    symbols.isbns.save(out);
+
+    std::string tmp = filename + ".tmp";
+    {
+        std::ofstream fout(tmp, std::ios::binary | std::ios::trunc);
+        if (!fout.is_open())
+            return false;
+        fout.write(out.bytes().data(), static_cast<std::streamsize>(out.bytes().size()));
+        fout.close();
+        if (!fout) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+// Load a snapshot written by saveSnapshot into a Library that has loaded
+// nothing yet, returns false if it is missing or invalid
+bool Library::loadSnapshot(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename))
+        return false;
+
+    std::unique_lock lock(catalogLock);
+    if (symbols.userIDs.size() != 0 || symbols.isbns.size() != 0 || records.size() != 0)
+        return false;
+    SnapshotReader in(file.contents());
+
+    char magic[8];
+    std::uint32_t version, byteOrder, hashCheck;
+    std::uint64_t savedNextID, savedSeq;
+    if (!in.get(magic) || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0)
+        return false;
+    if (!in.get(version) || version != SNAPSHOT_VERSION)
+        return false;
+    if (!in.get(byteOrder) || byteOrder != BYTE_ORDER_MARK)
+        return false;
+    if (!in.get(hashCheck) || hashCheck != SymbolTable::hashCheck())
+        return false;
+    if (!in.get(savedNextID) || !in.get(savedSeq))
+        return false;
+
+    // Books
+    std::uint64_t nBooks;
+    std::vector<std::string_view> strings, loadedRejectedBooks;
+    std::vector<std::uint32_t> years, totals, available, loadedBookSlots;
+    std::uint64_t loadedBooksCheckpoint;
+    if (!in.get(nBooks) || !in.getStrings(strings) || strings.size() != nBooks * 3)
+        return false;
+    if (!in.getArray(years) || !in.getArray(totals) || !in.getArray(available) || years.size() != nBooks ||
+        totals.size() != nBooks || available.size() != nBooks)
+        return false;
+    if (!in.getArray(loadedBookSlots) || !in.getStrings(loadedRejectedBooks) || !in.get(loadedBooksCheckpoint))
+        return false;
+
+    // Text goes into fresh arenas, they replace the current ones once everything checked out
+    StringArena loadedBookText, loadedUserText;
+    std::vector<Book> loadedBooks;
+    std::unordered_map<std::string, std::uint32_t> loadedBookIndex;
+    long loadedCopiesOut = 0;
+    loadedBooks.reserve(nBooks);
+    loadedBookIndex.reserve(nBooks);
+    for (std::uint32_t i = 0; i < nBooks; ++i) {
+        loadedBooks.emplace_back(strings[i * 3], strings[i * 3 + 1], strings[i * 3 + 2],
+                                 years[i], totals[i], available[i], &loadedBookText);
+        if (!loadedBookIndex.emplace(loadedBooks.back().getISBN(), i).second)
+            return false;
+        loadedCopiesOut += static_cast<long>(totals[i]) - static_cast<long>(available[i]);
+    }
+
+    // Users
+    std::uint64_t nUsers;
+    std::vector<std::string_view> loadedRejectedUsers;
+    std::vector<std::uint8_t> kinds, types;
+    std::vector<double> fees;
+    std::vector<std::uint32_t> loadedUserSlots;
+    std::uint64_t loadedUsersCheckpoint;
+    if (!in.get(nUsers) || !in.getStrings(strings) || strings.size() != nUsers * 3)
+        return false;
+    if (!in.getArray(kinds) || !in.getArray(types) || !in.getArray(fees) || kinds.size() != nUsers ||
+        types.size() != nUsers || fees.size() != nUsers)
+        return false;
+    if (!in.getArray(loadedUserSlots) || !in.getStrings(loadedRejectedUsers) || !in.get(loadedUsersCheckpoint))
+        return false;
+
+    std::vector<UserVariant> loadedUsers;
+    std::unordered_map<std::string, std::uint32_t> loadedUserIndex;
+    loadedUsers.reserve(nUsers);
+    loadedUserIndex.reserve(nUsers);
+    for (std::uint32_t i = 0; i < nUsers; ++i) {
+        std::string id(strings[i * 3]);
+        std::string_view name = strings[i * 3 + 1], extra = strings[i * 3 + 2];
+
+        switch (static_cast<SnapshotUserKind>(kinds[i])) {
+            case SnapshotUserKind::STUDENT:
+                loadedUsers.emplace_back(std::in_place_type<Student>, std::move(id), name, extra, &loadedUserText);
+                break;
+            case SnapshotUserKind::TEACHER:
+                loadedUsers.emplace_back(std::in_place_type<Teacher>, std::move(id), name, extra, &loadedUserText);
+                break;
+            case SnapshotUserKind::USER:
+                if (types[i] > static_cast<std::uint8_t>(UserType::OTHER))
+                    return false;
+                loadedUsers.emplace_back(std::in_place_type<User>, std::move(id), name,
+                                         static_cast<UserType>(types[i]), &loadedUserText);
+                break;
+            default:
+                return false;
+        }
+        User& u = userOf(loadedUsers.back());
+        u.addFees(fees[i]);
+        if (!loadedUserIndex.emplace(u.getID(), i).second)
+            return false;
+    }
+
+    // Indexes
+    KeywordIndex loadedKeywords;
+    PrefixIndex loadedPrefixes;
+    if (!loadedKeywords.load(in, nBooks) || !loadedPrefixes.load(in, nBooks))
+        return false;
+
+    // Records
+    std::uint64_t nRecords;
+    std::vector<std::uint64_t> ids;
+    std::vector<std::uint32_t> userKeys, bookKeys;
+    std::vector<DayNumber> borrowed, due, returned;
+    std::vector<std::string_view> loadedRejectedRecords;
+    if (!in.get(nRecords) || !in.getArray(ids) || !in.getArray(userKeys) || !in.getArray(bookKeys) ||
+        !in.getArray(borrowed) || !in.getArray(due) || !in.getArray(returned) || !in.getStrings(loadedRejectedRecords))
+        return false;
+    if (ids.size() != nRecords || userKeys.size() != nRecords || bookKeys.size() != nRecords ||
+        borrowed.size() != nRecords || due.size() != nRecords || returned.size() != nRecords)
+        return false;
+
+    // IDs must be loadable, distinct and below the next ID
+    if (savedNextID == 0 || !isLoadableID(savedNextID - 1, nRecords + 1))
+        return false;
+    std::vector<bool> idTaken;
+    for (std::uint64_t id : ids) {
+        if (!isLoadableID(id, nRecords) || id >= savedNextID)
+            return false;
+        if (id >= idTaken.size())
+            idTaken.resize(id + 1, false);
+        if (idTaken[id])
+            return false;
+        idTaken[id] = true;
+    }
+
+    // Symbols last, everything before refers to their ids
+    if (!symbols.userIDs.load(in) || !symbols.isbns.load(in) || !in.atEnd())
+        return false;
+    for (std::size_t i = 0; i < nRecords; ++i)
+        if (userKeys[i] >= symbols.userIDs.size() || bookKeys[i] >= symbols.isbns.size())
+            return false;
+    if (!isSlotTable(loadedBookSlots, nBooks, symbols.isbns,
+                     [&](std::uint32_t slot) { return std::string_view(loadedBooks[slot].getISBN()); }) ||
+        !isSlotTable(loadedUserSlots, nUsers, symbols.userIDs,
+                     [&](std::uint32_t slot) { return std::string_view(userOf(loadedUsers[slot]).getID()); }))
+        return false;
+
+    // Everything checked out, replace the current state. A fresh load numbers
+    // slots from 0 in order, the order the snapshot's slots were saved in.
+    clearBooks();
+    bookText = std::move(loadedBookText);
+    books.reserve(nBooks);
+    for (auto& b : loadedBooks)
+        books.insert(std::move(b));
+    bookIndex.swap(loadedBookIndex);
+    bookSlotByKey.swap(loadedBookSlots);
+    copiesOut = loadedCopiesOut;
+    keywordIndex = std::move(loadedKeywords);
+    prefixIndex = std::move(loadedPrefixes);
+    rejectedBooks.assign(loadedRejectedBooks.begin(), loadedRejectedBooks.end());
+    booksCheckpoint = loadedBooksCheckpoint;
+
+    clearUsers();
+    userText = std::move(loadedUserText);
+    users.reserve(nUsers);
+    for (auto& u : loadedUsers)
+        users.insert(std::move(u));
+    userIndex.swap(loadedUserIndex);
+    userSlotByKey.swap(loadedUserSlots);
+    for (std::uint32_t key = 0; key < userSlotByKey.size(); ++key)
+        if (userSlotByKey[key] != NO_SLOT)
+            countUserFees(key, userOf(users.atSlot(userSlotByKey[key])).getFeesDue(), 1);
+    rejectedUsers.assign(loadedRejectedUsers.begin(), loadedRejectedUsers.end());
+    usersCheckpoint = loadedUsersCheckpoint;
+
+    clearRecords();
+    for (std::size_t i = 0; i < nRecords; ++i) {
+        BorrowRecord r(ids[i], userKeys[i], bookKeys[i], borrowed[i], due[i]);
+        if (returned[i] != BorrowRecord::NOT_RETURNED)
+            r.markReturned(returned[i]);
+        records.append(r);
+    }
+    for (std::size_t i = 0; i < nRecords; ++i)
+        if (returned[i] == BorrowRecord::NOT_RETURNED)
+            addOpenLoan(records.at(i));
+    rejectedRecords.assign(loadedRejectedRecords.begin(), loadedRejectedRecords.end());
+    nextRecordID = savedNextID;
+    changeSeq = savedSeq;
+    return true;
+}
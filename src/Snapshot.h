@@ -0,0 +1,133 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Snapshot.h
+ * Declares the binary snapshot format and the byte buffer helpers that
+ * Library::saveSnapshot() and Library::loadSnapshot() use.
+ *
+ * A snapshot holds the whole library state so startup can skip both CSV
+ * parsing and index building. CSV stays the import/export format; the
+ * snapshot is only a faster copy of what the CSV files hold, written right
+ * after they are saved.
+ *
+ * Besides the data it stores the built lookup structures: the user ID and
+ * ISBN symbol tables with their probe tables, the key -> slot tables, the
+ * keyword index's posting lists and the prefix index's sorted entries. Each
+ * of those classes writes and reads its own section (save/load), so its
+ * layout is described next to its members. Books and users are stored in
+ * iteration order and take slots 0..n-1 on load, as a CSV load would give
+ * them; slots saved in the index sections are renumbered to match.
+ *
+ * Layout (native byte order, checked through BYTE_ORDER_MARK):
+ *  - Header:   magic "LIBSNAP\0", uint32 version, uint32 byte order mark,
+ *              uint32 SymbolTable::hashCheck(), uint64 next record ID,
+ *              uint64 change sequence
+ *  - Books:    uint64 n, string table (isbn, title, author per book),
+ *              uint32 year[n], uint32 copiesTotal[n], uint32 copiesAvailable[n],
+ *              uint32 slot by ISBN key, string table of rejected lines,
+ *              uint64 checkpoint
+ *  - Users:    uint64 n, string table (id, name, major/department per user),
+ *              uint8 kind[n], uint8 userType[n], double feesDue[n],
+ *              uint32 slot by user key, string table of rejected lines,
+ *              uint64 checkpoint
+ *  - KeywordIndex::save, PrefixIndex::save
+ *  - Records:  uint64 n, uint64 recordID[n], uint32 userKey[n],
+ *              uint32 bookKey[n], int32 borrowedDay[n], int32 dueDay[n],
+ *              int32 returnDay[n] (BorrowRecord::NOT_RETURNED for open
+ *              loans), string table of rejected lines
+ *  - SymbolTable::save for user IDs, then for ISBNs
+ *
+ * An array is uint64 count then the values; a string table is uint64 count,
+ * uint32 length[count], then the bytes of every string back to back. Every
+ * section is a fixed-width array, so a snapshot is written and read with one
+ * bulk copy per column.
+ */
+
+static const char SNAPSHOT_MAGIC[8] = { 'L', 'I', 'B', 'S', 'N', 'A', 'P', '\0' };
+static const std::uint32_t SNAPSHOT_VERSION = 3; // 3: index sections
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+// Kind tag stored per user
+enum class SnapshotUserKind : std::uint8_t { USER = 0, STUDENT = 1, TEACHER = 2 };
+
+// Appends fixed-width values, arrays and string tables to an in-memory buffer
+class SnapshotWriter {
+private:
+    std::string buffer;
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void putArray(const std::vector<T>& values) {
+        put(static_cast<std::uint64_t>(values.size()));
+        if (!values.empty())
+            buffer.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    template <typename Strings>
+    void putStrings(const Strings& strings) {
+        put(static_cast<std::uint64_t>(strings.size()));
+        for (const auto& s : strings)
+            put(static_cast<std::uint32_t>(std::string_view(s).size()));
+        for (const auto& s : strings)
+            buffer.append(std::string_view(s).data(), std::string_view(s).size());
+    }
+
+    const std::string& bytes() const;
+};
+
+// Reads the same values back, every read is bounds checked. Strings are views
+// into the buffer being read.
+class SnapshotReader {
+private:
+    std::string_view rest;
+
+public:
+    explicit SnapshotReader(std::string_view data);
+
+    template <typename T>
+    bool get(T& value) {
+        if (rest.size() < sizeof(T))
+            return false;
+        std::memcpy(&value, rest.data(), sizeof(T));
+        rest.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    bool getArray(std::vector<T>& values) {
+        std::uint64_t n;
+        if (!get(n) || n > rest.size() / sizeof(T))
+            return false;
+        values.resize(n);
+        if (n > 0)
+            std::memcpy(values.data(), rest.data(), n * sizeof(T));
+        rest.remove_prefix(n * sizeof(T));
+        return true;
+    }
+
+    // blob, when given, is set to the bytes of all the strings together
+    bool getStrings(std::vector<std::string_view>& strings, std::string_view* blob = nullptr);
+
+    bool atEnd() const;
+};
+
+// Helper: strings read with SnapshotReader::getStrings, moved onto copy (the
+// same bytes as blob, stored somewhere that outlives the reader)
+inline void rebaseStrings(std::vector<std::string_view>& strings, std::string_view blob, const char* copy) {
+    for (auto& s : strings)
+        s = std::string_view(copy + (s.data() - blob.data()), s.size());
+}
+
+#endif
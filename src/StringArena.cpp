@@ -0,0 +1,173 @@
+#include "StringArena.h"
+#include <cstring>
+#include <ostream>
+#include <utility>
+
+/*
+ * StringArena.cpp
+ * Implements StringArena and ArenaString declared in StringArena.h.
+ */
+
+// StringArena
+StringArena::StringArena() : blocks(), next(nullptr), left(0), used(0) {}
+
+StringArena::StringArena(StringArena&& other) noexcept
+    : blocks(std::move(other.blocks)), next(other.next), left(other.left), used(other.used) {
+    other.next = nullptr;
+    other.left = 0;
+    other.used = 0;
+}
+
+StringArena& StringArena::operator=(StringArena&& other) noexcept {
+    if (this != &other) {
+        blocks = std::move(other.blocks);
+        next = other.next;
+        left = other.left;
+        used = other.used;
+        other.blocks.clear();
+        other.next = nullptr;
+        other.left = 0;
+        other.used = 0;
+    }
+    return *this;
+}
+
+std::string_view StringArena::store(std::string_view text) {
+    if (text.empty())
+        return std::string_view();
+
+    // Long strings get a block of their own, so they don't waste the rest of the current one
+    if (text.size() > BLOCK_SIZE / 4) {
+        blocks.emplace_back(new char[text.size()]);
+        std::memcpy(blocks.back().get(), text.data(), text.size());
+        used += text.size();
+        return std::string_view(blocks.back().get(), text.size());
+    }
+
+    if (text.size() > left) {
+        blocks.emplace_back(new char[BLOCK_SIZE]);
+        next = blocks.back().get();
+        left = BLOCK_SIZE;
+    }
+    char* start = next;
+    std::memcpy(start, text.data(), text.size());
+    next += text.size();
+    left -= text.size();
+    used += text.size();
+    return std::string_view(start, text.size());
+}
+
+std::size_t StringArena::bytesUsed() const {
+    return used;
+}
+
+void StringArena::clear() {
+    blocks.clear();
+    next = nullptr;
+    left = 0;
+    used = 0;
+}
+
+// ArenaString
+ArenaString::ArenaString() noexcept : ptr(""), len(0), owned(false) {}
+
+ArenaString::ArenaString(std::string_view text) : ArenaString() {
+    assignOwned(text);
+}
+
+ArenaString::ArenaString(std::string_view text, StringArena* arena) : ArenaString() {
+    if (arena) {
+        std::string_view stored = arena->store(text);
+        if (!stored.empty()) {
+            ptr = stored.data();
+            len = static_cast<std::uint32_t>(stored.size());
+        }
+    }
+    else {
+        assignOwned(text);
+    }
+}
+
+ArenaString::ArenaString(const ArenaString& other) : ArenaString() {
+    assignOwned(other.view());
+}
+
+ArenaString::ArenaString(ArenaString&& other) noexcept
+    : ptr(other.ptr), len(other.len), owned(other.owned) {
+    other.ptr = "";
+    other.len = 0;
+    other.owned = false;
+}
+
+ArenaString& ArenaString::operator=(const ArenaString& other) {
+    if (this != &other)
+        *this = other.view();
+    return *this;
+}
+
+ArenaString& ArenaString::operator=(ArenaString&& other) noexcept {
+    if (this != &other) {
+        release();
+        ptr = other.ptr;
+        len = other.len;
+        owned = other.owned;
+        other.ptr = "";
+        other.len = 0;
+        other.owned = false;
+    }
+    return *this;
+}
+
+ArenaString& ArenaString::operator=(std::string_view text) {
+    // text may point into this string's own block, copy before releasing it
+    ArenaString copy(text);
+    *this = std::move(copy);
+    return *this;
+}
+
+ArenaString::~ArenaString() {
+    release();
+}
+
+ArenaString ArenaString::borrow(std::string_view text) noexcept {
+    ArenaString s;
+    if (!text.empty()) {
+        s.ptr = text.data();
+        s.len = static_cast<std::uint32_t>(text.size());
+    }
+    return s;
+}
+
+void ArenaString::keepIn(StringArena* arena) {
+    if (owned || len == 0)
+        return;
+    if (arena)
+        ptr = arena->store(view()).data();
+    else
+        assignOwned(view());
+}
+
+// Replaces the contents with an exact-size heap copy of text (empty text needs no block)
+void ArenaString::assignOwned(std::string_view text) {
+    release();
+    if (text.empty())
+        return;
+
+    char* block = new char[text.size()];
+    std::memcpy(block, text.data(), text.size());
+    ptr = block;
+    len = static_cast<std::uint32_t>(text.size());
+    owned = true;
+}
+
+void ArenaString::release() {
+    if (owned)
+        delete[] ptr;
+    ptr = "";
+    len = 0;
+    owned = false;
+}
+
+std::ostream& operator<<(std::ostream& os, const ArenaString& s) {
+    return os << s.view();
+}
\ No newline at end of file
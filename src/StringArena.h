@@ -0,0 +1,87 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <string>
+#include <string_view>
+#include <iosfwd>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * StringArena.h
+ * Declares StringArena, a monotonic buffer for the text of bulk-loaded books
+ * and users, and ArenaString, the string field type that can point into one.
+ *
+ * A load copies every title, author, name, major and department into a few
+ * large arena blocks instead of one heap allocation per string. Nothing is
+ * freed from an arena; the whole arena goes away at once, when the Library
+ * replaces or drops the collection it was loaded with.
+ *
+ * ArenaString is 16 bytes. It either owns its text (one exact-size heap
+ * block) or views text it doesn't own (an arena, or the line being parsed):
+ *  - Copies always own their text, so a copy can outlive the arena
+ *  - Moves keep the view, so objects moving around inside a Library
+ *    (vector growth, swap-with-last removal) stay in the arena
+ *  - Assigning new text makes the string owned (copy on write), the
+ *    arena text it pointed at is simply left unused
+ */
+
+class StringArena {
+private:
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* next;
+    std::size_t left;
+    std::size_t used;
+
+public:
+    StringArena();
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&& other) noexcept;
+    StringArena& operator=(StringArena&& other) noexcept;
+
+    // Copies text into the arena, the view stays valid for the arena's lifetime
+    std::string_view store(std::string_view text);
+
+    std::size_t bytesUsed() const; // text stored so far
+    void clear();                  // frees every block, only when nothing points into them
+};
+
+class ArenaString {
+private:
+    const char* ptr;
+    std::uint32_t len;
+    bool owned;
+
+    void assignOwned(std::string_view text);
+    void release();
+
+public:
+    ArenaString() noexcept;
+    explicit ArenaString(std::string_view text);            // owned copy
+    ArenaString(std::string_view text, StringArena* arena); // in arena, owned copy if arena is nullptr
+    ArenaString(const ArenaString& other);
+    ArenaString(ArenaString&& other) noexcept;
+    ArenaString& operator=(const ArenaString& other);
+    ArenaString& operator=(ArenaString&& other) noexcept;
+    ArenaString& operator=(std::string_view text);          // copy on write: always owned
+    ~ArenaString();
+
+    // A view of text owned by the caller, used while parsing (see keepIn)
+    static ArenaString borrow(std::string_view text) noexcept;
+
+    // Moves borrowed text into arena, or into an owned copy if arena is nullptr.
+    // Owned strings are left alone.
+    void keepIn(StringArena* arena);
+
+    std::string_view view() const { return std::string_view(ptr, len); }
+    bool isOwned() const { return owned; }
+};
+
+std::ostream& operator<<(std::ostream& os, const ArenaString& s);
+
+#endif
\ No newline at end of file
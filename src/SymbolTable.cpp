@@ -0,0 +1,224 @@
+#include "SymbolTable.h"
+#include "Snapshot.h"
+#include <functional>
+#include <mutex>
+
+/*
+ * SymbolTable.cpp
+ * Implements the SymbolTable class declared in SymbolTable.h.
+ */
+
+SymbolTable::SymbolTable() : lock(), slots(), text(), segments(), count(0) {
+    for (auto& s : segments)
+        s.store(nullptr, std::memory_order_relaxed);
+}
+
+SymbolTable::~SymbolTable() {
+    for (auto& s : segments)
+        delete[] s.load(std::memory_order_relaxed);
+}
+
+std::uint32_t SymbolTable::hashOf(std::string_view text) {
+    return static_cast<std::uint32_t>(std::hash<std::string_view>()(text));
+}
+
+// Segment number of an id and its offset inside that segment
+std::size_t SymbolTable::segmentOf(std::uint32_t id, std::size_t& offset) {
+    std::uint64_t v = std::uint64_t(id) + FIRST_SEGMENT;
+    unsigned top = 63 - static_cast<unsigned>(__builtin_clzll(v));
+    offset = static_cast<std::size_t>(v - (std::uint64_t(1) << top));
+    return top - FIRST_SEGMENT_BITS;
+}
+
+std::string_view& SymbolTable::entry(std::uint32_t id) const {
+    std::size_t offset;
+    std::size_t k = segmentOf(id, offset);
+    return segments[k].load(std::memory_order_acquire)[offset];
+}
+
+void SymbolTable::setEntry(std::uint32_t id, std::string_view name) {
+    std::size_t offset;
+    std::size_t k = segmentOf(id, offset);
+    std::string_view* segment = segments[k].load(std::memory_order_relaxed);
+    if (!segment) {
+        segment = new std::string_view[FIRST_SEGMENT << k];
+        segments[k].store(segment, std::memory_order_release);
+    }
+    segment[offset] = name;
+}
+
+// Linear probing from the hash's home slot
+std::size_t SymbolTable::probe(std::string_view text, std::uint32_t hash) const {
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = hash & mask;
+    while (slots[i].id != NONE) {
+        if (slots[i].hash == hash && entry(slots[i].id) == text)
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void SymbolTable::rehash(std::size_t capacity) {
+    std::vector<Slot> old;
+    old.swap(slots);
+    slots.assign(capacity, Slot{ 0, NONE });
+
+    const std::size_t mask = capacity - 1;
+    for (const Slot& s : old) {
+        if (s.id == NONE)
+            continue;
+        std::size_t i = s.hash & mask;
+        while (slots[i].id != NONE)
+            i = (i + 1) & mask;
+        slots[i] = s;
+    }
+}
+
+// Finds or adds text under a precomputed hash
+std::uint32_t SymbolTable::insert(std::string_view str, std::uint32_t hash) {
+    const std::uint32_t n = count.load(std::memory_order_relaxed);
+    // Keep the table at most half full
+    if ((std::size_t(n) + 1) * 2 > slots.size())
+        rehash(slots.empty() ? 64 : slots.size() * 2);
+
+    std::size_t i = probe(str, hash);
+    if (slots[i].id == NONE) {
+        setEntry(n, text.store(str));
+        slots[i] = Slot{ hash, n };
+        count.store(n + 1, std::memory_order_release);
+    }
+    return slots[i].id;
+}
+
+// Most calls find text already there, so a shared lookup comes first
+std::uint32_t SymbolTable::intern(std::string_view str) {
+    const std::uint32_t hash = hashOf(str);
+    {
+        std::shared_lock shared(lock);
+        if (!slots.empty()) {
+            std::uint32_t id = slots[probe(str, hash)].id;
+            if (id != NONE)
+                return id;
+        }
+    }
+    std::unique_lock exclusive(lock);
+    return insert(str, hash);
+}
+
+// Three passes: hash everything and prefetch the home slots, then prefetch the
+// text those slots point at, then do the real probes, which mostly hit cache
+void SymbolTable::internMany(const std::string_view* texts, std::size_t n, std::uint32_t* ids) {
+    std::uint32_t hashes[BATCH];
+
+    for (std::size_t i = 0; i < n; ++i)
+        hashes[i] = hashOf(texts[i]);
+
+    std::unique_lock exclusive(lock);
+    if (!slots.empty()) {
+        const std::size_t mask = slots.size() - 1;
+        for (std::size_t i = 0; i < n; ++i)
+            __builtin_prefetch(&slots[hashes[i] & mask]);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint32_t id = slots[hashes[i] & mask].id;
+            if (id != NONE)
+                __builtin_prefetch(entry(id).data());
+        }
+    }
+
+    for (std::size_t i = 0; i < n; ++i)
+        ids[i] = insert(texts[i], hashes[i]);
+}
+
+std::uint32_t SymbolTable::find(std::string_view str) const {
+    std::shared_lock shared(lock);
+    if (slots.empty())
+        return NONE;
+    return slots[probe(str, hashOf(str))].id;
+}
+
+std::string_view SymbolTable::name(std::uint32_t id) const {
+    return entry(id);
+}
+
+std::size_t SymbolTable::size() const {
+    return count.load(std::memory_order_acquire);
+}
+
+void SymbolTable::reserve(std::size_t n) {
+    std::unique_lock exclusive(lock);
+    std::size_t capacity = slots.empty() ? 64 : slots.size();
+    while (capacity < n * 2)
+        capacity *= 2;
+    if (capacity != slots.size())
+        rehash(capacity);
+}
+
+// Snapshot section
+std::uint32_t SymbolTable::hashCheck() {
+    return hashOf("SymbolTable");
+}
+
+void SymbolTable::save(SnapshotWriter& out) const {
+    std::shared_lock shared(lock);
+    const std::uint32_t n = count.load(std::memory_order_relaxed);
+    std::vector<std::string_view> names;
+    names.reserve(n);
+    for (std::uint32_t id = 0; id < n; ++id)
+        names.push_back(entry(id));
+    out.putStrings(names);
+    out.putArray(slots);
+}
+
+// Every check runs before the table is touched: the probe table must be a
+// power of two at most half full, hold each id exactly once under its name's
+// hash, and have no empty slot between an entry and its home slot
+bool SymbolTable::load(SnapshotReader& in) {
+    std::vector<std::string_view> names;
+    std::string_view blob;
+    std::vector<Slot> table;
+    if (!in.getStrings(names, &blob) || !in.getArray(table))
+        return false;
+
+    const std::size_t capacity = table.size();
+    if (names.size() >= NONE || (capacity & (capacity - 1)) != 0 || capacity < names.size() * 2)
+        return false;
+
+    if (capacity > 0) {
+        const std::size_t mask = capacity - 1;
+        std::size_t start = 0;
+        while (start < capacity && table[start].id != NONE)
+            start++;
+        if (start == capacity)
+            return false;
+
+        std::vector<bool> seen(names.size(), false);
+        std::size_t run = 0, used = 0; // run: occupied slots right before the current one
+        for (std::size_t k = 1; k <= capacity; ++k) {
+            std::size_t i = (start + k) & mask;
+            const Slot& s = table[i];
+            if (s.id == NONE) {
+                run = 0;
+                continue;
+            }
+            if (s.id >= names.size() || seen[s.id] || s.hash != hashOf(names[s.id]) || ((i - s.hash) & mask) > run)
+                return false;
+            seen[s.id] = true;
+            run++;
+            used++;
+        }
+        if (used != names.size())
+            return false;
+    }
+
+    std::unique_lock exclusive(lock);
+    if (count.load(std::memory_order_relaxed) != 0)
+        return false;
+
+    rebaseStrings(names, blob, text.store(blob).data());
+    for (std::uint32_t id = 0; id < names.size(); ++id)
+        setEntry(id, names[id]);
+    slots.swap(table);
+    count.store(static_cast<std::uint32_t>(names.size()), std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,97 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <shared_mutex>
+#include <cstdint>
+#include <cstddef>
+#include "StringArena.h"
+
+class SnapshotWriter;
+class SnapshotReader;
+
+/*
+ * SymbolTable.h
+ * Declares the SymbolTable class, which interns strings (user IDs, ISBNs) as
+ * dense 32-bit ids.
+ *
+ * The first string interned gets id 0, the next new one id 1, and so on.
+ * Symbols are never removed, so an id stays valid for the life of the table
+ * and can index a plain array.
+ *
+ * The text lives in a StringArena and the id -> text array is kept in
+ * segments that double in size and never move, so a view returned by name()
+ * stays valid for the life of the table, whatever is interned after it.
+ * name() takes no lock: an id can only be known after its entry was written.
+ * intern() and find() share a reader-writer lock, interning new text takes
+ * it exclusively.
+ *
+ * Lookups go through an open-addressing table of (hash, id) pairs, so a probe
+ * touches one small contiguous array and compares text only on a hash match.
+ * With a few hundred thousand symbols nearly every probe is a cache miss;
+ * internMany() hashes a whole batch first and prefetches its slots, so the
+ * misses of one batch overlap instead of being paid one after another.
+ *
+ * save() and load() copy the names and the probe table as they are, so a
+ * table read back from a snapshot answers find() without hashing anything
+ * again. Snapshot section: string table of names in id order, then the
+ * probe table as an array of (hash, id) pairs.
+ */
+
+class SymbolTable {
+public:
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+private:
+    struct Slot {
+        std::uint32_t hash;
+        std::uint32_t id; // NONE for an empty slot
+    };
+
+    // Segment k holds ids [FIRST_SEGMENT * (2^k - 1), FIRST_SEGMENT * (2^(k+1) - 1))
+    static constexpr unsigned FIRST_SEGMENT_BITS = 10;
+    static constexpr std::size_t FIRST_SEGMENT = std::size_t(1) << FIRST_SEGMENT_BITS;
+    static constexpr std::size_t SEGMENTS = 33 - FIRST_SEGMENT_BITS;
+
+    mutable std::shared_mutex lock;
+    std::vector<Slot> slots;   // size is a power of two, at most half full
+    StringArena text;          // the interned strings
+    std::atomic<std::string_view*> segments[SEGMENTS];
+    std::atomic<std::uint32_t> count;
+
+    static std::uint32_t hashOf(std::string_view text);
+    static std::size_t segmentOf(std::uint32_t id, std::size_t& offset);
+    std::string_view& entry(std::uint32_t id) const;
+    void setEntry(std::uint32_t id, std::string_view name); // allocates the segment on first use
+    std::size_t probe(std::string_view text, std::uint32_t hash) const; // slot holding text, or the empty slot for it
+    void rehash(std::size_t capacity);
+    std::uint32_t insert(std::string_view text, std::uint32_t hash); // caller holds lock exclusively
+
+public:
+    static constexpr std::size_t BATCH = 64;
+
+    SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    ~SymbolTable();
+
+    std::uint32_t intern(std::string_view text); // id of text, adding it if new
+    void internMany(const std::string_view* texts, std::size_t n, std::uint32_t* ids); // n <= BATCH
+    std::uint32_t find(std::string_view text) const; // NONE if never interned
+    std::string_view name(std::uint32_t id) const;   // valid for the life of the table
+
+    std::size_t size() const;
+    void reserve(std::size_t n);
+
+    // Snapshot section (see Snapshot.h). load() only fills an empty table and
+    // leaves it empty if the section is damaged; the probe table is only
+    // usable with the same hash function, see hashCheck().
+    void save(SnapshotWriter& out) const;
+    bool load(SnapshotReader& in);
+    static std::uint32_t hashCheck(); // the hash of a fixed string, stored in the snapshot header
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "ThreadPool.h"
+
+/*
+ * ThreadPool.cpp
+ * Implements the ThreadPool class declared in ThreadPool.h.
+ */
+
+// Constructor / destructor
+ThreadPool::ThreadPool()
+    : workers(), task(nullptr), taskCount(0), nextIndex(0), finished(0), generation(0), stopping(false) {}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> held(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& w : workers)
+        w.join();
+}
+
+// Takes indexes of the current loop until none are left. Called with lock held,
+// which is released around each task call.
+void ThreadPool::drain(std::unique_lock<std::mutex>& held) {
+    while (nextIndex < taskCount) {
+        std::size_t i = nextIndex++;
+        held.unlock();
+        (*task)(i);
+        held.lock();
+        if (++finished == taskCount)
+            done.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::uint64_t seen = 0;
+    std::unique_lock<std::mutex> held(lock);
+    for (;;) {
+        wake.wait(held, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        seen = generation;
+        drain(held);
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t n, const std::function<void(std::size_t)>& fn) {
+    if (n == 0)
+        return;
+
+    std::lock_guard<std::mutex> running(runLock);
+    std::unique_lock<std::mutex> held(lock);
+
+    // The caller takes part, so n - 1 workers are enough
+    while (workers.size() + 1 < n)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+
+    task = &fn;
+    taskCount = n;
+    nextIndex = 0;
+    finished = 0;
+    generation++;
+    wake.notify_all();
+
+    drain(held);
+    done.wait(held, [&] { return finished == taskCount; });
+    task = nullptr;
+    taskCount = 0;
+}
+
+std::size_t ThreadPool::size() const {
+    std::lock_guard<std::mutex> held(lock);
+    return workers.size();
+}
@@ -0,0 +1,57 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * ThreadPool.h
+ * Declares the ThreadPool class, a set of worker threads kept for parallel
+ * loops such as parsing the chunks of records.csv.
+ *
+ * Workers are started on first use, only as many as a loop asks for, and
+ * then wait for the next loop instead of exiting, so repeated loads don't
+ * pay for thread creation again. The calling thread works on the loop too.
+ * One loop runs at a time; a second caller waits for the first to finish.
+ * The destructor stops and joins every worker.
+ */
+
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex runLock;  // one parallelFor at a time
+    mutable std::mutex lock; // guards everything below
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(std::size_t)>* task;
+    std::size_t taskCount;
+    std::size_t nextIndex;
+    std::size_t finished;
+    std::uint64_t generation; // bumped for each loop, so workers can tell a new one
+    bool stopping;
+
+    void workerLoop();
+    void drain(std::unique_lock<std::mutex>& held);
+
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Calls task(i) for every i in [0, n) on up to n threads, the caller
+    // included, and returns once every call has returned
+    void parallelFor(std::size_t n, const std::function<void(std::size_t)>& task);
+
+    std::size_t size() const; // workers started so far
+};
+
+#endif
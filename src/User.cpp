@@ -9,24 +9,25 @@
  * Provides:
  *  - Constructors for each type of user
  *  - Fee modication with error handling
- *  - Polymorphic CSV serialization
+ *  - Polymorphic CSV serialization (field lists for CsvCodec)
  *  - Polymorphic display functionality
- *  - A factory-style static deserializeCSV() that returns the correct user type.
+ *  - Factory-style static parseCSV()/deserializeCSV() that return the correct user type.
+ *  - Moving a heap-allocated user into a UserVariant
  */
 
 // Constructors
 User::User()
-    : id(""), name(""), type(UserType::OTHER), feesDue(0.0) {}
+    : id(""), name(), type(UserType::OTHER), feesDue(0.0) {}
 
-User::User(std::string id, std::string name, UserType t)
-    : id(id), name(name), type(t), feesDue(0.0) {}
+User::User(std::string id, std::string_view name, UserType t, StringArena* arena)
+    : id(std::move(id)), name(name, arena), type(t), feesDue(0.0) {}
 
 // getters
 const std::string& User::getID() const {
     return id;
 }
-const std::string& User::getName() const {
-    return name;
+std::string_view User::getName() const {
+    return name.view();
 }
 UserType User::getUserType() const {
     return type;
@@ -68,87 +69,101 @@ void User::display(std::ostream& os) const {
     os << "\nFees Due: $" << std::fixed << std::setprecision(2) << feesDue << std::endl;
 }
 
-// CSV serialization for base user (student and teacher override this)
-std::string User::serializeCSV() const {
-    std::ostringstream ss;
-    ss << "USER," << id << "," << name << ",";
-
-    switch (type) {
-        case UserType::STUDENT: ss << "STUDENT";
-            break;
-        case UserType::TEACHER: ss << "TEACHER";
-            break;
-        default: ss << "OTHER"; break;
-    }
-
-    ss << "," << feesDue;
-    return ss.str();
+// CSV fields after the tag, in file order
+// USER,id,name,type,fees
+constexpr auto User::csvFields() {
+    return std::make_tuple(
+        csvField("id", &User::id),
+        csvField("name", &User::name),
+        CsvCustomField<User>{ "type",
+            [](std::string_view text, User& u) {
+                if (text == "STUDENT") u.type = UserType::STUDENT;
+                else if (text == "TEACHER") u.type = UserType::TEACHER;
+                else if (text == "OTHER") u.type = UserType::OTHER;
+                else return CsvError::BAD_VALUE;
+                return CsvError::NONE;
+            },
+            [](const User& u, CsvWriter& out) {
+                switch (u.type) {
+                    case UserType::STUDENT: out.text("STUDENT");
+                        break;
+                    case UserType::TEACHER: out.text("TEACHER");
+                        break;
+                    default: out.text("OTHER");
+                        break;
+                }
+            } },
+        csvField("feesDue", &User::feesDue));
 }
 
-// Derialization
-// creates Student, Teacher, or User depending on CSV tag
-std::unique_ptr<User> User::deserializeCSV(const std::string& line) {
-    std::stringstream ss(line);
-
-    std::string tag;
-    std::getline(ss, tag, ',');
-
-    // Construct a student
-    if (tag == "STUDENT") {
-        std::string id, name, major;
-        double fees;
-
-        std::getline(ss, id, ',');
-        std::getline(ss, name, ',');
-        std::getline(ss, major, ',');
-        ss >> fees;
+// Helper: write the tag and then the fields of T
+template <typename T>
+static std::size_t writeTagged(const T& user, const char* tag, char* first, char* last) {
+    CsvWriter out(first, last);
+    out.text(tag);
+    CsvCodec<T>::formatFields(user, out, true);
+    return out.overflowed() ? 0 : static_cast<std::size_t>(out.position() - first);
+}
 
-        auto s = std::make_unique<Student>(id, name, major);
-        s->addFees(fees);
-        return s;
-    }
+// Helper: parse the fields after the tag into user
+template <typename T>
+static CsvStatus parseFields(CsvCursor& cursor, T& user, StringArena* arena) {
+    CsvStatus status = CsvCodec<T>::parseFields(cursor, user);
+    user.keepText(arena);
+    if (status.ok() && !cursor.atEnd())
+        status = CsvStatus{ CsvError::EXTRA_FIELDS, cursor.fieldIndex(), "" };
+    return status;
+}
 
-    // Construct a Teacher
-    if (tag == "TEACHER") {
-        std::string id, name, department;
-        double fees;
+// Helper: parse the fields after the tag into a new T, on the heap or in a variant
+template <typename T>
+static CsvStatus parseTagged(CsvCursor& cursor, std::unique_ptr<User>& out, StringArena* arena) {
+    auto user = std::make_unique<T>();
+    CsvStatus status = parseFields(cursor, *user, arena);
+    if (status.ok())
+        out = std::move(user);
+    return status;
+}
 
-        std::getline(ss, id, ',');
-        std::getline(ss, name, ',');
-        std::getline(ss, department, ',');
-        ss >> fees;
+template <typename T>
+static CsvStatus parseTagged(CsvCursor& cursor, UserVariant& out, StringArena* arena) {
+    T user;
+    CsvStatus status = parseFields(cursor, user, arena);
+    if (status.ok())
+        out.emplace<T>(std::move(user));
+    return status;
+}
 
-        auto t = std::make_unique<Teacher>(id, name, department);
-        t->addFees(fees);
-        return t;
-    }
+// CSV serialization, the row format comes from the dynamic type
+std::string User::serializeCSV() const {
+    return csvToString([this](char* first, char* last) { return writeCSV(first, last); });
+}
 
-    // Construct a base user
-    if (tag == "USER") {
-        std::string id, name, typeStr;
-        double fees;
+// Parsed text still points into the line until this runs
+void User::keepText(StringArena* arena) {
+    name.keepIn(arena);
+}
 
-        std::getline(ss, id, ',');
-        std::getline(ss, name, ',');
-        std::getline(ss, typeStr, ',');
-        ss >> fees;
+// base user (student and teacher override this)
+std::size_t User::writeCSV(char* first, char* last) const {
+    return writeTagged(*this, "USER", first, last);
+}
 
-        UserType t;
-        if (typeStr == "STUDENT") t = UserType::STUDENT;
-        else if (typeStr == "TEACHER") t = UserType::TEACHER;
-        else t = UserType::OTHER;
+// Student Class Implementation
+Student::Student()
+    : User("", "", UserType::STUDENT), major() {}
 
-        auto u = std::make_unique<User>(id, name, t);
-        u->addFees(fees);
-        return u;
-    }
+Student::Student(std::string id, std::string_view name, std::string_view major, StringArena* arena)
+    : User(std::move(id), name, UserType::STUDENT, arena), major(major, arena) {}
 
-    throw std::runtime_error("Invalid CSV line for User: " + line);
+std::string_view Student::getMajor() const {
+    return major.view();
 }
 
-// Student Class Implementation
-Student::Student(std::string id, std::string name, std::string major)
-    : User(id, name, UserType::STUDENT), major(major) {}
+void Student::keepText(StringArena* arena) {
+    User::keepText(arena);
+    major.keepIn(arena);
+}
 
 // displays base info then adds major
 void Student::display(std::ostream& os) const {
@@ -157,16 +172,34 @@ void Student::display(std::ostream& os) const {
     os << "--------------------------------------------------" << std::endl;
 }
 
-std::string Student::serializeCSV() const {
-    std::ostringstream ss;
-    ss << "STUDENT," << id << "," << name << ","
-        << major << "," << feesDue;
-    return ss.str();
+// STUDENT,id,name,major,fees
+constexpr auto Student::csvFields() {
+    return std::make_tuple(
+        csvField("id", &Student::id),
+        csvField("name", &Student::name),
+        csvField("major", &Student::major),
+        csvField("feesDue", &Student::feesDue));
+}
+
+std::size_t Student::writeCSV(char* first, char* last) const {
+    return writeTagged(*this, "STUDENT", first, last);
 }
 
 // Teacher Class Implementation
-Teacher::Teacher(std::string id, std::string name, std::string department)
-    : User(id, name, UserType::TEACHER), department(department) {}
+Teacher::Teacher()
+    : User("", "", UserType::TEACHER), department() {}
+
+Teacher::Teacher(std::string id, std::string_view name, std::string_view department, StringArena* arena)
+    : User(std::move(id), name, UserType::TEACHER, arena), department(department, arena) {}
+
+std::string_view Teacher::getDepartment() const {
+    return department.view();
+}
+
+void Teacher::keepText(StringArena* arena) {
+    User::keepText(arena);
+    department.keepIn(arena);
+}
 
 void Teacher::display(std::ostream& os) const {
     User::display(os);
@@ -174,9 +207,57 @@ void Teacher::display(std::ostream& os) const {
     os << "--------------------------------------------------" << std::endl;
 }
 
-std::string Teacher::serializeCSV() const {
-    std::ostringstream ss;
-    ss << "TEACHER," << id << "," << name << ","
-        << department << "," << feesDue;
-    return ss.str();
+// TEACHER,id,name,department,fees
+constexpr auto Teacher::csvFields() {
+    return std::make_tuple(
+        csvField("id", &Teacher::id),
+        csvField("name", &Teacher::name),
+        csvField("department", &Teacher::department),
+        csvField("feesDue", &Teacher::feesDue));
+}
+
+std::size_t Teacher::writeCSV(char* first, char* last) const {
+    return writeTagged(*this, "TEACHER", first, last);
+}
+
+// Deserialization (kept at the end, after every csvFields() definition)
+// creates Student, Teacher, or User depending on CSV tag
+template <typename Out>
+static CsvStatus parseAnyUser(std::string_view line, Out& out, StringArena* arena) {
+    CsvCursor cursor(line);
+    std::string_view tag;
+    cursor.next(tag);
+
+    if (tag == "STUDENT")
+        return parseTagged<Student>(cursor, out, arena);
+    if (tag == "TEACHER")
+        return parseTagged<Teacher>(cursor, out, arena);
+    if (tag == "USER")
+        return parseTagged<User>(cursor, out, arena);
+
+    return CsvStatus{ CsvError::BAD_VALUE, 0, "tag" };
+}
+
+CsvStatus User::parseCSV(std::string_view line, std::unique_ptr<User>& out, StringArena* arena) {
+    return parseAnyUser(line, out, arena);
+}
+
+CsvStatus User::parseCSV(std::string_view line, UserVariant& out, StringArena* arena) {
+    return parseAnyUser(line, out, arena);
+}
+
+UserVariant User::toVariant(std::unique_ptr<User> user) {
+    if (Student* s = dynamic_cast<Student*>(user.get()))
+        return UserVariant(std::in_place_type<Student>, std::move(*s));
+    if (Teacher* t = dynamic_cast<Teacher*>(user.get()))
+        return UserVariant(std::in_place_type<Teacher>, std::move(*t));
+    return UserVariant(std::in_place_type<User>, std::move(*user));
+}
+
+std::unique_ptr<User> User::deserializeCSV(std::string_view line) {
+    std::unique_ptr<User> user;
+    CsvStatus status = parseCSV(line, user);
+    if (!status.ok())
+        throw std::runtime_error("Invalid CSV line for User (" + status.describe() + "): " + std::string(line));
+    return user;
 }
\ No newline at end of file
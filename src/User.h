@@ -2,8 +2,12 @@
 #define USER_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <memory>
+#include <variant>
+#include <type_traits>
+#include "CsvCodec.h"
 
 /*
  * User.h
@@ -11,44 +15,68 @@
  *
  * Base Class: User
  *  - Stores ID, name, user type, (Student/Teacher/Other), and outstanding fees.
- *  - Defines polymorphic behavior through virtual display() and serializeCSV().
+ *  - Defines polymorphic behavior through virtual display() and writeCSV().
  *  - Supports safe fee updates and CSV-based loading.
  *
  * Derived Classes:
  *  - Student: Adds major field.
  *  - Teacher: Adds department field.
  *
+ * Name, major and department are ArenaStrings (see StringArena.h): a bulk load
+ * puts their text in the Library's arena, users built any other way own it.
+ *
  * The User hierarchy demonstrates:
  *  - Inheritance
  *  - Polymorphism
  *  - Encapusulation
- *  - Dynamic allocation vid std::unique_ptr for library storage
+ *  - Dynamic allocation vid std::unique_ptr for single users passed around
+ *
+ * The Library stores users by value as UserVariant (std::variant of the three
+ * classes), in one contiguous array. userOf, displayUser and writeUserCSV at
+ * the end of this file dispatch on the variant's stored type at compile time,
+ * so whole-table passes make no virtual calls and follow no pointers.
  */
 
 // Enumerates the types of users in the system
 enum class UserType { STUDENT, TEACHER, OTHER};
 
+class User;
+class Student;
+class Teacher;
+
+// One user of any type, held by value
+using UserVariant = std::variant<User, Student, Teacher>;
+
 class User {
 protected:
     std::string id;
-    std::string name;
+    ArenaString name;
     UserType type;
     double feesDue;
 
+    // CSV field list used by CsvCodec<User>, after the USER tag
+    template <typename> friend class CsvCodec;
+    static constexpr auto csvFields();
+
 public:
     // Constructors
     User();
-    User(std::string id, std::string name, UserType t);
+    User(std::string id, std::string_view name, UserType t, StringArena* arena = nullptr); // text in arena when given
 
-    // Virtual destructor
+    // Virtual destructor. Copies and moves are declared too, so moving a user
+    // into a UserVariant keeps its arena text instead of copying it.
     virtual ~User() = default;
+    User(const User&) = default;
+    User(User&&) = default;
+    User& operator=(const User&) = default;
+    User& operator=(User&&) = default;
 
     // Display
     virtual void display(std::ostream& os) const;
 
     // Getters
     const std::string& getID() const;
-    const std::string& getName() const;
+    std::string_view getName() const;
     UserType getUserType() const;
     double getFeesDue() const;
 
@@ -57,32 +85,79 @@ public:
     void payFees(double amt);
 
     // Serialization
-    virtual std::string serializeCSV() const;
+    std::string serializeCSV() const;
+    virtual std::size_t writeCSV(char* first, char* last) const; // row length, 0 if the buffer is too small
+
+    // Factory functions, pick the type from the row's tag
+    static std::unique_ptr<User> deserializeCSV(std::string_view line); // throws on a bad row
+    static CsvStatus parseCSV(std::string_view line, std::unique_ptr<User>& out, StringArena* arena = nullptr);
+    static CsvStatus parseCSV(std::string_view line, UserVariant& out, StringArena* arena = nullptr); // out is only set when ok
 
-    // Factory function
-    static std::unique_ptr<User> deserializeCSV(const std::string& line);
+    // Moves a user into a UserVariant of its dynamic type
+    static UserVariant toVariant(std::unique_ptr<User> user);
+
+    // After parsing, see ArenaString::keepIn
+    virtual void keepText(StringArena* arena);
 };
 
 class Student : public User {
 private:
-    std::string major;
+    ArenaString major;
+
+    template <typename> friend class CsvCodec;
+    static constexpr auto csvFields();
 
 public:
-    Student(std::string id, std::string name, std::string major);
+    Student();
+    Student(std::string id, std::string_view name, std::string_view major, StringArena* arena = nullptr);
+
+    std::string_view getMajor() const;
 
     void display(std::ostream& os) const override;
-    std::string serializeCSV() const override;
+    void keepText(StringArena* arena) override;
+    std::size_t writeCSV(char* first, char* last) const override;
 };
 
 class Teacher : public User {
 private:
-    std::string department;
+    ArenaString department;
+
+    template <typename> friend class CsvCodec;
+    static constexpr auto csvFields();
 
 public:
-    Teacher(std::string id, std::string name, std::string department);
+    Teacher();
+    Teacher(std::string id, std::string_view name, std::string_view department, StringArena* arena = nullptr);
+
+    std::string_view getDepartment() const;
 
     void display(std::ostream& os) const override;
-    std::string serializeCSV() const override;
+    void keepText(StringArena* arena) override;
+    std::size_t writeCSV(char* first, char* last) const override;
 };
 
+// Static dispatch over UserVariant: std::visit switches on the stored type and
+// the qualified calls name that type's function, so no vtable is involved
+inline const User& userOf(const UserVariant& u) {
+    return std::visit([](const User& user) -> const User& { return user; }, u);
+}
+
+inline User& userOf(UserVariant& u) {
+    return std::visit([](User& user) -> User& { return user; }, u);
+}
+
+inline void displayUser(const UserVariant& u, std::ostream& os) {
+    std::visit([&os](const auto& user) {
+        using T = std::decay_t<decltype(user)>;
+        user.T::display(os);
+    }, u);
+}
+
+inline std::size_t writeUserCSV(const UserVariant& u, char* first, char* last) {
+    return std::visit([first, last](const auto& user) {
+        using T = std::decay_t<decltype(user)>;
+        return user.T::writeCSV(first, last);
+    }, u);
+}
+
 #endif
\ No newline at end of file
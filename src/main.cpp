@@ -7,11 +7,18 @@ Due Date  :  11/22/2025
 
 #include <iostream>
 #include <memory>
+#include <vector>
 #include <limits>
+#include <filesystem>
+#include <iomanip>
+#include <algorithm>
+#include <optional>
 #include "Library.h"
 #include "Book.h"
 #include "User.h"
 #include "BorrowRecord.h"
+#include "Journal.h"
+#include "BatchProcessor.h"
 
 using namespace std;
 
@@ -21,6 +28,80 @@ void clearInput() {
     cin.ignore(numeric_limits<streamsize>::max(), '\n');
 }
 
+// Data files
+const string BOOKS_FILE = "books.csv";
+const string USERS_FILE = "users.csv";
+const string RECORDS_FILE = "records.csv";
+const string SNAPSHOT_FILE = "library.snap";
+const string JOURNAL_FILE = "library.wal";
+
+// Journal entries per fdatasync in batch mode, the interactive menu syncs after every command
+const size_t BATCH_GROUP_SIZE = 1024;
+
+// True if the snapshot and every CSV file exist and no CSV file is newer
+// than the snapshot, so hand edits to the CSV files are always picked up
+bool snapshotIsCurrent() {
+    std::error_code ec;
+    auto snapTime = std::filesystem::last_write_time(SNAPSHOT_FILE, ec);
+    if (ec)
+        return false;
+
+    for (const string& csv : { BOOKS_FILE, USERS_FILE, RECORDS_FILE }) {
+        auto csvTime = std::filesystem::last_write_time(csv, ec);
+        if (ec || csvTime > snapTime)
+            return false;
+    }
+    return true;
+}
+
+// Checkpoint: save what changed, then the journal is emptied.
+// The journal is kept if any file failed to save.
+void saveAll(Library& lib, Journal& journal) {
+    bool changed = lib.hasUnsavedChanges();
+
+    bool ok = lib.saveBooks(BOOKS_FILE);
+    ok = lib.saveUsers(USERS_FILE) && ok;
+    ok = lib.saveRecords(RECORDS_FILE) && ok;
+    if (!ok) {
+        cerr << "Saving failed, changes are kept in " << JOURNAL_FILE << std::endl;
+        return;
+    }
+
+    // Written last so it is newer than the CSV files. It is only a faster
+    // copy of them, so failing to write it loses nothing.
+    if (changed || !snapshotIsCurrent())
+        lib.saveSnapshot(SNAPSHOT_FILE);
+    journal.clear();
+}
+
+// Batch mode: run a transaction file, one result line per transaction, then checkpoint.
+// Exit code is 0 if every transaction succeeded, 2 if some failed, 1 if the file couldn't be read.
+int runBatch(Library& lib, Journal& journal, const string& filename) {
+    BatchProcessor batch(lib, cout);
+    if (!batch.run(filename)) {
+        cerr << "Could not open " << filename << std::endl;
+        return 1;
+    }
+    cout.flush();
+    journal.commit();
+
+    cerr << batch.getSucceeded() << " transaction(s) applied, " << batch.getFailed() << " failed" << std::endl;
+    saveAll(lib, journal);
+    return batch.getFailed() > 0 ? 2 : 0;
+}
+
+// One line per loan for the overdue report
+void printLoanLine(const Library& lib, const BorrowRecord& r, DayNumber today) {
+    int y, m, d;
+    r.getDueDate(y, m, d);
+    const RecordSymbols& symbols = lib.getRecordSymbols();
+    cout << BorrowRecord::formatRecordID(r.getRecordID()) << "  " << r.getUserID(symbols) << "  " << r.getISBN(symbols)
+         << "  due " << y << "-" << setfill('0') << setw(2) << m << "-" << setw(2) << d << setfill(' ');
+    if (r.getDueDay() < today)
+        cout << "  (" << today - r.getDueDay() << " day(s) overdue)";
+    cout << '\n';
+}
+
 void displayMenu() {
     cout << "Library System Menu" << std::endl;
     cout << "1. Add Book" << std::endl;
@@ -36,16 +117,51 @@ void displayMenu() {
     cout << "11. Display All Records" << std::endl;
     cout << "12. Show Report" << std::endl;
     cout << "13. Save and Exit" << std::endl;
+    cout << "14. Keyword Search" << std::endl;
+    cout << "15. Title/Author Autocomplete" << std::endl;
+    cout << "16. Save (Checkpoint)" << std::endl;
+    cout << "17. Overdue Report" << std::endl;
+    cout << "18. Projected Late Fees" << std::endl;
+    cout << "19. Circulation Report" << std::endl;
     cout << "Enter choice: ";
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    string batchFile;
+    if (argc == 3 && string(argv[1]) == "--batch") {
+        batchFile = argv[2];
+        // Results are buffered instead of going through stdio line by line
+        ios::sync_with_stdio(false);
+    }
+    else if (argc != 1) {
+        cerr << "Usage: " << argv[0] << " [--batch <transaction file>]" << std::endl;
+        return 1;
+    }
+
     Library lib;
 
-    // Load files
-    lib.loadBooks("books.csv");
-    lib.loadUsers("users.csv");
-    lib.loadRecords("records.csv");
+    // Load files, the snapshot is used unless a CSV file was changed after it
+    if (snapshotIsCurrent() && lib.loadSnapshot(SNAPSHOT_FILE)) {
+        // The snapshot is only written after all CSV files saved successfully
+        lib.markSavedTo(BOOKS_FILE, USERS_FILE, RECORDS_FILE);
+    }
+    else {
+        lib.loadBooks(BOOKS_FILE);
+        lib.loadUsers(USERS_FILE);
+        lib.loadRecords(RECORDS_FILE);
+    }
+
+    // Changes made after the last save are recovered from the journal
+    lib.replayJournal(JOURNAL_FILE);
+
+    Journal journal;
+    if (journal.open(JOURNAL_FILE, batchFile.empty() ? 64 : BATCH_GROUP_SIZE))
+        lib.attachJournal(&journal);
+    else
+        cerr << "Could not open " << JOURNAL_FILE << ", changes are only saved on exit" << std::endl;
+
+    if (!batchFile.empty())
+        return runBatch(lib, journal, batchFile);
 
     cout << "Library System Initialized" << std::endl;
 
@@ -55,6 +171,10 @@ int main() {
         displayMenu();
         cin >> choice;
 
+        // End of input, everything so far is already in the journal
+        if (cin.eof())
+            break;
+
         if (cin.fail()) {
             clearInput();
             cout << "invalid input. Try again" << std::endl;
@@ -64,9 +184,7 @@ int main() {
         // EXIT
         if (choice == 13) {
             cout << "Saving data..." << std::endl;
-            lib.saveBooks("books.csv");
-            lib.saveUsers("users.csv");
-            lib.saveRecords("records.csv");
+            saveAll(lib, journal);
             break;
         }
         switch(choice) {
@@ -115,7 +233,7 @@ int main() {
                 cout << "Enter ISBN to search: ";
                 getline(cin, isbn);
 
-                Book* b = lib.searchBook(isbn);
+                optional<Book> b = lib.searchBook(isbn);
                 if(b)
                     b->display(cout);
                 else
@@ -170,7 +288,10 @@ int main() {
                 cout << "Enter user ID to remove: ";
                 getline(cin, id);
 
-                if (lib.removeUser(id))
+                if (lib.hasOpenLoans(id))
+                    cout << "User still has " << lib.getOpenLoans(id).size()
+                         << " book(s) on loan and cannot be removed." << std::endl;
+                else if (lib.removeUser(id))
                     cout << "User removed." << std::endl;
                 else
                     cout << "User not found." << std::endl;
@@ -183,9 +304,16 @@ int main() {
                 cout << "Enter user ID: ";
                 getline(cin, id);
 
-                User* u = lib.searchUser(id);
-                if (u)
-                    u->display(cout);
+                optional<UserVariant> u = lib.searchUser(id);
+                if (u) {
+                    displayUser(*u, cout);
+
+                    // List what the user currently has out
+                    vector<BorrowRecord> loans = lib.getOpenLoans(id);
+                    cout << "Books on loan: " << loans.size() << std::endl;
+                    for (const BorrowRecord& r : loans)
+                        r.display(lib.getRecordSymbols(), cout);
+                }
                 else
                     cout << "User not found." << std::endl;
                 break;
@@ -256,11 +384,172 @@ int main() {
                 cout << "Total Books: " << lib.getTotalBooks() << std::endl;
                 cout << "Total Users: " << lib.getTotalUsers() << std::endl;
                 cout << "Borrowed Books: " << lib.getBorrowedCount() << std::endl;
+
+                const LibraryStats& stats = lib.getStats();
+                cout << "Copies Out: " << stats.copiesOut << std::endl;
+                cout << "Users With Fees: " << stats.usersWithFees << std::endl;
+                // Money in fixed notation for this line only
+                ios::fmtflags oldFlags = cout.flags();
+                streamsize oldPrecision = cout.precision();
+                cout << "Total Fees Due: $" << fixed << setprecision(2) << stats.totalFeesDue << std::endl;
+                cout.flags(oldFlags);
+                cout.precision(oldPrecision);
+                break;
+            }
+            // Keyword search over titles and authors
+            case 14: {
+                clearInput();
+                string query;
+                cout << "Enter keywords: ";
+                getline(cin, query);
+
+                vector<Book> found = lib.searchBooksByKeywords(query);
+                if (found.empty()) {
+                    cout << "No matching books." << std::endl;
+                    break;
+                }
+                cout << found.size() << " matching book(s):" << std::endl;
+                for (const Book& b : found)
+                    b.display(cout);
+                break;
+            }
+            // Prefix type-ahead on titles and authors
+            case 15: {
+                clearInput();
+                string prefix;
+                cout << "Enter title or author prefix: ";
+                getline(cin, prefix);
+
+                vector<Book> found = lib.autocompleteBooks(prefix, 10);
+                if (found.empty()) {
+                    cout << "No matching books." << std::endl;
+                    break;
+                }
+                for (const Book& b : found)
+                    cout << b.getISBN() << "  " << b.getTitle() << " - " << b.getAuthor() << std::endl;
+                break;
+            }
+            // Save without exiting
+            case 16:
+                cout << "Saving data..." << std::endl;
+                saveAll(lib, journal);
+                break;
+
+            // Overdue and due-soon loans as of a date
+            case 17: {
+                int y, m, d, days;
+                cout << "Enter today's date (Y M D): ";
+                cin >> y >> m >> d;
+                if (!cin || !isValidDate(y, m, d)) {
+                    clearInput();
+                    cout << "Invalid date." << std::endl;
+                    break;
+                }
+                cout << "Also list loans due within how many days (0 for none): ";
+                cin >> days;
+                if (!cin) {
+                    clearInput();
+                    days = 0;
+                }
+
+                DayNumber today = daysFromCivil(y, m, d);
+                vector<BorrowRecord> overdue = lib.getOverdueLoans(today);
+                cout << "Overdue loans: " << overdue.size() << '\n';
+                for (const BorrowRecord& r : overdue)
+                    printLoanLine(lib, r, today);
+
+                if (days > 0) {
+                    vector<BorrowRecord> dueSoon = lib.getLoansDueWithin(today, days);
+                    cout << "Due within " << days << " day(s): " << dueSoon.size() << '\n';
+                    for (const BorrowRecord& r : dueSoon)
+                        printLoanLine(lib, r, today);
+                }
+                cout << std::flush;
                 break;
             }
+
+            // Late fees every user would owe if their open loans came back on a date
+            case 18: {
+                int y, m, d;
+                double feePerDay;
+                cout << "Enter date (Y M D): ";
+                cin >> y >> m >> d;
+                if (!cin || !isValidDate(y, m, d)) {
+                    clearInput();
+                    cout << "Invalid date." << std::endl;
+                    break;
+                }
+                cout << "Enter late fee per day: ";
+                cin >> feePerDay;
+                if (!cin || feePerDay < 0) {
+                    clearInput();
+                    cout << "Invalid fee." << std::endl;
+                    break;
+                }
+
+                vector<pair<string, double>> fees = lib.projectLateFees(daysFromCivil(y, m, d), feePerDay);
+                double total = 0;
+                for (const auto& f : fees)
+                    total += f.second;
+                ios::fmtflags oldFlags = cout.flags();
+                streamsize oldPrecision = cout.precision();
+                cout << "Users owing late fees: " << fees.size() << '\n';
+                cout << "Total projected fees: $" << fixed << setprecision(2) << total << '\n';
+
+                // Show the ten largest
+                size_t shown = min<size_t>(10, fees.size());
+                partial_sort(fees.begin(), fees.begin() + shown, fees.end(),
+                             [](const auto& a, const auto& b) { return a.second > b.second; });
+                for (size_t i = 0; i < shown; ++i) {
+                    optional<UserVariant> u = lib.searchUser(fees[i].first);
+                    cout << "  " << fees[i].first << "  " << (u ? userOf(*u).getName() : string_view())
+                         << "  $" << fees[i].second << '\n';
+                }
+                cout.flags(oldFlags);
+                cout.precision(oldPrecision);
+                cout << std::flush;
+                break;
+            }
+
+            // Loan counts and day totals grouped over the whole borrow history
+            case 19: {
+                int group, measure;
+                cout << "Group by (1 = month borrowed, 2 = user type, 3 = ISBN, 4 = user): ";
+                cin >> group;
+                cout << "Measure (1 = loans, 2 = days out, 3 = days late): ";
+                cin >> measure;
+                if (!cin || group < 1 || group > 4 || measure < 1 || measure > 3) {
+                    clearInput();
+                    cout << "Invalid choice." << std::endl;
+                    break;
+                }
+
+                const LoanGroupBy groupings[] = { LoanGroupBy::BORROW_MONTH, LoanGroupBy::USER_TYPE,
+                                                  LoanGroupBy::ISBN, LoanGroupBy::USER };
+                const LoanMeasure measures[] = { LoanMeasure::LOANS, LoanMeasure::DAYS_OUT, LoanMeasure::DAYS_LATE };
+                vector<LoanGroup> report = lib.loanReport(groupings[group - 1], measures[measure - 1]);
+
+                ios::fmtflags oldFlags = cout.flags();
+                streamsize oldPrecision = cout.precision();
+                cout << "Groups: " << report.size() << '\n';
+                for (const LoanGroup& g : report) {
+                    cout << "  " << g.key << "  loans: " << g.count;
+                    if (measure != 1)
+                        cout << "  total days: " << g.sum << "  average: " << fixed << setprecision(2) << g.average;
+                    cout << '\n';
+                }
+                cout.flags(oldFlags);
+                cout.precision(oldPrecision);
+                cout << std::flush;
+                break;
+            }
+
             default:
             cout << "Invalid choice." << std::endl;
         }
+
+        // Make this command's changes durable before showing the menu again
+        journal.commit();
     }
     return 0;
 }
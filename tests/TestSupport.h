@@ -0,0 +1,86 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * TestSupport.h
+ * The little the tests share: a CHECK macro that records failures and keeps
+ * going, a scratch directory that is removed afterwards, and whole-file
+ * read/write helpers. Each tests/test_*.cpp is its own program; main returns
+ * testResult() so `make test` stops at the first failing file.
+ */
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n";  \
+            testFailures()++;                                                           \
+        }                                                                               \
+    } while (0)
+
+inline int testResult(const char* name) {
+    if (testFailures() == 0) {
+        std::cout << name << ": all checks passed\n";
+        return 0;
+    }
+    std::cout << name << ": " << testFailures() << " check(s) failed\n";
+    return 1;
+}
+
+// A fresh directory under the system temp directory, removed with everything in it
+class TempDir {
+    std::filesystem::path dir;
+
+public:
+    TempDir() {
+        std::string pattern = (std::filesystem::temp_directory_path() / "library-test-XXXXXX").string();
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        if (!mkdtemp(name.data())) {
+            std::cerr << "cannot create a temp directory\n";
+            std::exit(1);
+        }
+        dir = name.data();
+    }
+    ~TempDir() {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    std::string file(const std::string& name) const { return (dir / name).string(); }
+};
+
+inline void writeFile(const std::string& filename, const std::string& text) {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out << text;
+}
+
+inline std::string readFile(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+inline std::vector<std::string> readLines(const std::string& filename) {
+    std::vector<std::string> lines;
+    std::istringstream in(readFile(filename));
+    for (std::string line; std::getline(in, line);)
+        lines.push_back(line);
+    return lines;
+}
+
+#endif
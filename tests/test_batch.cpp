@@ -0,0 +1,97 @@
+#include "TestSupport.h"
+#include "BatchProcessor.h"
+#include "Library.h"
+
+/*
+ * test_batch.cpp
+ * A transaction file mixing every kind of line: runs of the same kind applied
+ * in bulk, each refusal reported with the ChangeStatus behind it, and lines
+ * that don't parse (wrong field counts included) rejected without changing
+ * anything.
+ */
+
+static void testMixedStream() {
+    TempDir dir;
+    const std::string file = dir.file("batch.txt");
+    writeFile(file,
+        "ADD_BOOK,111,Title One,Author A,2001,2,2\n"          // 1
+        "ADD_BOOK,222,Title Two,Author B,2002,1,1\n"          // 2
+        "ADD_BOOK,111,Again,Author A,2001,5,5\n"              // 3 duplicate
+        "ADD_USER,STUDENT,U1,Name One,Math,0\n"               // 4
+        "# comment\n"                                         // 5
+        "\n"                                                  // 6
+        "BORROW,U1,111,2024-01-02,2024-01-16\n"               // 7
+        "BORROW,U1,222,2024-01-02,2024-01-16\n"               // 8
+        "BORROW,U9,111,2024-01-02,2024-01-16\n"               // 9 unknown user
+        "BORROW,U1,333,2024-01-02,2024-01-16\n"               // 10 unknown book
+        "BORROW,U1,222,2024-01-03,2024-01-17\n"               // 11 no copies
+        "RETURN,REC1,2024-01-20,0.5\n"                        // 12 4 days late
+        "RETURN,REC1,2024-01-21,0.5\n"                        // 13 already returned
+        "RETURN,REC99,2024-01-21,0.5\n"                       // 14 unknown record
+        "REMOVE_BOOK,111,junk\n"                              // 15 extra field
+        "REMOVE_BOOK,111\n"                                   // 16
+        "REMOVE_BOOK,111\n"                                   // 17 gone now
+        "REMOVE_USER,U1\n"                                    // 18 still has 222
+        "REMOVE_USER\n"                                       // 19 missing ID
+        "REMOVE_USER,U1,junk\n"                               // 20 extra field
+        "BORROW,U1,222,2024-02-30,2024-03-01\n"               // 21 bad date
+        "ADD_USER,STUDENT,U2,Name Two\n"                      // 22 short row
+        "FROB,1\n"                                            // 23 unknown
+        "ADD_USER,TEACHER,U2,Name Two,Physics,1.5\n");        // 24
+
+    Library lib;
+    std::ostringstream out;
+    BatchProcessor batch(lib, out);
+    CHECK(batch.run(file));
+
+    const std::string expected =
+        "1,OK\n"
+        "2,OK\n"
+        "3,FAILED,duplicate ISBN\n"
+        "4,OK\n"
+        "7,OK,REC1\n"
+        "8,OK,REC2\n"
+        "9,FAILED,unknown user\n"
+        "10,FAILED,unknown book\n"
+        "11,FAILED,no copies available\n"
+        "12,OK\n"
+        "13,FAILED,already returned\n"
+        "14,FAILED,unknown record\n"
+        "15,ERROR,field 3: unexpected extra fields\n"
+        "16,OK\n"
+        "17,FAILED,unknown book\n"
+        "18,FAILED,user has books on loan\n"
+        "19,ERROR,field 2 (userID): missing\n"
+        "20,ERROR,field 3: unexpected extra fields\n"
+        "21,ERROR,field 4 (borrowed): invalid value\n"
+        "22,ERROR,field 5 (major): missing\n"
+        "23,ERROR,unknown transaction FROB\n"
+        "24,OK\n";
+    CHECK(out.str() == expected);
+    if (out.str() != expected)
+        std::cerr << out.str();
+    CHECK(batch.getSucceeded() == 8);
+    CHECK(batch.getFailed() == 14);
+
+    // Only the applied lines changed the library
+    CHECK(!lib.searchBook("111"));
+    CHECK(lib.getAvailableCopies("222") == 0);
+    CHECK(lib.getTotalUsers() == 2);
+    CHECK(userOf(*lib.searchUser("U1")).getFeesDue() == 2.0);
+    CHECK(userOf(*lib.searchUser("U2")).getFeesDue() == 1.5);
+    CHECK(lib.getBorrowedCount() == 1);
+}
+
+static void testUnreadableFile() {
+    Library lib;
+    std::ostringstream out;
+    BatchProcessor batch(lib, out);
+    CHECK(!batch.run("/nonexistent/batch.txt"));
+    CHECK(out.str().empty());
+}
+
+int main() {
+    testMixedStream();
+    testUnreadableFile();
+    return testResult("test_batch");
+}
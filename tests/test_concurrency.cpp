@@ -0,0 +1,159 @@
+#include "TestSupport.h"
+#include "Library.h"
+#include "Journal.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <random>
+#include <thread>
+
+/*
+ * test_concurrency.cpp
+ * Several desks borrow, return and query at once while another adds and
+ * removes books and users. Afterwards copies, open loans and fees must add up
+ * to what the desks did, and replaying the journal they all wrote to must
+ * rebuild the same library. Worth running under ThreadSanitizer too (see Makefile).
+ */
+
+static const int DESKS = 8;
+static const int OPS = 4000;
+static const int BOOKS = 200;
+static const int USERS = 300;
+static const int COPIES = 3;
+static const DayNumber DUE = daysFromCivil(2024, 1, 15);
+
+static std::string isbnOf(int i) { return "ISBN" + std::to_string(i); }
+static std::string userIDOf(int i) { return "U" + std::to_string(i); }
+
+// What one desk did, checked on the main thread once every desk is done
+struct DeskTally {
+    long borrowed = 0, returned = 0, lateDays = 0;
+    int failedReturns = 0;     // returns of its own open loans that didn't go through
+    int acceptedRepeats = 0;   // second returns of the same loan that did
+};
+
+static void runDesk(Library& lib, int desk, DeskTally& tally) {
+    std::mt19937 rng(desk);
+    std::vector<std::uint64_t> mine;
+
+    for (int i = 0; i < OPS; ++i) {
+        int op = static_cast<int>(rng() % 10);
+        if (op < 4) {
+            std::vector<BorrowRequest> batch{ { userIDOf(rng() % USERS), isbnOf(rng() % BOOKS), 2024, 1, 1, 2024, 1, 15 } };
+            std::vector<std::uint64_t> ids;
+            if (lib.borrowMany(batch, &ids)[0] == ChangeStatus::OK) {
+                mine.push_back(ids[0]);
+                tally.borrowed++;
+            }
+        }
+        else if (op < 7 && !mine.empty()) {
+            std::uint64_t id = mine.back();
+            mine.pop_back();
+            int day = 10 + static_cast<int>(rng() % 15);
+            if (lib.returnBook(id, 2024, 1, day, 1.0)) {
+                tally.returned++;
+                tally.lateDays += std::max(0, daysFromCivil(2024, 1, day) - DUE);
+            }
+            else {
+                tally.failedReturns++;
+            }
+            if (lib.returnBook(id, 2024, 1, day, 1.0))
+                tally.acceptedRepeats++;
+        }
+        else if (op < 9) {
+            lib.searchBook(isbnOf(rng() % BOOKS));
+            lib.searchUser(userIDOf(rng() % USERS));
+            lib.getAvailableCopies(isbnOf(rng() % BOOKS));
+            lib.getOverdueLoans(DUE);
+            lib.getStats();
+            lib.getOpenLoans(userIDOf(rng() % USERS));
+        }
+        else {
+            lib.projectLateFees(daysFromCivil(2024, 2, 1), 1.0);
+            lib.loanReport(LoanGroupBy::USER, LoanMeasure::DAYS_LATE);
+        }
+    }
+}
+
+// Adds and removes books and users, which waits for every desk each time
+static void runCatalogDesk(Library& lib) {
+    for (int i = 0; i < OPS / 10; ++i) {
+        lib.addBook(Book("X" + std::to_string(i), "Extra title", "B", 2001, 1));
+        lib.addUser(std::make_unique<Teacher>("V" + std::to_string(i), "N", "D"));
+        lib.searchBooksByKeywords("extra");
+        lib.autocompleteBooks("ex", 5);
+        lib.removeBook("X" + std::to_string(i));
+        lib.removeUser("V" + std::to_string(i));
+    }
+}
+
+static double totalFees(const Library& lib) {
+    double fees = 0;
+    for (int i = 0; i < USERS; ++i)
+        fees += userOf(*lib.searchUser(userIDOf(i))).getFeesDue();
+    return fees;
+}
+
+int main() {
+    TempDir dir;
+    const std::string wal = dir.file("journal.log");
+
+    Library lib;
+    Journal journal;
+    CHECK(journal.open(wal));
+    lib.attachJournal(&journal);
+
+    for (int i = 0; i < BOOKS; ++i)
+        lib.addBook(Book(isbnOf(i), "T" + std::to_string(i), "A", 2000, COPIES));
+    for (int i = 0; i < USERS; ++i)
+        lib.addUser(std::make_unique<Student>(userIDOf(i), "N", "M"));
+
+    std::vector<DeskTally> tallies(DESKS);
+    std::vector<std::thread> desks;
+    for (int d = 0; d < DESKS; ++d)
+        desks.emplace_back(runDesk, std::ref(lib), d, std::ref(tallies[d]));
+    desks.emplace_back(runCatalogDesk, std::ref(lib));
+    for (auto& t : desks)
+        t.join();
+    CHECK(journal.commit());
+
+    DeskTally all;
+    for (const DeskTally& t : tallies) {
+        all.borrowed += t.borrowed;
+        all.returned += t.returned;
+        all.lateDays += t.lateDays;
+        CHECK(t.failedReturns == 0);
+        CHECK(t.acceptedRepeats == 0);
+    }
+    CHECK(all.borrowed > 0 && all.returned > 0 && all.lateDays > 0);
+
+    // Every copy is on a shelf or out on exactly one open loan
+    const long out = all.borrowed - all.returned;
+    long available = 0;
+    for (int i = 0; i < BOOKS; ++i)
+        available += lib.getAvailableCopies(isbnOf(i));
+    CHECK(available + out == static_cast<long>(BOOKS) * COPIES);
+
+    LibraryStats stats = lib.getStats();
+    CHECK(lib.getBorrowedCount() == out);
+    CHECK(stats.copiesOut == out);
+    CHECK(static_cast<long>(lib.getOverdueLoans(INT32_MAX).size()) == out);
+
+    // Fees are whole days at 1.0 a day, so the sums are exact
+    CHECK(totalFees(lib) == static_cast<double>(all.lateDays));
+    CHECK(stats.totalFeesDue == static_cast<double>(all.lateDays));
+
+    // The journal holds the desks' changes in an order that replays to the same state
+    Library restarted;
+    CHECK(restarted.replayJournal(wal));
+    for (int i = 0; i < BOOKS; ++i)
+        CHECK(restarted.getAvailableCopies(isbnOf(i)) == lib.getAvailableCopies(isbnOf(i)));
+    LibraryStats replayed = restarted.getStats();
+    CHECK(replayed.openLoans == stats.openLoans);
+    CHECK(replayed.copiesOut == stats.copiesOut);
+    CHECK(replayed.usersWithFees == stats.usersWithFees);
+    CHECK(totalFees(restarted) == totalFees(lib));
+    CHECK(restarted.getTotalBooks() == BOOKS && restarted.getTotalUsers() == USERS);
+
+    return testResult("test_concurrency");
+}
@@ -0,0 +1,76 @@
+#include "TestSupport.h"
+#include "Library.h"
+#include <algorithm>
+
+/*
+ * test_csv.cpp
+ * Rows the loaders accept with blanks around numbers, and rows they can't use
+ * at all surviving the next rewrite of their file.
+ */
+
+static bool contains(const std::vector<std::string>& lines, const std::string& line) {
+    return std::find(lines.begin(), lines.end(), line) != lines.end();
+}
+
+static void testBlanksAroundNumbers() {
+    TempDir dir;
+    writeFile(dir.file("users.csv"), "TEACHER,T1,Dr X,Math, 2.5\nSTUDENT,S1,Ann,Art,\t1 \n");
+    writeFile(dir.file("books.csv"), "111,Title,Author, 1937 ,4, 4\n");
+    writeFile(dir.file("records.csv"), "REC1,S1,111, 2024-01-02,2024-01-16 ,NOT_RETURNED\n");
+
+    Library lib;
+    CHECK(lib.loadUsers(dir.file("users.csv")));
+    CHECK(lib.loadBooks(dir.file("books.csv")));
+    CHECK(lib.loadRecords(dir.file("records.csv"), 1));
+    CHECK(lib.getTotalUsers() == 2);
+    CHECK(lib.searchUser("T1") && userOf(*lib.searchUser("T1")).getFeesDue() == 2.5);
+    CHECK(lib.searchUser("S1") && userOf(*lib.searchUser("S1")).getFeesDue() == 1);
+    CHECK(lib.searchBook("111") && lib.searchBook("111")->getYear() == 1937);
+    CHECK(lib.getOpenLoans("S1").size() == 1);
+}
+
+static void testRejectedRowsAreKept() {
+    TempDir dir;
+    const std::string users = dir.file("users.csv");
+    const std::string books = dir.file("books.csv");
+    const std::string records = dir.file("records.csv");
+    writeFile(users, "STUDENT,S1,Ann,Art,0\nUSER,U1,Someone,0\nSTUDENT,S1,Copy,Art,0\n");
+    writeFile(books, "111,Title,Author,1937,4,4\nnot a book\n111,Again,Author,1937,1,1\n");
+    writeFile(records, "REC1,S1,111,2024-01-02,2024-01-16,NOT_RETURNED\nREC2,S1,garbage\n");
+
+    Library lib;
+    CHECK(lib.loadUsers(users));
+    CHECK(lib.loadBooks(books));
+    CHECK(lib.loadRecords(records, 1));
+    CHECK(lib.getTotalUsers() == 1 && lib.getTotalBooks() == 1);
+
+    // Every file gets rewritten: a new user and book, and a return of a saved record
+    CHECK(lib.addUser(std::make_unique<Student>("S2", "Bo", "Law")));
+    CHECK(lib.addBook(Book("222", "Other", "Writer", 2000, 1)));
+    CHECK(lib.returnBook(std::uint64_t(1), 2024, 1, 10, 0.5));
+    CHECK(lib.saveUsers(users) && lib.saveBooks(books) && lib.saveRecords(records));
+
+    std::vector<std::string> userLines = readLines(users);
+    CHECK(contains(userLines, "USER,U1,Someone,0"));
+    CHECK(contains(userLines, "STUDENT,S1,Copy,Art,0"));
+    CHECK(contains(userLines, "STUDENT,S2,Bo,Law,0"));
+    std::vector<std::string> bookLines = readLines(books);
+    CHECK(contains(bookLines, "not a book"));
+    CHECK(contains(bookLines, "111,Again,Author,1937,1,1"));
+    std::vector<std::string> recordLines = readLines(records);
+    CHECK(contains(recordLines, "REC2,S1,garbage"));
+    CHECK(recordLines.size() == 2);
+
+    // And they stay put across another load and save
+    Library again;
+    CHECK(again.loadUsers(users) && again.loadBooks(books) && again.loadRecords(records, 1));
+    CHECK(again.getTotalUsers() == 2 && again.getTotalBooks() == 2);
+    CHECK(again.saveUsers(dir.file("users2.csv")));
+    CHECK(readLines(dir.file("users2.csv")) == userLines);
+}
+
+int main() {
+    testBlanksAroundNumbers();
+    testRejectedRowsAreKept();
+    return testResult("test_csv");
+}
@@ -0,0 +1,92 @@
+#include "TestSupport.h"
+#include "BorrowRecord.h"
+#include "Date.h"
+
+/*
+ * test_date.cpp
+ * Day numbers across month ends, Feb 29 in leap and non-leap years and the
+ * year boundary, their round trip back to y-m-d, and BorrowRecord::daysLate
+ * on either side of the due date.
+ */
+
+static void testMonthEnds() {
+    for (int m = 1; m <= 12; m++) {
+        int last = daysInMonth(2023, m);
+        int nextY = m == 12 ? 2024 : 2023, nextM = m == 12 ? 1 : m + 1;
+        CHECK(daysFromCivil(nextY, nextM, 1) - daysFromCivil(2023, m, last) == 1);
+        CHECK(!isValidDate(2023, m, last + 1));
+    }
+    CHECK(daysInMonth(2023, 4) == 30);
+    CHECK(daysInMonth(2023, 12) == 31);
+}
+
+static void testLeapDays() {
+    // 2024 and 2000 have a Feb 29, 2023 and 1900 don't
+    CHECK(isValidDate(2024, 2, 29));
+    CHECK(isValidDate(2000, 2, 29));
+    CHECK(!isValidDate(2023, 2, 29));
+    CHECK(!isValidDate(1900, 2, 29));
+
+    CHECK(daysFromCivil(2024, 3, 1) - daysFromCivil(2024, 2, 28) == 2);
+    CHECK(daysFromCivil(2024, 3, 1) - daysFromCivil(2024, 2, 29) == 1);
+    CHECK(daysFromCivil(2023, 3, 1) - daysFromCivil(2023, 2, 28) == 1);
+    CHECK(daysFromCivil(1900, 3, 1) - daysFromCivil(1900, 2, 28) == 1);
+
+    CHECK(daysFromCivil(2025, 1, 1) - daysFromCivil(2024, 1, 1) == 366);
+    CHECK(daysFromCivil(2024, 1, 1) - daysFromCivil(2023, 1, 1) == 365);
+}
+
+static void testYearBoundary() {
+    CHECK(daysFromCivil(2024, 1, 1) - daysFromCivil(2023, 12, 31) == 1);
+    CHECK(daysFromCivil(1970, 1, 1) == 0);
+    CHECK(daysFromCivil(1969, 12, 31) == -1);
+}
+
+// Every day from 1899 to 2101 converts back to itself, one day after the other
+static void testRoundTrip() {
+    DayNumber expected = daysFromCivil(1899, 1, 1);
+    for (int y = 1899; y <= 2101; y++) {
+        for (int m = 1; m <= 12; m++) {
+            for (int d = 1; d <= daysInMonth(y, m); d++) {
+                DayNumber day = daysFromCivil(y, m, d);
+                CHECK(day == expected);
+                int ry, rm, rd;
+                civilFromDays(day, ry, rm, rd);
+                CHECK(ry == y && rm == m && rd == d);
+                expected++;
+            }
+        }
+    }
+}
+
+static int lateDays(DayNumber due, int ry, int rm, int rd) {
+    BorrowRecord rec(1, 0, 0, due - 14, due);
+    rec.markReturned(ry, rm, rd);
+    return rec.daysLate();
+}
+
+static void testDaysLate() {
+    // Returned on or before the due date
+    CHECK(lateDays(daysFromCivil(2024, 3, 1), 2024, 3, 1) == 0);
+    CHECK(lateDays(daysFromCivil(2024, 3, 1), 2024, 2, 20) == 0);
+
+    // Across a leap day, a non-leap February and the year end
+    CHECK(lateDays(daysFromCivil(2024, 2, 28), 2024, 3, 1) == 2);
+    CHECK(lateDays(daysFromCivil(2023, 2, 28), 2023, 3, 1) == 1);
+    CHECK(lateDays(daysFromCivil(2024, 2, 29), 2024, 3, 1) == 1);
+    CHECK(lateDays(daysFromCivil(2023, 12, 31), 2024, 1, 2) == 2);
+    CHECK(lateDays(daysFromCivil(2024, 1, 31), 2024, 2, 1) == 1);
+
+    // Not returned yet
+    BorrowRecord open(1, 0, 0, daysFromCivil(2024, 1, 1), daysFromCivil(2024, 1, 15));
+    CHECK(open.daysLate() == 0);
+}
+
+int main() {
+    testMonthEnds();
+    testLeapDays();
+    testYearBoundary();
+    testRoundTrip();
+    testDaysLate();
+    return testResult("test_date");
+}
@@ -0,0 +1,184 @@
+#include "TestSupport.h"
+#include "Journal.h"
+#include "Library.h"
+
+/*
+ * test_journal.cpp
+ * Replaying the write-ahead log on top of data files saved at any point of a
+ * checkpoint (nothing saved, some files saved, everything saved but the log
+ * not cleared) gives the same state as the run that wrote the log.
+ */
+
+struct Files {
+    TempDir dir;
+    std::string books = dir.file("books.csv");
+    std::string users = dir.file("users.csv");
+    std::string records = dir.file("records.csv");
+    std::string wal = dir.file("library.wal");
+
+    Files() {
+        writeFile(books, "X,Title,Author,2000,5,5\n");
+        writeFile(users, "STUDENT,U1,Name,Major,0\n");
+        writeFile(records, "");
+    }
+};
+
+static void load(Library& lib, const Files& f) {
+    CHECK(lib.loadBooks(f.books));
+    CHECK(lib.loadUsers(f.users));
+    CHECK(lib.loadRecords(f.records, 1));
+}
+
+static double feesOf(Library& lib, const std::string& id) {
+    std::optional<UserVariant> u = lib.searchUser(id);
+    return u ? userOf(*u).getFeesDue() : -1;
+}
+
+// The state the logged run below ends in
+static void checkFinalState(Library& lib) {
+    CHECK(lib.getAvailableCopies("X") == 4);
+    CHECK(lib.getOpenLoans("U1").size() == 1);
+    CHECK(lib.getOpenLoans("U1")[0].getRecordID() == 2);
+    CHECK(feesOf(lib, "U1") == 1.5);
+    CHECK(lib.getBorrowedCount() == 1);
+}
+
+// Remove and re-add X, borrow it, return it three days late, borrow again
+static void run(Library& lib, Journal& journal) {
+    lib.attachJournal(&journal);
+    CHECK(lib.removeBook("X"));
+    CHECK(lib.addBook(Book("X", "Title", "Author", 2000, 5)));
+    CHECK(lib.borrowBook("U1", "X", 2024, 1, 1, 2024, 1, 15));
+    CHECK(lib.returnBook(std::uint64_t(1), 2024, 1, 18, 0.5));
+    CHECK(lib.borrowBook("U1", "X", 2024, 2, 1, 2024, 2, 15));
+    checkFinalState(lib);
+}
+
+static void replayAfter(const Files& f) {
+    Library restarted;
+    load(restarted, f);
+    CHECK(restarted.replayJournal(f.wal));
+    checkFinalState(restarted);
+
+    // Replaying the same log a second time changes nothing either
+    CHECK(restarted.replayJournal(f.wal));
+    checkFinalState(restarted);
+}
+
+static void testNothingSaved() {
+    Files f;
+    Library lib;
+    Journal journal;
+    load(lib, f);
+    CHECK(journal.open(f.wal, 1));
+    run(lib, journal);
+    replayAfter(f);
+}
+
+// The reviewer's case: the data files already hold every change but the log
+// wasn't cleared. Re-applying "remove X, add X, borrow" used to give X 5/5 with REC1 open.
+static void testEverythingSaved() {
+    Files f;
+    Library lib;
+    Journal journal;
+    load(lib, f);
+    CHECK(journal.open(f.wal, 1));
+    run(lib, journal);
+    CHECK(lib.saveBooks(f.books) && lib.saveUsers(f.users) && lib.saveRecords(f.records));
+    CHECK(readLines(f.books)[0] == "#checkpoint,5");
+    replayAfter(f);
+}
+
+// A checkpoint that stopped after some files: each file only gets what it misses
+static void testPartlySaved() {
+    for (int saved = 1; saved <= 2; saved++) {
+        Files f;
+        Library lib;
+        Journal journal;
+        load(lib, f);
+        CHECK(journal.open(f.wal, 1));
+        run(lib, journal);
+        CHECK(lib.saveBooks(f.books));
+        if (saved == 2)
+            CHECK(lib.saveUsers(f.users));
+        replayAfter(f);
+    }
+}
+
+// Numbering carries on after a checkpoint clears the log
+static void testNumberingContinues() {
+    Files f;
+    {
+        Library lib;
+        Journal journal;
+        load(lib, f);
+        CHECK(journal.open(f.wal, 1));
+        run(lib, journal);
+        CHECK(lib.saveBooks(f.books) && lib.saveUsers(f.users) && lib.saveRecords(f.records));
+        CHECK(journal.clear());
+    }
+    Library lib;
+    load(lib, f);
+    CHECK(lib.replayJournal(f.wal));
+    Journal journal;
+    CHECK(journal.open(f.wal, 1));
+    lib.attachJournal(&journal);
+    CHECK(lib.returnBook(std::uint64_t(2), 2024, 2, 10, 0.5));
+    journal.close();
+    CHECK(readLines(f.wal).size() == 1 && readLines(f.wal)[0].rfind("6,R,", 0) == 0);
+}
+
+// A record ID past what records.csv could hold is rejected like any other
+// bad entry, without growing the ID table to reach it or moving numbering on
+static void testOutOfRangeID() {
+    Files f;
+    writeFile(f.wal,
+        "1,B,REC99999999999,U1,X,2024,1,1,2024,1,15\n"
+        "2,B,REC18446744073709551615,U1,X,2024,1,1,2024,1,15\n"
+        "3,R,REC18446744073709551615,2024,1,18,0.5\n"
+        "4,B,REC1,U1,X,2024,2,1,2024,2,15\n");
+    Library lib;
+    load(lib, f);
+    CHECK(lib.replayJournal(f.wal));
+    CHECK(lib.getAvailableCopies("X") == 4);
+    CHECK(lib.getOpenLoans("U1").size() == 1);
+    CHECK(lib.getOpenLoans("U1")[0].getRecordID() == 1);
+    CHECK(feesOf(lib, "U1") == 0);
+
+    std::vector<std::uint64_t> ids;
+    CHECK(lib.borrowMany({ BorrowRequest{ "U1", "X", 2024, 3, 1, 2024, 3, 15 } }, &ids)[0] == ChangeStatus::OK);
+    CHECK(ids[0] == 2);
+}
+
+// Entries are parsed in full: a number with trailing junk, a missing or extra
+// field, an impossible date or an entry without a sequence number is skipped
+static void testMalformedEntries() {
+    Files f;
+    writeFile(f.wal,
+        "1,B,REC1,U1,X,2024,1x,1,2024,1,15\n"
+        "2,B,REC1,U1,X,2024,1,1,2024,1\n"
+        "3,B,REC1,U1,X,2024,1,1,2024,1,15,9\n"
+        "4,B,REC1,U1,X,2024,2,30,2024,3,15\n"
+        "B,REC1,U1,X,2024,1,1,2024,1,15\n"
+        "5,B,REC1,U1,X,2024,1,1,2024,1,15\n"
+        "6,R,REC1,2024,1,18,abc\n"
+        "7,R,REC1,2024,1,18\n"
+        "R,REC1,2024,1,18,0.5\n");
+    Library lib;
+    load(lib, f);
+    CHECK(lib.replayJournal(f.wal));
+    CHECK(lib.getAvailableCopies("X") == 4);
+    CHECK(lib.getOpenLoans("U1").size() == 1);
+    CHECK(lib.getOpenLoans("U1")[0].getRecordID() == 1);
+    CHECK(feesOf(lib, "U1") == 0);
+}
+
+int main() {
+    testNothingSaved();
+    testEverythingSaved();
+    testPartlySaved();
+    testNumberingContinues();
+    testOutOfRangeID();
+    testMalformedEntries();
+    return testResult("test_journal");
+}
@@ -0,0 +1,76 @@
+#include "TestSupport.h"
+#include "KeywordIndex.h"
+#include <algorithm>
+
+/*
+ * test_keyword_index.cpp
+ * Keyword search after adds and removes in any order, checked against a
+ * brute-force scan of the books still indexed.
+ */
+
+static std::vector<std::size_t> bruteForce(const std::vector<Book>& books, const std::vector<bool>& present,
+                                           const std::string& query) {
+    std::vector<std::string> words = KeywordIndex::tokenize(query);
+    std::vector<std::size_t> result;
+    for (std::size_t slot = 0; slot < books.size(); slot++) {
+        if (!present[slot])
+            continue;
+        std::vector<std::string> terms = KeywordIndex::tokenize(books[slot].getTitle());
+        std::vector<std::string> author = KeywordIndex::tokenize(books[slot].getAuthor());
+        terms.insert(terms.end(), author.begin(), author.end());
+
+        bool all = !words.empty();
+        for (const auto& w : words)
+            all = all && std::find(terms.begin(), terms.end(), w) != terms.end();
+        if (all)
+            result.push_back(slot);
+    }
+    return result;
+}
+
+int main() {
+    const char* words[] = { "river", "night", "glass", "garden", "winter", "house", "stone", "song" };
+    std::vector<Book> books;
+    for (int i = 0; i < 400; i++) {
+        std::string title = std::string(words[i % 8]) + " " + words[(i / 8) % 8] + " " + words[(i * 7) % 8];
+        books.emplace_back(std::to_string(i), title, i % 3 ? "Ann Lee" : "Bo River", 2000, 1);
+    }
+
+    KeywordIndex index;
+    std::vector<bool> present(books.size(), false);
+    for (std::size_t slot = 0; slot < books.size(); slot++) {
+        index.add(slot, books[slot]);
+        present[slot] = true;
+    }
+
+    const char* queries[] = { "river", "river night", "Glass garden", "lee winter", "bo", "song stone river",
+                              "missing", "" };
+    auto checkAll = [&] {
+        for (const char* q : queries)
+            CHECK(index.search(q) == bruteForce(books, present, q));
+    };
+    checkAll();
+
+    // Remove every third book, then add some back
+    for (std::size_t slot = 0; slot < books.size(); slot += 3) {
+        index.remove(slot);
+        present[slot] = false;
+    }
+    checkAll();
+    for (std::size_t slot = 0; slot < books.size(); slot += 6) {
+        index.add(slot, books[slot]);
+        present[slot] = true;
+    }
+    checkAll();
+
+    // Removing everything empties every term
+    for (std::size_t slot = 0; slot < books.size(); slot++) {
+        if (present[slot])
+            index.remove(slot);
+        present[slot] = false;
+    }
+    checkAll();
+    CHECK(index.search("river").empty());
+
+    return testResult("test_keyword_index");
+}
@@ -0,0 +1,108 @@
+#include "TestSupport.h"
+#include "Library.h"
+#include <cmath>
+
+/*
+ * test_late_fees.cpp
+ * projectLateFees (the pass over the open loan columns) against
+ * projectLateFeesReference (a scan of every record), user by user and fee by
+ * fee, for loans due on month ends, Feb 28/29 and Dec 31, as of dates on
+ * either side of them, before and after the users are reloaded. A few fees
+ * are also worked out by hand.
+ */
+
+using Fees = std::vector<std::pair<std::string, double>>;
+
+static double feeOf(const Fees& fees, const std::string& userID) {
+    for (const auto& f : fees) {
+        if (f.first == userID)
+            return f.second;
+    }
+    return 0.0;
+}
+
+int main() {
+    Library lib;
+    CHECK(lib.addBook(Book("111", "Title", "Author", 2000, 100)));
+    for (const char* id : { "S1", "S2", "S3", "S4" })
+        CHECK(lib.addUser(std::make_unique<Student>(id, "Name", "Major")));
+    CHECK(lib.addUser(std::make_unique<Teacher>("T1", "Name", "Dept")));
+
+    // (user, due y-m-d), all borrowed two weeks before they're due
+    struct Loan { const char* user; int y, m, d; };
+    const Loan loans[] = {
+        { "S1", 2024, 1, 31 }, { "S1", 2024, 2, 29 }, { "S1", 2024, 4, 30 },
+        { "S2", 2023, 2, 28 }, { "S2", 2023, 12, 31 },
+        { "S3", 2024, 2, 28 }, { "S3", 2024, 3, 1 },
+        { "S4", 2024, 2, 29 },
+        { "T1", 2023, 12, 31 }, { "T1", 2024, 12, 31 }, { "T1", 2025, 1, 31 },
+    };
+    std::vector<std::uint64_t> ids;
+    for (const Loan& l : loans) {
+        int by, bm, bd;
+        civilFromDays(daysFromCivil(l.y, l.m, l.d) - 14, by, bm, bd);
+        std::vector<std::uint64_t> id;
+        CHECK(lib.borrowMany({ BorrowRequest{ l.user, "111", by, bm, bd, l.y, l.m, l.d } }, &id)[0] == ChangeStatus::OK);
+        ids.push_back(id[0]);
+    }
+
+    // Returned loans owe nothing more; S4's only loan goes back
+    CHECK(lib.returnBook(ids[7], 2024, 3, 10, 0.25));
+
+    const DayNumber dates[] = {
+        daysFromCivil(2023, 3, 1), daysFromCivil(2024, 1, 1), daysFromCivil(2024, 2, 29),
+        daysFromCivil(2024, 3, 1), daysFromCivil(2024, 5, 1), daysFromCivil(2025, 1, 1),
+        daysFromCivil(2025, 3, 1),
+    };
+    for (DayNumber asOf : dates) {
+        for (double rate : { 0.25, 1.0, 0.1 }) {
+            Fees fast = lib.projectLateFees(asOf, rate);
+            Fees reference = lib.projectLateFeesReference(asOf, rate);
+            CHECK(fast.size() == reference.size());
+            for (std::size_t i = 0; i < fast.size() && i < reference.size(); i++) {
+                CHECK(fast[i].first == reference[i].first);
+                // Same late days per user; at 0.1 a day the two sum in a different order
+                if (rate == 0.1)
+                    CHECK(std::abs(fast[i].second - reference[i].second) < 1e-9);
+                else
+                    CHECK(fast[i].second == reference[i].second);
+            }
+        }
+    }
+
+    // By hand, as of 2024-03-01: S1 is 30 + 1 days late (Jan 31, Feb 29), S2
+    // 367 + 61 (2023-02-28, 2023-12-31), S3 2 (Feb 28, the Mar 1 loan is due
+    // today), T1 61 (2023-12-31), S4 has returned everything
+    Fees fees = lib.projectLateFees(daysFromCivil(2024, 3, 1), 1.0);
+    CHECK(feeOf(fees, "S1") == 31.0);
+    CHECK(feeOf(fees, "S2") == 428.0);
+    CHECK(feeOf(fees, "S3") == 2.0);
+    CHECK(feeOf(fees, "T1") == 61.0);
+    CHECK(feeOf(fees, "S4") == 0.0);
+    CHECK(fees.size() == 4);
+
+    // Reloading the users relinks the columns to their new slots; T1 is left out
+    TempDir dir;
+    const std::string users = dir.file("users.csv");
+    CHECK(lib.saveUsers(users));
+    std::vector<std::string> kept;
+    for (const auto& line : readLines(users)) {
+        if (line.find(",T1,") == std::string::npos)
+            kept.push_back(line);
+    }
+    std::string text;
+    for (const auto& line : kept)
+        text += line + "\n";
+    writeFile(users, text);
+    CHECK(lib.loadUsers(users));
+    for (DayNumber asOf : dates)
+        CHECK(lib.projectLateFees(asOf, 0.25) == lib.projectLateFeesReference(asOf, 0.25));
+    CHECK(feeOf(lib.projectLateFees(daysFromCivil(2024, 3, 1), 1.0), "T1") == 0.0);
+    CHECK(feeOf(lib.projectLateFees(daysFromCivil(2024, 3, 1), 1.0), "S2") == 428.0);
+
+    // Before any loan is due nobody owes anything
+    CHECK(lib.projectLateFees(daysFromCivil(2023, 2, 28), 1.0).empty());
+    CHECK(lib.projectLateFeesReference(daysFromCivil(2023, 2, 28), 1.0).empty());
+
+    return testResult("test_late_fees");
+}
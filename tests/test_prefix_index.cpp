@@ -0,0 +1,76 @@
+#include "TestSupport.h"
+#include "PrefixIndex.h"
+#include <algorithm>
+
+/*
+ * test_prefix_index.cpp
+ * Autocomplete through enough adds and removes to force merges, checked
+ * against a brute-force scan of the books still indexed.
+ */
+
+// Slots whose title or author starts with prefix, ordered as PrefixIndex orders them
+static std::vector<std::size_t> bruteForce(const std::vector<Book>& books, const std::vector<bool>& present,
+                                           const std::string& prefix, std::size_t limit) {
+    std::string p = PrefixIndex::normalize(prefix);
+    std::vector<std::pair<std::string, std::size_t>> keys;
+    for (std::size_t slot = 0; slot < books.size(); slot++) {
+        if (!present[slot])
+            continue;
+        for (const std::string& key : { PrefixIndex::normalize(books[slot].getTitle()),
+                                        PrefixIndex::normalize(books[slot].getAuthor()) })
+            if (!p.empty() && key.compare(0, p.size(), p) == 0)
+                keys.emplace_back(key, slot);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<std::size_t> result;
+    for (const auto& k : keys)
+        if (result.size() < limit && std::find(result.begin(), result.end(), k.second) == result.end())
+            result.push_back(k.second);
+    return result;
+}
+
+int main() {
+    const char* words[] = { "River", "Night", "Glass", "Garden", "Winter", "House", "Stone", "Song" };
+    std::vector<Book> books;
+    for (int i = 0; i < 6000; i++) {
+        std::string title = std::string(words[i % 8]) + "  " + words[(i / 8) % 8] + " " + std::to_string(i % 97);
+        std::string author = std::string(words[(i * 5) % 8]) + " Writer";
+        books.emplace_back(std::to_string(i), title, author, 2000, 1);
+    }
+
+    PrefixIndex index;
+    std::vector<bool> present(books.size(), false);
+    const char* prefixes[] = { "r", "river n", "GARDEN", "garden  house 1", "song writer", "s", "x", "" };
+    auto checkAll = [&] {
+        for (const char* prefix : prefixes)
+            for (std::size_t limit : { 1, 10, 5000 })
+                CHECK(index.complete(prefix, limit) == bruteForce(books, present, prefix, limit));
+    };
+
+    for (std::size_t slot = 0; slot < books.size(); slot++) {
+        index.add(slot, books[slot]);
+        present[slot] = true;
+    }
+    checkAll();
+
+    for (std::size_t slot = 0; slot < books.size(); slot += 2) {
+        index.remove(slot);
+        present[slot] = false;
+    }
+    checkAll();
+
+    // Re-add some, so dead and live entries for the same key and slot coexist
+    for (std::size_t slot = 0; slot < books.size(); slot += 4) {
+        index.add(slot, books[slot]);
+        present[slot] = true;
+    }
+    checkAll();
+    for (std::size_t slot = 0; slot < books.size(); slot += 8) {
+        index.remove(slot);
+        present[slot] = false;
+    }
+    checkAll();
+
+    return testResult("test_prefix_index");
+}
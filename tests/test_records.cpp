@@ -0,0 +1,175 @@
+#include "TestSupport.h"
+#include "Library.h"
+
+/*
+ * test_records.cpp
+ * Record IDs read from records.csv: gaps are kept, only collisions and IDs
+ * that can't be kept are renumbered, and new IDs start after the highest one.
+ * Loan reports read the same records, returns included.
+ */
+
+static std::string recordLine(long long id, const char* user) {
+    return "REC" + std::to_string(id) + "," + user + ",111,2024-01-02,2024-01-16,NOT_RETURNED\n";
+}
+
+static std::vector<std::string> recordIDs(const std::string& filename) {
+    std::vector<std::string> ids;
+    for (const auto& line : readLines(filename))
+        ids.push_back(line.substr(0, line.find(',')));
+    return ids;
+}
+
+static void setUp(Library& lib) {
+    CHECK(lib.addBook(Book("111", "Title", "Author", 2000, 50)));
+    CHECK(lib.addUser(std::make_unique<Student>("U1", "Name", "Major")));
+}
+
+// A hand-deleted row leaves a gap; nothing after it is renumbered
+static void testGapsAreKept() {
+    TempDir dir;
+    const std::string file = dir.file("records.csv");
+    writeFile(file, recordLine(1, "U1") + recordLine(2, "U1") + recordLine(4, "U1") + recordLine(5, "U1"));
+
+    Library lib;
+    setUp(lib);
+    CHECK(lib.loadRecords(file, 1));
+    CHECK(lib.returnBook(std::string("REC4"), 2024, 1, 10, 0.5));
+    CHECK(lib.borrowBook("U1", "111", 2024, 2, 1, 2024, 2, 15));
+    CHECK(lib.saveRecords(file));
+    CHECK((recordIDs(file) == std::vector<std::string>{ "REC1", "REC2", "REC4", "REC5", "REC6" }));
+}
+
+// A repeated ID is renumbered past every ID in the file, not into a later row's ID
+static void testCollisionsAreRenumbered() {
+    TempDir dir;
+    const std::string file = dir.file("records.csv");
+    writeFile(file, recordLine(1, "U1") + recordLine(2, "U1") + recordLine(2, "U1") + recordLine(3, "U1") +
+                    recordLine(9000000000, "U1"));
+
+    Library lib;
+    setUp(lib);
+    CHECK(lib.loadRecords(file, 1));
+    CHECK(lib.borrowBook("U1", "111", 2024, 2, 1, 2024, 2, 15));
+    CHECK(lib.saveRecords(file));
+    CHECK((recordIDs(file) == std::vector<std::string>{ "REC1", "REC2", "REC4", "REC3", "REC5", "REC6" }));
+}
+
+// Parsing on the thread pool gives the same records as the serial path, load after load
+static void testThreadedLoadMatchesSerial() {
+    TempDir dir;
+    std::string text;
+    for (int id = 1; id <= 60000; id++)
+        text += recordLine(id, id % 3 ? "U1" : "U2");
+    text += "REC17,U1,111,2024-01-02,2024-01-16,NOT_RETURNED\nnot a record\n";
+    writeFile(dir.file("records.csv"), text);
+
+    Library serial, threaded;
+    setUp(serial);
+    setUp(threaded);
+    CHECK(serial.loadRecords(dir.file("records.csv"), 1));
+    CHECK(serial.saveRecords(dir.file("serial.csv")));
+    for (int round = 0; round < 3; round++) {
+        CHECK(threaded.loadRecords(dir.file("records.csv"), 4));
+        CHECK(threaded.saveRecords(dir.file("threaded.csv")));
+        CHECK(readFile(dir.file("threaded.csv")) == readFile(dir.file("serial.csv")));
+    }
+}
+
+// Appending to a file whose last row has no newline must not glue two rows together
+static void testAppendWithoutTrailingNewline() {
+    TempDir dir;
+    const std::string file = dir.file("records.csv");
+    std::string text = recordLine(1, "U1") + recordLine(2, "U1");
+    text.pop_back();
+    writeFile(file, text);
+
+    Library lib;
+    setUp(lib);
+    CHECK(lib.loadRecords(file, 1));
+    CHECK(lib.borrowBook("U1", "111", 2024, 2, 1, 2024, 2, 15));
+    CHECK(lib.saveRecords(file));
+    CHECK((recordIDs(file) == std::vector<std::string>{ "REC1", "REC2", "REC3" }));
+
+    Library reloaded;
+    setUp(reloaded);
+    CHECK(reloaded.loadRecords(file, 1));
+    CHECK(reloaded.getOpenLoans("U1").size() == 3);
+}
+
+// Reports group the loaded and new records and see returns made since
+static void testLoanReportFollowsRecords() {
+    TempDir dir;
+    const std::string file = dir.file("records.csv");
+    writeFile(file, recordLine(1, "U1") + recordLine(2, "U1") + recordLine(3, "U2"));
+
+    Library lib;
+    setUp(lib);
+    CHECK(lib.loadRecords(file, 1));
+    CHECK(lib.borrowBook("U1", "111", 2024, 2, 1, 2024, 2, 15));
+    CHECK(lib.returnBook(std::string("REC1"), 2024, 1, 20, 0.5)); // 4 days late
+    CHECK(lib.returnBook(std::string("REC4"), 2024, 2, 10, 0.5)); // on time
+
+    std::vector<LoanGroup> loans = lib.loanReport(LoanGroupBy::USER, LoanMeasure::LOANS);
+    CHECK(loans.size() == 2);
+    CHECK(loans[0].key == "U1" && loans[0].count == 3);
+    CHECK(loans[1].key == "U2" && loans[1].count == 1);
+
+    std::vector<LoanGroup> late = lib.loanReport(LoanGroupBy::BORROW_MONTH, LoanMeasure::DAYS_LATE);
+    CHECK(late.size() == 2);
+    CHECK(late[0].key == "2024-01" && late[0].count == 1 && late[0].sum == 4);
+    CHECK(late[1].key == "2024-02" && late[1].count == 1 && late[1].sum == 0);
+
+    std::vector<LoanGroup> out = lib.loanReport(LoanGroupBy::ISBN, LoanMeasure::DAYS_OUT);
+    CHECK(out.size() == 1 && out[0].key == "111" && out[0].count == 2 && out[0].sum == 18 + 9);
+}
+
+// Enough loans to fill several of the log's segments, returned through the
+// bulk call: each user's loan count and days late match the requests
+static void testLoanReportAcrossSegments() {
+    const int LOANS = 20000, USERS = 5;
+    Library lib;
+    CHECK(lib.addBook(Book("111", "Title", "Author", 2000, LOANS)));
+    for (int u = 0; u < USERS; u++)
+        CHECK(lib.addUser(std::make_unique<Student>("U" + std::to_string(u), "Name", "Major")));
+
+    std::vector<BorrowRequest> borrows;
+    for (int i = 0; i < LOANS; i++) {
+        int y, m, d, dy, dm, dd;
+        DayNumber day = daysFromCivil(2024, 1, 1) + i % 90;
+        civilFromDays(day, y, m, d);
+        civilFromDays(day + 14, dy, dm, dd);
+        borrows.push_back({ "U" + std::to_string(i % USERS), "111", y, m, d, dy, dm, dd });
+    }
+    std::vector<std::uint64_t> ids;
+    lib.borrowMany(borrows, &ids);
+
+    // Every third loan comes back between 3 days early and 3 days late
+    std::vector<ReturnRequest> returns;
+    std::vector<std::int64_t> late(USERS, 0), returned(USERS, 0);
+    for (int i = 0; i < LOANS; i += 3) {
+        int offset = i % 7 - 3, y, m, d;
+        civilFromDays(daysFromCivil(2024, 1, 1) + i % 90 + 14 + offset, y, m, d);
+        returns.push_back({ ids[i], y, m, d, 0.25 });
+        late[i % USERS] += offset > 0 ? offset : 0;
+        returned[i % USERS]++;
+    }
+    lib.returnMany(returns);
+
+    std::vector<LoanGroup> loans = lib.loanReport(LoanGroupBy::USER, LoanMeasure::LOANS);
+    std::vector<LoanGroup> lateDays = lib.loanReport(LoanGroupBy::USER, LoanMeasure::DAYS_LATE);
+    CHECK(loans.size() == USERS && lateDays.size() == USERS);
+    for (int u = 0; u < USERS && u < static_cast<int>(lateDays.size()); u++) {
+        CHECK(loans[u].key == "U" + std::to_string(u) && loans[u].count == LOANS / USERS);
+        CHECK(lateDays[u].count == static_cast<std::uint64_t>(returned[u]) && lateDays[u].sum == late[u]);
+    }
+}
+
+int main() {
+    testGapsAreKept();
+    testCollisionsAreRenumbered();
+    testThreadedLoadMatchesSerial();
+    testAppendWithoutTrailingNewline();
+    testLoanReportFollowsRecords();
+    testLoanReportAcrossSegments();
+    return testResult("test_records");
+}
@@ -0,0 +1,88 @@
+#include "TestSupport.h"
+#include "Library.h"
+#include "SlotMap.h"
+
+/*
+ * test_slot_map.cpp
+ * Erasing from a SlotMap (and so removing books and users) must not reorder
+ * what is left: iteration, displays and saved files keep insertion order.
+ */
+
+static std::vector<int> contents(const SlotMap<int>& map) {
+    return std::vector<int>(map.begin(), map.end());
+}
+
+static void testEraseKeepsOrder() {
+    SlotMap<int> map;
+    std::vector<SlotMap<int>::Handle> handles;
+    for (int i = 0; i < 10; i++)
+        handles.push_back(map.insert(i));
+
+    CHECK(map.erase(handles[3]));
+    CHECK(map.erase(handles[7]));
+    CHECK(!map.erase(handles[3]));
+    CHECK(map.get(handles[3]) == nullptr);
+    CHECK(map.size() == 8);
+    CHECK((contents(map) == std::vector<int>{ 0, 1, 2, 4, 5, 6, 8, 9 }));
+
+    // A reused slot still goes to the end of the order, with a new generation
+    auto h = map.insert(10);
+    CHECK(h.slot == handles[7].slot || h.slot == handles[3].slot);
+    CHECK(map.get(handles[7]) == nullptr && map.get(handles[3]) == nullptr);
+    CHECK((contents(map) == std::vector<int>{ 0, 1, 2, 4, 5, 6, 8, 9, 10 }));
+
+    for (auto it = map.begin(); it != map.end(); ++it)
+        CHECK(&map.atSlot(it.slot()) == &*it);
+}
+
+static void testCompactionKeepsOrderAndHandles() {
+    SlotMap<int> map;
+    std::vector<SlotMap<int>::Handle> handles;
+    for (int i = 0; i < 1000; i++)
+        handles.push_back(map.insert(i));
+
+    // Erase most values, which compacts the array several times
+    std::vector<int> expected;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 7 == 0)
+            expected.push_back(i);
+        else
+            map.erase(handles[i]);
+    }
+    CHECK(contents(map) == expected);
+    for (int i = 0; i < 1000; i += 7)
+        CHECK(map.get(handles[i]) && *map.get(handles[i]) == i);
+}
+
+static void testRemovalKeepsSaveOrder() {
+    TempDir dir;
+    Library lib;
+    for (const char* isbn : { "1", "2", "3", "4", "5" })
+        CHECK(lib.addBook(Book(isbn, std::string("Title ") + isbn, "Author", 2000, 1)));
+    for (const char* id : { "U1", "U2", "U3", "U4" })
+        CHECK(lib.addUser(std::make_unique<Student>(id, "Name", "Major")));
+
+    CHECK(lib.removeBook("2"));
+    CHECK(lib.removeUser("U1"));
+    CHECK(lib.addBook(Book("6", "Title 6", "Author", 2000, 1)));
+
+    CHECK(lib.saveBooks(dir.file("books.csv")));
+    CHECK(lib.saveUsers(dir.file("users.csv")));
+
+    std::vector<std::string> isbns;
+    for (const auto& line : readLines(dir.file("books.csv")))
+        isbns.push_back(line.substr(0, line.find(',')));
+    CHECK((isbns == std::vector<std::string>{ "1", "3", "4", "5", "6" }));
+
+    std::vector<std::string> ids;
+    for (const auto& line : readLines(dir.file("users.csv")))
+        ids.push_back(line.substr(line.find(',') + 1, line.find(',', line.find(',') + 1) - line.find(',') - 1));
+    CHECK((ids == std::vector<std::string>{ "U2", "U3", "U4" }));
+}
+
+int main() {
+    testEraseKeepsOrder();
+    testCompactionKeepsOrderAndHandles();
+    testRemovalKeepsSaveOrder();
+    return testResult("test_slot_map");
+}
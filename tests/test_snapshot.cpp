@@ -0,0 +1,251 @@
+#include "TestSupport.h"
+#include "Journal.h"
+#include "Library.h"
+#include <algorithm>
+
+/*
+ * test_snapshot.cpp
+ * A Library loaded from library.snap behaves like the one that wrote it:
+ * the CSV files it saves are the same, every lookup, search, list and report
+ * gives the same answer, and so do both after the same further changes (the
+ * loaded indexes are maintained, not just read). A damaged snapshot, or one
+ * loaded into a Library that already holds data, is refused.
+ */
+
+struct Files {
+    TempDir dir;
+    std::string books = dir.file("books.csv");
+    std::string users = dir.file("users.csv");
+    std::string records = dir.file("records.csv");
+    std::string snap = dir.file("library.snap");
+    std::string wal = dir.file("library.wal");
+
+    Files() {
+        writeFile(books,
+                  "111,The Silent Sea,Ann Lee,1999,3,2\n"
+                  "222,Sea of Stars,Bo Chen,2005,2,1\n"
+                  "333,Winter Garden,Ann Lee,2010,1,1\n"
+                  "444,Stars and Sea,Cy Diaz,2015,4,4\n"
+                  "not a book\n");
+        writeFile(users,
+                  "STUDENT,U1,Name One,Math,1.5\n"
+                  "TEACHER,U2,Name Two,Physics,0\n"
+                  "USER,U3,Name Three,OTHER,2.25\n"
+                  "STUDENT,U4,Name Four,Art,0\n"
+                  "STUDENT,U1,Duplicate,Math,0\n");
+        writeFile(records,
+                  "REC1,U1,111,2024-01-02,2024-01-16,NOT_RETURNED\n"
+                  "REC2,U2,222,2024-01-03,2024-01-17,NOT_RETURNED\n"
+                  "REC3,U3,333,2024-01-04,2024-01-18,RETURNED,2024-01-20\n"
+                  "REC5,U9,999,2023-12-01,2023-12-15,RETURNED,2023-12-10\n"
+                  "REC6,garbage\n");
+    }
+};
+
+static void loadCSV(Library& lib, const Files& f) {
+    CHECK(lib.loadBooks(f.books));
+    CHECK(lib.loadUsers(f.users));
+    CHECK(lib.loadRecords(f.records, 1));
+}
+
+static std::vector<std::string> isbnsOf(const std::vector<Book>& books, bool sorted) {
+    std::vector<std::string> isbns;
+    for (const auto& b : books)
+        isbns.push_back(b.getISBN());
+    if (sorted)
+        std::sort(isbns.begin(), isbns.end());
+    return isbns;
+}
+
+static std::vector<std::uint64_t> idsOf(const std::vector<BorrowRecord>& records) {
+    std::vector<std::uint64_t> ids;
+    for (const auto& r : records)
+        ids.push_back(r.getRecordID());
+    return ids;
+}
+
+// Everything a caller can ask, compared between the two libraries
+static void checkSame(Library& a, Library& b, const Files& f) {
+    const DayNumber asOf = daysFromCivil(2024, 3, 1);
+    CHECK(a.getTotalBooks() == b.getTotalBooks());
+    CHECK(a.getTotalUsers() == b.getTotalUsers());
+    CHECK(a.getBorrowedCount() == b.getBorrowedCount());
+
+    LibraryStats sa = a.getStats(), sb = b.getStats();
+    CHECK(sa.openLoans == sb.openLoans);
+    CHECK(sa.copiesOut == sb.copiesOut);
+    CHECK(sa.usersWithFees == sb.usersWithFees);
+    CHECK(sa.totalFeesDue == sb.totalFeesDue);
+
+    for (const char* isbn : { "111", "222", "333", "444", "555", "999" })
+        CHECK(a.getAvailableCopies(isbn) == b.getAvailableCopies(isbn));
+    for (const char* id : { "U1", "U2", "U3", "U4", "U5", "U9" }) {
+        std::optional<UserVariant> ua = a.searchUser(id), ub = b.searchUser(id);
+        CHECK(ua.has_value() == ub.has_value());
+        if (ua && ub) {
+            CHECK(userOf(*ua).getName() == userOf(*ub).getName());
+            CHECK(userOf(*ua).getFeesDue() == userOf(*ub).getFeesDue());
+            CHECK(ua->index() == ub->index());
+        }
+        CHECK(idsOf(a.getOpenLoans(id)) == idsOf(b.getOpenLoans(id)));
+    }
+
+    // Keyword results come in slot order, which a snapshot renumbers
+    for (const char* query : { "sea", "stars sea", "ann", "garden", "nothing" })
+        CHECK(isbnsOf(a.searchBooksByKeywords(query), true) == isbnsOf(b.searchBooksByKeywords(query), true));
+    for (const char* prefix : { "s", "sea", "the s", "ann", "w", "z" })
+        CHECK(isbnsOf(a.autocompleteBooks(prefix, 10), false) == isbnsOf(b.autocompleteBooks(prefix, 10), false));
+
+    CHECK(idsOf(a.getOverdueLoans(asOf)) == idsOf(b.getOverdueLoans(asOf)));
+    CHECK(idsOf(a.getLoansDueWithin(daysFromCivil(2024, 1, 1), 60)) == idsOf(b.getLoansDueWithin(daysFromCivil(2024, 1, 1), 60)));
+    CHECK(a.projectLateFees(asOf, 0.25) == b.projectLateFees(asOf, 0.25));
+
+    for (LoanGroupBy by : { LoanGroupBy::BORROW_MONTH, LoanGroupBy::USER_TYPE, LoanGroupBy::USER, LoanGroupBy::ISBN }) {
+        std::vector<LoanGroup> ga = a.loanReport(by, LoanMeasure::DAYS_OUT), gb = b.loanReport(by, LoanMeasure::DAYS_OUT);
+        CHECK(ga.size() == gb.size());
+        for (std::size_t i = 0; i < ga.size() && i < gb.size(); ++i)
+            CHECK(ga[i].key == gb[i].key && ga[i].count == gb[i].count && ga[i].sum == gb[i].sum);
+    }
+
+    // Both write the same CSV files
+    std::string prefix = f.dir.file("compare-");
+    CHECK(a.saveBooks(prefix + "a-books.csv") && b.saveBooks(prefix + "b-books.csv"));
+    CHECK(a.saveUsers(prefix + "a-users.csv") && b.saveUsers(prefix + "b-users.csv"));
+    CHECK(a.saveRecords(prefix + "a-records.csv") && b.saveRecords(prefix + "b-records.csv"));
+    CHECK(readLines(prefix + "a-books.csv") == readLines(prefix + "b-books.csv"));
+    CHECK(readLines(prefix + "a-users.csv") == readLines(prefix + "b-users.csv"));
+    CHECK(readLines(prefix + "a-records.csv") == readLines(prefix + "b-records.csv"));
+}
+
+// Changes that leave holes and reused slots behind, so saved slots aren't in iteration order
+static void churn(Library& lib) {
+    CHECK(lib.removeBook("333"));
+    CHECK(lib.addBook(Book("555", "Silent Stars", "Eve Fox", 2020, 2)));
+    CHECK(lib.removeUser("U4"));
+    CHECK(lib.addUser(std::make_unique<Teacher>("U5", "Name Five", "History")));
+    CHECK(lib.borrowBook("U5", "555", 2024, 2, 1, 2024, 2, 10));
+    CHECK(lib.returnBook(std::uint64_t(2), 2024, 1, 27, 0.5));
+}
+
+// Further changes made the same way to both libraries
+static void moreChanges(Library& lib) {
+    CHECK(lib.addBook(Book("666", "Sea Garden", "Ann Lee", 2021, 1)));
+    CHECK(lib.removeBook("444"));
+    CHECK(lib.borrowBook("U2", "666", 2024, 2, 5, 2024, 2, 19));
+    CHECK(lib.returnBook(std::uint64_t(1), 2024, 2, 20, 0.5));
+    CHECK(lib.addUser(std::make_unique<Student>("U6", "Name Six", "Math")));
+}
+
+static void testRoundTrip() {
+    Files f;
+    Library original;
+    loadCSV(original, f);
+    churn(original);
+    CHECK(original.saveSnapshot(f.snap));
+
+    Library loaded;
+    CHECK(loaded.loadSnapshot(f.snap));
+    checkSame(original, loaded, f);
+
+    moreChanges(original);
+    moreChanges(loaded);
+    checkSame(original, loaded, f);
+
+    // New records continue the same numbering
+    std::vector<std::uint64_t> a, b;
+    original.borrowMany({ BorrowRequest{ "U6", "555", 2024, 3, 1, 2024, 3, 15 } }, &a);
+    loaded.borrowMany({ BorrowRequest{ "U6", "555", 2024, 3, 1, 2024, 3, 15 } }, &b);
+    CHECK(a == b && a.size() == 1 && a[0] != 0);
+}
+
+// Any truncation, a trailing byte or a wrong header is refused, and the
+// Library can still load the CSV files afterwards
+static void testRejectsDamaged() {
+    Files f;
+    Library original;
+    loadCSV(original, f);
+    CHECK(original.saveSnapshot(f.snap));
+    const std::string bytes = readFile(f.snap);
+    const std::string damaged = f.dir.file("damaged.snap");
+
+    for (std::size_t len = 0; len < bytes.size(); ++len) {
+        writeFile(damaged, bytes.substr(0, len));
+        Library lib;
+        CHECK(!lib.loadSnapshot(damaged));
+    }
+
+    std::vector<std::string> bad = { bytes + "x", bytes, bytes };
+    bad[1][0] = 'X';  // magic
+    bad[2][8] ^= 1;   // version
+    for (const auto& b : bad) {
+        writeFile(damaged, b);
+        Library lib;
+        CHECK(!lib.loadSnapshot(damaged));
+        loadCSV(lib, f);
+        CHECK(lib.getTotalBooks() == 4);
+        CHECK(lib.getBorrowedCount() == 2);
+    }
+
+    Library missing;
+    CHECK(!missing.loadSnapshot(f.dir.file("missing.snap")));
+}
+
+static void testNeedsFreshLibrary() {
+    Files f;
+    Library original;
+    loadCSV(original, f);
+    CHECK(original.saveSnapshot(f.snap));
+
+    Library lib;
+    CHECK(lib.loadBooks(f.books));
+    CHECK(!lib.loadSnapshot(f.snap));
+    CHECK(lib.getTotalBooks() == 4);
+    CHECK(lib.getTotalUsers() == 0);
+}
+
+// main's startup: snapshot, markSavedTo, then the journal replayed on top
+static void testJournalAfterSnapshot() {
+    Files f;
+    Library lib;
+    loadCSV(lib, f);
+    Journal journal;
+    CHECK(journal.open(f.wal, 1));
+    lib.attachJournal(&journal);
+    CHECK(lib.borrowBook("U4", "444", 2024, 2, 1, 2024, 2, 15));
+
+    // Checkpoint as saveAll does it
+    CHECK(lib.saveBooks(f.books) && lib.saveUsers(f.users) && lib.saveRecords(f.records));
+    CHECK(lib.saveSnapshot(f.snap));
+    CHECK(journal.clear());
+    std::vector<std::string> savedRecords = readLines(f.records);
+
+    // Logged but never saved
+    CHECK(lib.returnBook(std::uint64_t(1), 2024, 1, 20, 0.5));
+    CHECK(lib.addBook(Book("555", "Silent Stars", "Eve Fox", 2020, 2)));
+    CHECK(lib.borrowBook("U3", "555", 2024, 2, 2, 2024, 2, 16));
+
+    Library restarted;
+    CHECK(restarted.loadSnapshot(f.snap));
+    restarted.markSavedTo(f.books, f.users, f.records);
+    CHECK(!restarted.hasUnsavedChanges());
+    CHECK(restarted.replayJournal(f.wal));
+    CHECK(restarted.getAvailableCopies("111") == 3);
+    CHECK(restarted.getAvailableCopies("555") == 1);
+    CHECK(restarted.searchUser("U1") && userOf(*restarted.searchUser("U1")).getFeesDue() == 3.5);
+    CHECK(restarted.autocompleteBooks("silent", 5).size() == 1);
+    CHECK(restarted.getOpenLoans("U3").size() == 1);
+
+    // The files are taken as saved, the save adds the one new row
+    CHECK(restarted.saveRecords(f.records));
+    std::vector<std::string> lines = readLines(f.records);
+    CHECK(lines.size() == savedRecords.size() + 1);
+    checkSame(lib, restarted, f);
+}
+
+int main() {
+    testRoundTrip();
+    testRejectsDamaged();
+    testNeedsFreshLibrary();
+    testJournalAfterSnapshot();
+    return testResult("test_snapshot");
+}
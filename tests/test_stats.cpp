@@ -0,0 +1,168 @@
+#include "TestSupport.h"
+#include "Library.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+/*
+ * test_stats.cpp
+ * The running LibraryStats and the due-date index after bulk and single
+ * borrows, returns and removals, checked against a full rescan: copies from
+ * every book, fees from every user, open and overdue loans from the saved
+ * records.csv.
+ */
+
+static const int BOOKS = 30;
+static const int USERS = 20;
+
+static std::string isbnOf(int i) { return "978" + std::to_string(i); }
+static std::string userIDOf(int i) { return "U" + std::to_string(i); }
+
+// One row of records.csv: REC<id>,user,isbn,borrowed,due,returned
+struct SavedRecord {
+    std::string id;
+    DayNumber due = 0;
+    bool open = false;
+};
+
+static std::vector<SavedRecord> savedRecords(Library& lib, const TempDir& dir) {
+    const std::string file = dir.file("records.csv");
+    CHECK(lib.saveRecords(file));
+
+    std::vector<SavedRecord> rows;
+    for (const auto& line : readLines(file)) {
+        if (line.empty())
+            continue;
+        SavedRecord r;
+        std::vector<std::string> fields;
+        std::size_t start = 0;
+        for (std::size_t comma; (comma = line.find(',', start)) != std::string::npos; start = comma + 1)
+            fields.push_back(line.substr(start, comma - start));
+        r.id = fields[0];
+        int y, m, d;
+        CHECK(std::sscanf(fields[4].c_str(), "%d-%d-%d", &y, &m, &d) == 3);
+        r.due = daysFromCivil(y, m, d);
+        r.open = line.compare(line.size() - 12, 12, "NOT_RETURNED") == 0;
+        rows.push_back(r);
+    }
+    return rows;
+}
+
+static void checkAgainstRescan(Library& lib, const TempDir& dir) {
+    LibraryStats expected;
+    for (int i = 0; i < BOOKS; i++) {
+        if (auto b = lib.searchBook(isbnOf(i)))
+            expected.copiesOut += static_cast<long>(b->getCopiesTotal()) - static_cast<long>(b->getCopiesAvailable());
+    }
+    for (int i = 0; i < USERS; i++) {
+        if (auto u = lib.searchUser(userIDOf(i))) {
+            double fees = userOf(*u).getFeesDue();
+            if (fees > 0) {
+                expected.usersWithFees++;
+                expected.totalFeesDue += fees;
+            }
+        }
+    }
+    std::vector<SavedRecord> rows = savedRecords(lib, dir);
+    for (const auto& r : rows)
+        expected.openLoans += r.open ? 1 : 0;
+
+    LibraryStats stats = lib.getStats();
+    CHECK(stats.openLoans == expected.openLoans);
+    CHECK(stats.copiesOut == expected.copiesOut);
+    CHECK(stats.usersWithFees == expected.usersWithFees);
+    // Fees are multiples of 0.25, so the sums are exact
+    CHECK(stats.totalFeesDue == expected.totalFeesDue);
+    CHECK(lib.getBorrowedCount() == expected.openLoans);
+
+    // Overdue lists, earliest due date first, ties by record ID
+    for (DayNumber asOf = daysFromCivil(2024, 1, 25); asOf <= daysFromCivil(2024, 4, 1); asOf += 6) {
+        std::vector<std::pair<DayNumber, std::uint64_t>> scan;
+        for (const auto& r : rows) {
+            std::uint64_t id;
+            if (r.open && r.due < asOf && BorrowRecord::parseRecordID(r.id, id))
+                scan.emplace_back(r.due, id);
+        }
+        std::sort(scan.begin(), scan.end());
+
+        std::vector<std::pair<DayNumber, std::uint64_t>> indexed;
+        for (const auto& rec : lib.getOverdueLoans(asOf))
+            indexed.emplace_back(rec.getDueDay(), rec.getRecordID());
+        CHECK(indexed == scan);
+    }
+}
+
+int main() {
+    TempDir dir;
+    Library lib;
+    std::mt19937 rng(15);
+
+    // Bulk adds, with a duplicate inside the batch and some users owing fees already
+    std::vector<Book> books;
+    for (int i = 0; i < BOOKS; i++)
+        books.emplace_back(isbnOf(i), "Title " + std::to_string(i), "Author", 2000, 1 + i % 3);
+    books.emplace_back(isbnOf(0), "Duplicate", "Author", 2000, 5);
+    std::vector<ChangeStatus> added = lib.addBooks(std::move(books));
+    CHECK(added.back() == ChangeStatus::DUPLICATE);
+
+    std::vector<std::unique_ptr<User>> users;
+    for (int i = 0; i < USERS; i++) {
+        users.push_back(std::make_unique<Student>(userIDOf(i), "Name", "Major"));
+        if (i % 5 == 0)
+            users.back()->addFees(1.25);
+    }
+    lib.addUsers(std::move(users));
+    checkAgainstRescan(lib, dir);
+
+    // Bulk borrows, some for books that are out or don't exist
+    std::vector<BorrowRequest> borrows;
+    for (int i = 0; i < 80; i++) {
+        int day = 1 + static_cast<int>(rng() % 28);
+        borrows.push_back({ userIDOf(rng() % USERS), isbnOf(rng() % (BOOKS + 2)), 2024, 1, day, 2024, 2, day });
+    }
+    std::vector<std::uint64_t> ids;
+    lib.borrowMany(borrows, &ids);
+    checkAgainstRescan(lib, dir);
+
+    // Bulk returns of every other loan, early and late, plus a repeat and an unknown ID
+    std::vector<ReturnRequest> returns;
+    for (std::size_t i = 0; i < ids.size(); i += 2) {
+        if (ids[i] != 0)
+            returns.push_back({ ids[i], 2024, 2, 1 + static_cast<int>(rng() % 29), 0.25 });
+    }
+    returns.push_back(returns.front());
+    returns.push_back({ 999999, 2024, 2, 1, 0.25 });
+    std::vector<ChangeStatus> returned = lib.returnMany(returns);
+    CHECK(returned[returned.size() - 2] == ChangeStatus::ALREADY_RETURNED);
+    CHECK(returned.back() == ChangeStatus::UNKNOWN_RECORD);
+    checkAgainstRescan(lib, dir);
+
+    // Single calls
+    for (int i = 0; i < 10; i++)
+        lib.borrowBook(userIDOf(i), isbnOf(i), 2024, 3, 1, 2024, 3, 15);
+    for (std::size_t i = 1; i < ids.size(); i += 4) {
+        if (ids[i] != 0)
+            lib.returnBook(ids[i], 2024, 3, 20, 0.5);
+    }
+    checkAgainstRescan(lib, dir);
+
+    // Removing books takes their copies out of the totals, removing users their fees
+    for (int i = 0; i < BOOKS; i += 7)
+        CHECK(lib.removeBook(isbnOf(i)));
+    for (int i = 0; i < USERS; i++) {
+        if (!lib.hasOpenLoans(userIDOf(i)))
+            CHECK(lib.removeUser(userIDOf(i)));
+        else
+            CHECK(!lib.removeUser(userIDOf(i)));
+    }
+    checkAgainstRescan(lib, dir);
+
+    // Loans of removed books can still come back
+    for (std::size_t i = 3; i < ids.size(); i += 4) {
+        if (ids[i] != 0)
+            lib.returnBook(ids[i], 2024, 4, 1, 0.25);
+    }
+    checkAgainstRescan(lib, dir);
+
+    return testResult("test_stats");
+}
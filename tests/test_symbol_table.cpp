@@ -0,0 +1,85 @@
+#include "TestSupport.h"
+#include "Library.h"
+#include "SymbolTable.h"
+#include <thread>
+
+/*
+ * test_symbol_table.cpp
+ * Interned text stays put while the table grows, interning is safe from
+ * several threads, and two libraries don't share their symbols.
+ */
+
+// Views taken early must still read the same text after many more inserts
+static void testNamesStayValid() {
+    SymbolTable table;
+    std::uint32_t first = table.intern("U1");
+    std::string_view early = table.name(first);
+
+    for (int i = 0; i < 100000; i++)
+        table.intern("ID" + std::to_string(i));
+    CHECK(table.size() == 100001);
+    CHECK(early == "U1" && early.data() == table.name(first).data());
+    CHECK(table.intern("U1") == first);
+    CHECK(table.find("ID99999") == 100000);
+    CHECK(table.name(100000) == "ID99999");
+    CHECK(table.find("missing") == SymbolTable::NONE);
+
+    std::string_view batch[3] = { "ID5", "new", "new" };
+    std::uint32_t ids[3];
+    table.internMany(batch, 3, ids);
+    CHECK(ids[0] == 6 && ids[1] == 100001 && ids[2] == 100001);
+}
+
+// Threads interning overlapping sets agree on every id
+static void testConcurrentIntern() {
+    SymbolTable table;
+    constexpr int THREADS = 8, PER_THREAD = 20000;
+    std::vector<std::vector<std::uint32_t>> seen(THREADS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < PER_THREAD; i++) {
+                // Half the keys are shared by all threads, half are the thread's own
+                std::string key = i % 2 ? "T" + std::to_string(t) + "-" + std::to_string(i) : "S" + std::to_string(i);
+                seen[t].push_back(table.intern(key));
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+
+    CHECK(table.size() == PER_THREAD / 2 + THREADS * PER_THREAD / 2);
+    for (int t = 0; t < THREADS; t++) {
+        for (int i = 0; i < PER_THREAD; i += 2) {
+            CHECK(seen[t][i] == seen[0][i]);
+            CHECK(table.name(seen[t][i]) == "S" + std::to_string(i));
+        }
+    }
+}
+
+// Each library interns its records' IDs in its own tables
+static void testLibrariesAreSeparate() {
+    Library a, b;
+    CHECK(a.addBook(Book("111", "Title", "Author", 2000, 5)));
+    CHECK(a.addUser(std::make_unique<Student>("U1", "Name", "Major")));
+    CHECK(a.borrowBook("U1", "111", 2024, 1, 2, 2024, 1, 16));
+
+    CHECK(b.addBook(Book("222", "Title", "Author", 2000, 5)));
+    CHECK(b.addUser(std::make_unique<Student>("U2", "Name", "Major")));
+    CHECK(b.borrowBook("U2", "222", 2024, 1, 2, 2024, 1, 16));
+
+    std::vector<BorrowRecord> loans = b.getOpenLoans("U2");
+    CHECK(loans.size() == 1);
+    CHECK(loans[0].getUserID(b.getRecordSymbols()) == "U2");
+    CHECK(loans[0].getISBN(b.getRecordSymbols()) == "222");
+    CHECK(a.getRecordSymbols().userIDs.find("U2") == SymbolTable::NONE);
+    CHECK(b.getRecordSymbols().userIDs.find("U1") == SymbolTable::NONE);
+}
+
+int main() {
+    testNamesStayValid();
+    testConcurrentIntern();
+    testLibrariesAreSeparate();
+    return testResult("test_symbol_table");
+}
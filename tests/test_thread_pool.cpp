@@ -0,0 +1,31 @@
+#include "TestSupport.h"
+#include "ThreadPool.h"
+#include <atomic>
+
+/*
+ * test_thread_pool.cpp
+ * Every index of a parallelFor runs exactly once, and later loops reuse the
+ * workers started by earlier ones.
+ */
+
+int main() {
+    ThreadPool pool;
+    CHECK(pool.size() == 0);
+
+    for (int round = 0; round < 50; round++) {
+        std::vector<std::atomic<int>> hits(37);
+        pool.parallelFor(hits.size(), [&](std::size_t i) { hits[i]++; });
+        for (auto& h : hits)
+            CHECK(h == 1);
+    }
+    CHECK(pool.size() == 36);
+
+    // Smaller loops don't start or drop workers
+    std::atomic<int> calls{ 0 };
+    pool.parallelFor(4, [&](std::size_t) { calls++; });
+    pool.parallelFor(0, [&](std::size_t) { calls++; });
+    CHECK(calls == 4);
+    CHECK(pool.size() == 36);
+
+    return testResult("test_thread_pool");
+}